@@ -32,6 +32,7 @@ SET(EMBREE_TESTING_INTENSITY 1 CACHE INT "Intensity of testing (0 = no testing,
 SET(EMBREE_TESTING_MEMCHECK OFF CACHE BOOL "Turns on memory checking for some tests.")
 SET(EMBREE_TESTING_BENCHMARK OFF CACHE BOOL "Turns benchmarking on.")
 SET(EMBREE_TESTING_BENCHMARK_DATABASE "${PROJECT_BINARY_DIR}" CACHE PATH "Path to database for benchmarking.")
+SET(EMBREE_TESTING_BENCHMARK_BASELINE "" CACHE FILEPATH "JSON file of the benchmark suite to compare against.")
 SET(EMBREE_TESTING_PACKAGE OFF CACHE BOOL "Packages release as test.")
 SET(EMBREE_TESTING_KLOCWORK OFF CACHE BOOL "Runs Kocwork as test.")
 SET(EMBREE_TESTING_SDE OFF CACHE STRING "Uses SDE to run tests for specified CPU.")
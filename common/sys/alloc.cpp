@@ -18,6 +18,7 @@
 #include "intrinsics.h"
 #include "sysinfo.h"
 #include "mutex.h"
+#include "atomic.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 /// All Platforms
@@ -46,8 +47,37 @@ namespace embree
   }
 
   static bool huge_pages_enabled = false;
+  static bool transparent_huge_pages_enabled = true;
+  static bool prefault_pages_enabled = false;
+  static bool interleave_pages_enabled = false;
+  static bool page_policy_verbose = false;
   static MutexSys os_init_mutex;
 
+  /* counters for pages allocated through os_malloc and for blocks registered through os_register_malloc */
+  static std::atomic<size_t> os_bytes_allocated(0);
+  static std::atomic<size_t> os_bytes_hugetlb(0);
+  static std::atomic<size_t> os_interleave_failures(0);
+
+  void os_set_page_policy(bool transparent_hugepages, bool prefault, bool interleave, bool verbose)
+  {
+    Lock<MutexSys> lock(os_init_mutex);
+    transparent_huge_pages_enabled = transparent_hugepages;
+    prefault_pages_enabled = prefault;
+    interleave_pages_enabled = interleave;
+    page_policy_verbose = verbose;
+  }
+
+  void os_prefault(void* ptr, size_t bytes)
+  {
+    if (!prefault_pages_enabled)
+      return;
+
+    /* touch each page to fault in all pages upfront */
+    volatile char* p = (volatile char*) ptr;
+    for (size_t i=0; i<bytes; i+=PAGE_SIZE_4K)
+      p[i] = p[i];
+  }
+
   __forceinline bool isHugePageCandidate(const size_t bytes) 
   {
     if (!huge_pages_enabled)
@@ -134,6 +164,8 @@ namespace embree
       char* ptr = (char*) VirtualAlloc(nullptr,bytes,flags,PAGE_READWRITE);
       if (ptr != nullptr) {
         hugepages = true;
+        os_bytes_allocated += bytes;
+        os_bytes_hugetlb += bytes;
         return ptr;
       }
     } 
@@ -143,6 +175,7 @@ namespace embree
     char* ptr = (char*) VirtualAlloc(nullptr,bytes,flags,PAGE_READWRITE);
     if (ptr == nullptr) throw std::bad_alloc();
     hugepages = false;
+    os_bytes_allocated += bytes;
     return ptr;
   }
 
@@ -160,6 +193,7 @@ namespace embree
     if (!VirtualFree((char*)ptr+bytesNew,bytesOld-bytesNew,MEM_DECOMMIT))
       throw std::bad_alloc();
 
+    os_bytes_allocated -= bytesOld-bytesNew;
     return bytesNew;
   }
 
@@ -170,11 +204,32 @@ namespace embree
 
     if (!VirtualFree(ptr,0,MEM_RELEASE))
       throw std::bad_alloc();
+
+    os_bytes_allocated -= bytes;
+    if (hugepages) os_bytes_hugetlb -= bytes;
   }
 
   void os_advise(void *ptr, size_t bytes)
   {
   }
+
+  void os_register_malloc(void* ptr, size_t bytes) {
+    os_bytes_allocated += bytes;
+  }
+
+  void os_unregister_malloc(void* ptr, size_t bytes) {
+    os_bytes_allocated -= bytes;
+  }
+
+  OSPageStatistics os_page_statistics()
+  {
+    OSPageStatistics stat;
+    stat.bytesAllocated = os_bytes_allocated;
+    stat.bytesHugeTLB = os_bytes_hugetlb;
+    stat.bytesTransparentHugePages = 0;
+    stat.numInterleaveFailures = os_interleave_failures;
+    return stat;
+  }
 }
 
 #endif
@@ -195,8 +250,89 @@ namespace embree
 #include <mach/vm_statistics.h>
 #endif
 
+#if defined(__LINUX__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#endif
+
 namespace embree
 {
+#if defined(__LINUX__)
+
+  /* os_malloc allocations on 4k pages, used to find their transparent huge pages */
+  static MutexSys os_ranges_mutex;
+  static std::map<size_t,size_t> os_ranges;
+
+  static void os_add_range(void* ptr, size_t bytes)
+  {
+    Lock<MutexSys> lock(os_ranges_mutex);
+    os_ranges[(size_t)ptr] = bytes;
+  }
+
+  static void os_remove_range(void* ptr)
+  {
+    Lock<MutexSys> lock(os_ranges_mutex);
+    os_ranges.erase((size_t)ptr);
+  }
+
+  static void os_shrink_range(void* ptr, size_t bytes)
+  {
+    Lock<MutexSys> lock(os_ranges_mutex);
+    auto i = os_ranges.find((size_t)ptr);
+    if (i != os_ranges.end()) i->second = bytes;
+  }
+
+  /* mask of the online NUMA nodes, parsed from a list like "0-3,6" */
+  static const std::vector<unsigned long>& os_node_mask()
+  {
+    static const std::vector<unsigned long> mask = [] {
+      std::vector<unsigned long> mask;
+      std::ifstream file("/sys/devices/system/node/online");
+      std::string list;
+      if (!getline(file,list)) return mask;
+      const size_t bits = 8*sizeof(unsigned long);
+      for (const char* s = list.c_str(); *s; )
+      {
+        char* end = nullptr;
+        const size_t first = strtoul(s,&end,10); if (end == s) break; s = end;
+        size_t last = first;
+        if (*s == '-') { last = strtoul(s+1,&end,10); s = end; }
+        if (*s == ',') s++;
+        if (last/bits >= mask.size()) mask.resize(last/bits+1,0);
+        for (size_t n=first; n<=last; n++) mask[n/bits] |= 1ul << (n%bits);
+      }
+      return mask;
+    }();
+    return mask;
+  }
+
+  /* interleaves the full pages of some range over all NUMA nodes */
+  static void os_interleave(void* ptr, size_t bytes)
+  {
+    const size_t begin = ((size_t)ptr+PAGE_SIZE_4K-1) & ~size_t(PAGE_SIZE_4K-1);
+    const size_t end   = ((size_t)ptr+bytes) & ~size_t(PAGE_SIZE_4K-1);
+    if (begin >= end) return;
+
+    const std::vector<unsigned long>& mask = os_node_mask();
+    int error = ENOSYS;
+#if defined(SYS_mbind)
+    const int MPOL_INTERLEAVE_ = 3;
+    if (mask.empty()) error = ENODEV;
+    else if (syscall(SYS_mbind,(void*)begin,end-begin,MPOL_INTERLEAVE_,mask.data(),8*sizeof(unsigned long)*mask.size()+1,0) == 0) return;
+    else error = errno;
+#endif
+
+    /* count failures, e.g. for kernels without NUMA support, and report the first one */
+    if (os_interleave_failures++ == 0 && page_policy_verbose)
+      std::cout << "WARNING: interleaving pages over NUMA nodes failed: " << strerror(error) << std::endl;
+  }
+
+#endif
+
   bool os_init(bool hugepages, bool verbose) 
   {
     Lock<MutexSys> lock(os_init_mutex);
@@ -266,6 +402,9 @@ namespace embree
       void* ptr = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
       if (ptr != MAP_FAILED) {
         hugepages = true;
+        if (interleave_pages_enabled) os_interleave(ptr,bytes);
+        os_bytes_allocated += (bytes+PAGE_SIZE_2M-1) & ~(PAGE_SIZE_2M-1);
+        os_bytes_hugetlb += (bytes+PAGE_SIZE_2M-1) & ~(PAGE_SIZE_2M-1);
         return ptr;
       }
 #endif
@@ -275,6 +414,12 @@ namespace embree
     void* ptr = (char*) mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
     if (ptr == MAP_FAILED) throw std::bad_alloc();
     hugepages = false;
+    os_bytes_allocated += (bytes+PAGE_SIZE_4K-1) & ~(PAGE_SIZE_4K-1);
+
+#if defined(__LINUX__)
+    if (interleave_pages_enabled) os_interleave(ptr,bytes);
+    os_add_range(ptr,bytes);
+#endif
 
     /* advise huge page hint for THP */
     os_advise(ptr,bytes);
@@ -292,6 +437,11 @@ namespace embree
     if (munmap((char*)ptr+bytesNew,bytesOld-bytesNew) == -1)
       throw std::bad_alloc();
 
+    os_bytes_allocated -= bytesOld-bytesNew;
+    if (hugepages) os_bytes_hugetlb -= bytesOld-bytesNew;
+#if defined(__LINUX__)
+    else os_shrink_range(ptr,bytesNew);
+#endif
     return bytesNew;
   }
 
@@ -305,15 +455,90 @@ namespace embree
     bytes = (bytes+pageSize-1) & ~(pageSize-1);
     if (munmap(ptr,bytes) == -1)
       throw std::bad_alloc();
+
+    os_bytes_allocated -= bytes;
+    if (hugepages) os_bytes_hugetlb -= bytes;
+#if defined(__LINUX__)
+    else os_remove_range(ptr);
+#endif
   }
 
   /* hint for transparent huge pages (THP) */
   void os_advise(void* pptr, size_t bytes)
   {
+    if (!transparent_huge_pages_enabled)
+      return;
+
 #if defined(MADV_HUGEPAGE)
     madvise(pptr,bytes,MADV_HUGEPAGE); 
 #endif
   }
+
+  void os_register_malloc(void* ptr, size_t bytes)
+  {
+    os_bytes_allocated += bytes;
+#if defined(__LINUX__)
+    if (interleave_pages_enabled) os_interleave(ptr,bytes);
+    os_add_range(ptr,bytes);
+#endif
+  }
+
+  void os_unregister_malloc(void* ptr, size_t bytes)
+  {
+    os_bytes_allocated -= bytes;
+#if defined(__LINUX__)
+    os_remove_range(ptr);
+#endif
+  }
+
+  OSPageStatistics os_page_statistics()
+  {
+    OSPageStatistics stat;
+    stat.bytesAllocated = os_bytes_allocated;
+    stat.bytesHugeTLB = os_bytes_hugetlb;
+    stat.bytesTransparentHugePages = 0;
+    stat.numInterleaveFailures = os_interleave_failures;
+
+#if defined(__LINUX__)
+
+    /* attribute the transparent huge pages of each memory mapping to
+     * the os_malloc ranges proportional to their overlap */
+    std::ifstream file;
+    file.open("/proc/self/smaps",std::ios::in);
+    if (!file.is_open())
+      return stat;
+
+    Lock<MutexSys> lock(os_ranges_mutex);
+    double bytesTHP = 0.0;
+    size_t begin = 0, end = 0;
+    std::string line;
+    while (getline(file,line))
+    {
+      unsigned long long b = 0, e = 0;
+      if (sscanf(line.c_str(),"%llx-%llx",&b,&e) == 2) {
+        begin = b; end = e;
+        continue;
+      }
+      if (line.compare(0,14,"AnonHugePages:") != 0 || end <= begin)
+        continue;
+
+      const size_t huge = 1024*std::stoull(line.substr(14));
+      if (huge == 0) continue;
+
+      size_t overlap = 0;
+      auto i = os_ranges.upper_bound(begin);
+      if (i != os_ranges.begin()) --i;
+      for (; i != os_ranges.end() && i->first < end; ++i) {
+        const size_t lower = std::max(begin,i->first);
+        const size_t upper = std::min(end,i->first+i->second);
+        if (lower < upper) overlap += upper-lower;
+      }
+      bytesTHP += double(huge)*double(overlap)/double(end-begin);
+    }
+    stat.bytesTransparentHugePages = size_t(bytesTHP);
+#endif
+    return stat;
+  }
 }
 
 #endif
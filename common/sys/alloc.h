@@ -69,10 +69,26 @@ namespace embree
   /*! allocates pages directly from OS */
   bool win_enable_selockmemoryprivilege(bool verbose);
   bool os_init(bool hugepages, bool verbose);
+  void os_set_page_policy(bool transparent_hugepages, bool prefault, bool interleave, bool verbose);
   void* os_malloc (size_t bytes, bool& hugepages);
   size_t os_shrink (void* ptr, size_t bytesNew, size_t bytesOld, bool hugepages);
   void  os_free   (void* ptr, size_t bytes, bool hugepages);
   void  os_advise (void* ptr, size_t bytes);
+  void  os_prefault (void* ptr, size_t bytes);
+
+  /*! counts memory allocated with alignedMalloc in the page statistics and applies the page policy to it */
+  void os_register_malloc (void* ptr, size_t bytes);
+  void os_unregister_malloc (void* ptr, size_t bytes);
+
+  /*! statistics about the pages allocated through os_malloc and registered through os_register_malloc */
+  struct OSPageStatistics
+  {
+    size_t bytesAllocated;              //!< number of bytes currently allocated
+    size_t bytesHugeTLB;                //!< number of bytes allocated on explicit huge pages
+    size_t bytesTransparentHugePages;   //!< number of bytes backed by transparent huge pages
+    size_t numInterleaveFailures;       //!< number of ranges whose pages could not get interleaved over the NUMA nodes
+  };
+  OSPageStatistics os_page_statistics();
 
   /*! allocator that performs OS allocations */
   template<typename T>
@@ -414,6 +414,10 @@ namespace embree
     GetProcessMemoryInfo( GetCurrentProcess( ), &info, sizeof(info) );
     return (size_t)info.WorkingSetSize;
   }
+
+  unsigned int getCPUDomain() {
+    return 0;
+  }
 }
 #endif
 
@@ -425,6 +429,7 @@ namespace embree
 
 #include <stdio.h>
 #include <unistd.h>
+#include <sched.h>
 
 namespace embree
 {
@@ -453,6 +458,30 @@ namespace embree
     buffer >> virt >> resident >> shared;
     return resident*sysconf(_SC_PAGE_SIZE);
   }
+
+  /* threads sharing the L3 cache form one domain, identified by the first thread of the shared list */
+  static std::vector<unsigned int> parseCPUDomains()
+  {
+    std::vector<unsigned int> domains(getNumberOfLogicalThreads(),0);
+    for (size_t cpuID=0; cpuID<domains.size(); cpuID++)
+    {
+      const std::string cpu = "/sys/devices/system/cpu/cpu" + toString(cpuID);
+      std::ifstream cache(cpu + "/cache/index3/shared_cpu_list");
+      if (cache >> domains[cpuID]) continue;
+      std::ifstream package(cpu + "/topology/physical_package_id");
+      if (package >> domains[cpuID]) continue;
+      domains[cpuID] = 0;
+    }
+    return domains;
+  }
+
+  unsigned int getCPUDomain()
+  {
+    static const std::vector<unsigned int> domains = parseCPUDomains();
+    const int cpuID = sched_getcpu();
+    if (cpuID < 0 || size_t(cpuID) >= domains.size()) return 0;
+    return domains[cpuID];
+  }
 }
 
 #endif
@@ -485,6 +514,10 @@ namespace embree
   size_t getResidentMemoryBytes() {
     return 0;
   }
+
+  unsigned int getCPUDomain() {
+    return 0;
+  }
 }
 
 #endif
@@ -515,6 +548,10 @@ namespace embree
   size_t getResidentMemoryBytes() {
     return 0;
   }
+
+  unsigned int getCPUDomain() {
+    return 0;
+  }
 }
 
 #endif
@@ -160,6 +160,9 @@ namespace embree
 
   /*! return the number of logical threads of the system */
   unsigned int getNumberOfLogicalThreads();
+
+  /*! returns an ID of the last level cache (or socket) shared by the logical thread the caller currently runs on */
+  unsigned int getCPUDomain();
   
   /*! returns the size of the terminal window in characters */
   int getTerminalWidth();
@@ -88,20 +88,20 @@ namespace embree
   bool TaskScheduler::TaskQueue::execute_local_internal(Thread& thread, Task* parent)
   {
     /* stop if we run out of local tasks or reach the waiting task */
-    if (right == 0 || &tasks[right-1] == parent)
+    if (right == 0 || &task(right-1) == parent)
       return false;
 
     /* execute task */
     size_t oldRight = right;
-    tasks[right-1].run_internal(thread);
+    task(right-1).run_internal(thread);
     if (right != oldRight) {
       THROW_RUNTIME_ERROR("you have to wait for spawned subtasks");
     }
 
     /* pop task and closure from stack */
     right--;
-    if (tasks[right].stackPtr != size_t(-1))
-      stackPtr = tasks[right].stackPtr;
+    if (task(right).stackPtr != size_t(-1))
+      stackPtr = task(right).stackPtr;
 
     /* also move left pointer */
     if (left >= right) left.store(right.load());
@@ -126,7 +126,7 @@ namespace embree
     else
       return false;
 
-    if (!tasks[l].try_steal(thread.tasks.tasks[thread.tasks.right]))
+    if (!task(l).try_steal(thread.tasks.allocTask(thread.tasks.right)))
       return false;
 
     thread.tasks.right++;
@@ -137,9 +137,66 @@ namespace embree
   size_t TaskScheduler::TaskQueue::getTaskSizeAtLeft()
   {
     if (left >= right) return 0;
-    return tasks[left].N;
+    return task(left).N;
   }
 
+  dll_export TaskScheduler::TaskQueue::~TaskQueue()
+  {
+    for (size_t k=1; k<MAX_STACK_SEGMENTS; k++)
+    {
+      if (taskSegments[k]) alignedFree(taskSegments[k]);
+      if (stackSegments[k]) alignedFree(stackSegments[k]);
+    }
+  }
+
+  dll_export TaskScheduler::Task& TaskScheduler::TaskQueue::allocTaskSegment(size_t index)
+  {
+    const size_t k = segment(index,TASK_STACK_SIZE);
+    if (k >= MAX_STACK_SEGMENTS)
+      throw std::runtime_error("task stack overflow");
+
+    /* segments are published to stealing threads through the increment of right */
+    if (taskSegments[k] == nullptr)
+    {
+      const size_t N = segmentBegin(k,TASK_STACK_SIZE);
+      Task* segmentTasks = (Task*) alignedMalloc(N*sizeof(Task),64);
+      for (size_t i=0; i<N; i++) new (&segmentTasks[i]) Task;
+      taskSegments[k] = segmentTasks;
+    }
+    return taskSegments[k][index-segmentBegin(k,TASK_STACK_SIZE)];
+  }
+
+  dll_export void* TaskScheduler::TaskQueue::allocStackSegment(size_t bytes, size_t align)
+  {
+    /* skip to the next segment when the closure does not fit into the current one */
+    while (true)
+    {
+      const size_t k = segment(stackPtr,CLOSURE_STACK_SIZE);
+      if (k >= MAX_STACK_SEGMENTS)
+        throw std::runtime_error("closure stack overflow");
+
+      const size_t begin = segmentBegin(k,CLOSURE_STACK_SIZE);
+      const size_t end = k == 0 ? CLOSURE_STACK_SIZE : 2*begin;
+      const size_t ofs = bytes + ((align - stackPtr) & (align-1));
+      if (stackPtr + ofs > end) {
+        stackPtr = end;
+        continue;
+      }
+
+      if (k == 0) {
+        stackPtr += ofs;
+        return &stack[stackPtr-bytes];
+      }
+      if (stackSegments[k] == nullptr)
+        stackSegments[k] = (char*) alignedMalloc(end-begin,64);
+      stackPtr += ofs;
+      return &stackSegments[k][stackPtr-bytes-begin];
+    }
+  }
+
+  /* cache domain of the calling worker thread, only known for threads pinned to a logical thread */
+  static __thread int thread_domain = -1;
+
   void threadPoolFunction(std::pair<TaskScheduler::ThreadPool*,size_t>* pair)
   {
     TaskScheduler::ThreadPool* pool = pair->first;
@@ -148,8 +205,8 @@ namespace embree
     pool->thread_loop(threadIndex);
   }
 
-  TaskScheduler::ThreadPool::ThreadPool(bool set_affinity)
-    : numThreads(0), numThreadsRunning(0), set_affinity(set_affinity), running(false) {}
+  TaskScheduler::ThreadPool::ThreadPool(bool set_affinity, size_t firstThread)
+    : numThreads(0), numThreadsRunning(0), set_affinity(set_affinity), firstThread(firstThread), running(false) {}
 
   dll_export void TaskScheduler::ThreadPool::startThreads()
   {
@@ -178,7 +235,8 @@ namespace embree
     {
       if (t == 0) continue;
       auto pair = new std::pair<TaskScheduler::ThreadPool*,size_t>(this,t);
-      threads.push_back(createThread((thread_func)threadPoolFunction,pair,4*1024*1024,set_affinity ? t : -1));
+      const ssize_t affinity = set_affinity ? ssize_t((firstThread+t) % getNumberOfLogicalThreads()) : -1;
+      threads.push_back(createThread((thread_func)threadPoolFunction,pair,4*1024*1024,affinity));
     }
 
     /* stop some threads if we reduce the number of threads */
@@ -223,6 +281,8 @@ namespace embree
 
   void TaskScheduler::ThreadPool::thread_loop(size_t globalThreadIndex)
   {
+    if (set_affinity) thread_domain = (int) getCPUDomain();
+
     while (globalThreadIndex < numThreadsRunning)
     {
       Ref<TaskScheduler> scheduler = NULL;
@@ -238,8 +298,8 @@ namespace embree
     }
   }
 
-  TaskScheduler::TaskScheduler()
-    : threadCounter(0), anyTasksRunning(0), hasRootTask(false)
+  TaskScheduler::TaskScheduler(ThreadPool* pool, bool hierarchical_stealing)
+    : pool(pool), threadCounter(0), anyTasksRunning(0), hasRootTask(false), hierarchical_stealing(hierarchical_stealing)
   {
     threadLocal.resize(2*getNumberOfLogicalThreads()); // FIXME: this has to be 2x as in the compatibility join mode with rtcCommitScene the worker threads also join. When disallowing rtcCommitScene to join a build we can remove the 2x.
     for (size_t i=0; i<threadLocal.size(); i++)
@@ -265,8 +325,11 @@ namespace embree
     else        return 0;
   }
 
-  dll_export size_t TaskScheduler::threadCount() {
-    return threadPool->size();
+  dll_export size_t TaskScheduler::threadCount()
+  {
+    Thread* thread = TaskScheduler::thread();
+    if (thread) return thread->scheduler->getThreadPool() ? thread->scheduler->getThreadPool()->size() : 1;
+    else        return threadPool ? threadPool->size() : 1;
   }
 
   dll_export TaskScheduler* TaskScheduler::instance()
@@ -340,6 +403,7 @@ namespace embree
     /* allocate thread structure */
     std::unique_ptr<Thread> mthread(new Thread(threadIndex,this)); // too large for stack allocation
     Thread& thread = *mthread;
+    thread.domain = thread_domain;
     threadLocal[threadIndex].store(&thread);
     Thread* oldThread = swapThread(&thread);
 
@@ -386,32 +450,44 @@ namespace embree
     const size_t threadIndex = thread.threadIndex;
     const size_t threadCount = this->threadCounter;
 
-    for (size_t i=1; i<threadCount; i++)
+    /* first steal from threads sharing our last level cache, and only then from remote threads */
+    const bool hierarchical = hierarchical_stealing && thread.domain >= 0;
+    for (size_t pass=hierarchical ? 0 : 1; pass<2; pass++)
     {
-      pause_cpu(32);
-      size_t otherThreadIndex = threadIndex+i;
-      if (otherThreadIndex >= threadCount) otherThreadIndex -= threadCount;
+      for (size_t i=1; i<threadCount; i++)
+      {
+        size_t otherThreadIndex = threadIndex+i;
+        if (otherThreadIndex >= threadCount) otherThreadIndex -= threadCount;
 
-      Thread* othread = threadLocal[otherThreadIndex].load();
-      if (!othread)
-        continue;
+        Thread* othread = threadLocal[otherThreadIndex].load();
+        if (!othread)
+          continue;
+
+        if (hierarchical && (othread->domain == thread.domain) != (pass == 0))
+          continue;
 
-      if (othread->tasks.steal(thread))
-        return true;
+        pause_cpu(32);
+        if (othread->tasks.steal(thread))
+          return true;
+      }
     }
 
     return false;
   }
 
+  dll_export TaskScheduler::ThreadPool* TaskScheduler::getThreadPool() {
+    return pool ? pool : threadPool;
+  }
+
   dll_export void TaskScheduler::startThreads() {
-    threadPool->startThreads();
+    getThreadPool()->startThreads();
   }
 
   dll_export void TaskScheduler::addScheduler(const Ref<TaskScheduler>& scheduler) {
-    threadPool->add(scheduler);
+    getThreadPool()->add(scheduler);
   }
 
   dll_export void TaskScheduler::removeScheduler(const Ref<TaskScheduler>& scheduler) {
-    threadPool->remove(scheduler);
+    getThreadPool()->remove(scheduler);
   }
 }
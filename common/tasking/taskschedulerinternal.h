@@ -24,6 +24,8 @@
 #include "../sys/condition.h"
 #include "../sys/ref.h"
 #include "../sys/atomic.h"
+#include "../sys/intrinsics.h"
+#include "../sys/sysinfo.h"
 #include "../math/range.h"
 
 #include <list>
@@ -37,6 +39,7 @@ namespace embree
 
     static const size_t TASK_STACK_SIZE = 4*1024;           //!< task structure stack
     static const size_t CLOSURE_STACK_SIZE = 512*1024;    //!< stack for task closures
+    static const size_t MAX_STACK_SEGMENTS = 32;          //!< maximal number of segments of the task and closure stacks
 
     struct Thread;
 
@@ -121,16 +124,55 @@ namespace embree
       size_t N;                          //!< approximative size of task
     };
 
+    /*! Task and closure stacks are segmented. The first segment is
+     *  stored inline and used without any indirection, segment k>0
+     *  covers the index range [N<<(k-1),N<<k) and is allocated when
+     *  first reached. Segments never move and are only freed when the
+     *  queue gets destroyed, thus other threads can safely steal from
+     *  them. */
     struct TaskQueue
     {
       TaskQueue ()
-      : left(0), right(0), stackPtr(0) {}
+      : left(0), right(0), stackPtr(0)
+      {
+        for (size_t i=0; i<MAX_STACK_SEGMENTS; i++) {
+          taskSegments[i] = nullptr;
+          stackSegments[i] = nullptr;
+        }
+      }
+
+      dll_export ~TaskQueue ();
+
+      /*! returns the segment the specified stack index is stored in */
+      static __forceinline size_t segment(size_t index, size_t N) {
+        return index < N ? 0 : bsr(index/N)+1;
+      }
+
+      /*! returns the first index of some segment */
+      static __forceinline size_t segmentBegin(size_t k, size_t N) {
+        return k == 0 ? 0 : N << (k-1);
+      }
+
+      /*! returns the task at some location of the task stack */
+      __forceinline Task& task(size_t index)
+      {
+        if (likely(index < TASK_STACK_SIZE)) return tasks[index];
+        const size_t k = segment(index,TASK_STACK_SIZE);
+        return taskSegments[k][index-segmentBegin(k,TASK_STACK_SIZE)];
+      }
+
+      /*! returns the task at some location of the task stack, and allocates the segment if required */
+      __forceinline Task& allocTask(size_t index)
+      {
+        if (likely(index < TASK_STACK_SIZE)) return tasks[index];
+        return allocTaskSegment(index);
+      }
 
       __forceinline void* alloc(size_t bytes, size_t align = 64)
       {
         size_t ofs = bytes + ((align - stackPtr) & (align-1));
-        if (stackPtr + ofs > CLOSURE_STACK_SIZE)
-          throw std::runtime_error("closure stack overflow");
+        if (unlikely(stackPtr + ofs > CLOSURE_STACK_SIZE))
+          return allocStackSegment(bytes,align);
         stackPtr += ofs;
         return &stack[stackPtr-bytes];
       }
@@ -138,19 +180,19 @@ namespace embree
       template<typename Closure>
       __forceinline void push_right(Thread& thread, const size_t size, const Closure& closure)
       {
-        if (right >= TASK_STACK_SIZE)
-          throw std::runtime_error("task stack overflow");
-
 	/* allocate new task on right side of stack */
         size_t oldStackPtr = stackPtr;
         TaskFunction* func = new (alloc(sizeof(ClosureTaskFunction<Closure>))) ClosureTaskFunction<Closure>(closure);
-        new (&tasks[right]) Task(func,thread.task,oldStackPtr,size);
+        new (&allocTask(right)) Task(func,thread.task,oldStackPtr,size);
         right++;
 
 	/* also move left pointer */
 	if (left >= right-1) left = right-1;
       }
 
+      dll_export Task& allocTaskSegment(size_t index);
+      dll_export void* allocStackSegment(size_t bytes, size_t align);
+
       dll_export bool execute_local(Thread& thread, Task* parent);
       bool execute_local_internal(Thread& thread, Task* parent);
       bool steal(Thread& thread);
@@ -162,11 +204,13 @@ namespace embree
 
       /* task stack */
       Task tasks[TASK_STACK_SIZE];
+      Task* taskSegments[MAX_STACK_SEGMENTS];   //!< additional task stack segments
       __aligned(64) std::atomic<size_t> left;   //!< threads steal from left
       __aligned(64) std::atomic<size_t> right;  //!< new tasks are added to the right
 
       /* closure stack */
       __aligned(64) char stack[CLOSURE_STACK_SIZE];
+      char* stackSegments[MAX_STACK_SEGMENTS];  //!< additional closure stack segments
       size_t stackPtr;
     };
 
@@ -176,13 +220,14 @@ namespace embree
       ALIGNED_STRUCT_(64);
 
       Thread (size_t threadIndex, const Ref<TaskScheduler>& scheduler)
-      : threadIndex(threadIndex), task(nullptr), scheduler(scheduler) {}
+      : threadIndex(threadIndex), domain(-1), task(nullptr), scheduler(scheduler) {}
 
       __forceinline size_t threadCount() {
         return scheduler->threadCounter;
       }
 
       size_t threadIndex;              //!< ID of this thread
+      int domain;                      //!< last level cache domain of a pinned worker thread, or -1 for threads that may migrate
       TaskQueue tasks;                 //!< local task queue
       Task* task;                      //!< current active task
       Ref<TaskScheduler> scheduler;     //!< pointer to task scheduler
@@ -191,7 +236,7 @@ namespace embree
     /*! pool of worker threads */
     struct ThreadPool
     {
-      ThreadPool (bool set_affinity);
+      ThreadPool (bool set_affinity, size_t firstThread = 0);
       ~ThreadPool ();
 
       /*! starts the threads */
@@ -216,6 +261,7 @@ namespace embree
       std::atomic<size_t> numThreads;
       std::atomic<size_t> numThreadsRunning;
       bool set_affinity;
+      size_t firstThread;              //!< logical thread the threads of this pool get affinitized to first
       std::atomic<bool> running;
       std::vector<thread_t> threads;
 
@@ -225,7 +271,7 @@ namespace embree
       std::list<Ref<TaskScheduler> > schedulers;
     };
 
-    TaskScheduler ();
+    TaskScheduler (ThreadPool* pool = nullptr, bool hierarchical_stealing = true);
     ~TaskScheduler ();
 
     /*! initializes the task scheduler */
@@ -257,6 +303,8 @@ namespace embree
     template<typename Closure>
       void spawn_root(const Closure& closure, size_t size = 1, bool useThreadPool = true)
     {
+      /* without any thread pool the calling thread executes all tasks */
+      if (!getThreadPool()) useThreadPool = false;
       if (useThreadPool) startThreads();
 
       size_t threadIndex = allocThreadIndex();
@@ -339,6 +387,11 @@ namespace embree
     /* returns the total number of threads */
     dll_export static size_t threadCount();
 
+    /* returns true if the calling thread executes a task */
+    static __forceinline bool isRunningTask() {
+      return thread() != nullptr;
+    }
+
   private:
 
     /* returns the thread local task list of this worker thread */
@@ -350,16 +403,20 @@ namespace embree
     /*! returns the taskscheduler object to be used by the master thread */
     dll_export static TaskScheduler* instance();
 
+    /*! returns the thread pool this task scheduler uses */
+    dll_export ThreadPool* getThreadPool();
+
     /*! starts the threads */
-    dll_export static void startThreads();
+    dll_export void startThreads();
 
     /*! adds a task scheduler object for scheduling */
-    dll_export static void addScheduler(const Ref<TaskScheduler>& scheduler);
+    dll_export void addScheduler(const Ref<TaskScheduler>& scheduler);
 
     /*! remove the task scheduler object again */
-    dll_export static void removeScheduler(const Ref<TaskScheduler>& scheduler);
+    dll_export void removeScheduler(const Ref<TaskScheduler>& scheduler);
 
   private:
+    ThreadPool* pool;                  //!< private thread pool to use, or nullptr for the shared pool
     std::vector<atomic<Thread*>> threadLocal;
     std::atomic<size_t> threadCounter;
     std::atomic<size_t> anyTasksRunning;
@@ -367,6 +424,7 @@ namespace embree
     std::exception_ptr cancellingException;
     MutexSys mutex;
     ConditionSys condition;
+    bool hierarchical_stealing;        //!< prefer stealing from threads of the same cache domain
 
   private:
     static size_t g_numThreads;
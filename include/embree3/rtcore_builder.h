@@ -34,6 +34,22 @@ struct RTC_ALIGN(32) RTCBuildPrimitive
   unsigned int primID;
 };
 
+/* Input build primitives with linear motion for the motion blur builder */
+struct RTC_ALIGN(32) RTCBuildPrimitiveMB
+{
+  float lower0_x, lower0_y, lower0_z;
+  unsigned int geomID;
+  float upper0_x, upper0_y, upper0_z;
+  unsigned int primID;
+  float lower1_x, lower1_y, lower1_z;
+  float align0;
+  float upper1_x, upper1_y, upper1_z;
+  float align1;
+};
+
+/* Maximal number of primitives the low quality and motion blur builders pass to the create leaf callbacks */
+#define RTC_BUILD_MAX_PRIMITIVES_PER_LEAF 32
+
 /* Opaque thread local allocator type */
 typedef struct RTCThreadLocalAllocatorTy* RTCThreadLocalAllocator;
 
@@ -46,9 +62,15 @@ typedef void (*RTCSetNodeChildrenFunction) (void* nodePtr, void** children, unsi
 /* Callback to set the bounds of all children */
 typedef void (*RTCSetNodeBoundsFunction) (void* nodePtr, const struct RTCBounds** bounds, unsigned int childCount, void* userPtr);
 
+/* Callback to set the linear bounds of all children */
+typedef void (*RTCSetNodeLinearBoundsFunction) (void* nodePtr, const struct RTCLinearBounds** bounds, unsigned int childCount, void* userPtr);
+
 /* Callback to create a leaf node */
 typedef void* (*RTCCreateLeafFunction) (RTCThreadLocalAllocator allocator, const struct RTCBuildPrimitive* primitives, size_t primitiveCount, void* userPtr);
 
+/* Callback to create a leaf node over motion blurred primitives */
+typedef void* (*RTCCreateLeafMBFunction) (RTCThreadLocalAllocator allocator, const struct RTCBuildPrimitiveMB* primitives, size_t primitiveCount, void* userPtr);
+
 /* Callback to split a build primitive */
 typedef void (*RTCSplitPrimitiveFunction) (const struct RTCBuildPrimitive* primitive, unsigned int dimension, float position, struct RTCBounds* leftBounds, struct RTCBounds* rightBounds, void* userPtr);
 
@@ -57,6 +79,7 @@ enum RTCBuildFlags
 {
   RTC_BUILD_FLAG_NONE    = 0,
   RTC_BUILD_FLAG_DYNAMIC = (1 << 0),
+  RTC_BUILD_FLAG_REFIT   = (1 << 1),
 };
   
 /* Input for builders */
@@ -86,6 +109,10 @@ struct RTCBuildArguments
   RTCSplitPrimitiveFunction splitPrimitive;
   RTCProgressMonitorFunction buildProgress;
   void* userPtr;
+
+  struct RTCBuildPrimitiveMB* primitivesMB;
+  RTCSetNodeLinearBoundsFunction setNodeLinearBounds;
+  RTCCreateLeafMBFunction createLeafMB;
 };
 
 /* Returns the default build settings.  */
@@ -113,6 +140,9 @@ RTC_FORCEINLINE struct RTCBuildArguments rtcDefaultBuildArguments()
   args.splitPrimitive = NULL;
   args.buildProgress = NULL;
   args.userPtr = NULL;
+  args.primitivesMB = NULL;
+  args.setNodeLinearBounds = NULL;
+  args.createLeafMB = NULL;
   return args;
 }
 
@@ -122,6 +152,9 @@ RTC_API RTCBVH rtcNewBVH(RTCDevice device);
 /* Builds a BVH. */
 RTC_API void* rtcBuildBVH(const struct RTCBuildArguments* args);
 
+/* Refits a BVH built with the RTC_BUILD_FLAG_REFIT flag. */
+RTC_API void rtcRefitBVH(const struct RTCBuildArguments* args);
+
 /* Allocates memory using the thread local allocator. */
 RTC_API void* rtcThreadLocalAlloc(RTCThreadLocalAllocator allocator, size_t bytes, size_t align);
 
@@ -59,7 +59,12 @@ enum RTCDeviceProperty
   RTC_DEVICE_PROPERTY_USER_GEOMETRY_SUPPORTED        = 100,
 
   RTC_DEVICE_PROPERTY_TASKING_SYSTEM        = 128,
-  RTC_DEVICE_PROPERTY_JOIN_COMMIT_SUPPORTED = 129
+  RTC_DEVICE_PROPERTY_JOIN_COMMIT_SUPPORTED = 129,
+  RTC_DEVICE_PROPERTY_NUM_THREADS           = 130,
+
+  RTC_DEVICE_PROPERTY_OS_ALLOCATED_BYTES             = 160,
+  RTC_DEVICE_PROPERTY_HUGETLB_BYTES                  = 161,
+  RTC_DEVICE_PROPERTY_TRANSPARENT_HUGE_PAGE_BYTES    = 162
 };
 
 /* Gets a device property. */
@@ -159,6 +159,9 @@ RTC_API void rtcSetGeometryVertexAttributeCount(RTCGeometry geometry, unsigned i
 /* Sets the ray mask of the geometry. */
 RTC_API void rtcSetGeometryMask(RTCGeometry geometry, unsigned int mask);
 
+/* Sets the scale and offset used to decode compact vertex positions of the geometry. */
+RTC_API void rtcSetGeometryVertexQuantization(RTCGeometry geometry, const float* scale, const float* offset);
+
 /* Sets the build quality of the geometry. */
 RTC_API void rtcSetGeometryBuildQuality(RTCGeometry geometry, enum RTCBuildQuality quality);
 
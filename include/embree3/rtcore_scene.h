@@ -39,6 +39,14 @@ enum RTCSceneFlags
   RTC_SCENE_FLAG_CONTEXT_FILTER_FUNCTION = (1 << 3)
 };
 
+/* Memory fallbacks selected at commit to meet the memory budget of a scene */
+enum RTCSceneMemoryFallback
+{
+  RTC_SCENE_MEMORY_FALLBACK_NONE              = 0,
+  RTC_SCENE_MEMORY_FALLBACK_NO_SPATIAL_SPLITS = 1,
+  RTC_SCENE_MEMORY_FALLBACK_COMPACT           = 2
+};
+
 /* Creates a new scene. */
 RTC_API RTCScene rtcNewScene(RTCDevice device);
 
@@ -68,6 +76,9 @@ RTC_API void rtcCommitScene(RTCScene scene);
 /* Commits the scene from multiple threads. */
 RTC_API void rtcJoinCommitScene(RTCScene scene);
 
+/* Compacts the memory of a committed scene and releases its build memory. */
+RTC_API void rtcCompactScene(RTCScene scene);
+
 
 /* Progress monitor callback function */
 typedef bool (*RTCProgressMonitorFunction)(void* ptr, double n);
@@ -84,6 +95,12 @@ RTC_API void rtcSetSceneFlags(RTCScene scene, enum RTCSceneFlags flags);
 /* Returns the scene flags. */
 RTC_API enum RTCSceneFlags rtcGetSceneFlags(RTCScene scene);
 
+/* Sets the memory budget in bytes for building the scene. */
+RTC_API void rtcSetSceneMemoryBudget(RTCScene scene, size_t bytes);
+
+/* Returns the memory fallback selected by the last commit of the scene. */
+RTC_API enum RTCSceneMemoryFallback rtcGetSceneMemoryFallback(RTCScene scene);
+
 /* Returns the axis-aligned bounds of the scene. */
 RTC_API void rtcGetSceneBounds(RTCScene scene, struct RTCBounds* bounds_o);
 
@@ -439,7 +439,7 @@ namespace embree
             } while (children.size() < cfg.branchingFactor);
 
             /* create node */
-            auto node = createNode(alloc, hasTimeSplits);
+            auto node = createNode(children.children.data(), children.size(), alloc, hasTimeSplits);
 
             /* recurse into each child and perform reduction */
             LBBox3fa gbounds = empty;
@@ -521,7 +521,7 @@ namespace embree
             //std::sort(&children[0],&children[children.size()],std::greater<BuildRecord>()); // FIXME: reduces traversal performance of bvh8.triangle4 (need to verified) !!
 
             /*! create an inner node */
-            auto node = createNode(alloc, hasTimeSplits);
+            auto node = createNode(children.children.data(), children.size(), alloc, hasTimeSplits);
             LBBox3fa gbounds = empty;
 
             /* spawn tasks */
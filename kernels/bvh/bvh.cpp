@@ -16,6 +16,7 @@
 
 #include "bvh.h"
 #include "bvh_statistics.h"
+#include "../geometry/subdivpatch1.h"
 
 namespace embree
 {
@@ -122,6 +123,172 @@ namespace embree
     else return node;
   }
 
+  template<int N>
+  size_t BVHN<N>::nodeBytes(NodeRef node) const
+  {
+    if (node.isLeaf()) {
+      size_t num; const char* prims = node.leaf(num);
+      if (num == 0) return 0;
+      /* only the last block of a leaf may be partially filled */
+      return (num-1)*primTy->bytes + primTy->getBytes(prims+(num-1)*primTy->bytes);
+    }
+    else if (node.isAlignedNode()    ) return sizeof(AlignedNode);
+    else if (node.isAlignedNodeMB()  ) return sizeof(AlignedNodeMB);
+    else if (node.isAlignedNodeMB4D()) return sizeof(AlignedNodeMB4D);
+    else if (node.isUnalignedNode()  ) return sizeof(UnalignedNode);
+    else if (node.isUnalignedNodeMB()) return sizeof(UnalignedNodeMB);
+    else return 0;
+  }
+
+  template<int N>
+  bool BVHN<N>::compactBytes(NodeRef node, size_t& bytes) const
+  {
+    /* some builders align leaves like nodes, the padding is independent of the order of the copy */
+    if (node.isLeaf()) {
+      bytes += (nodeBytes(node)+byteNodeAlignment-1) & ~(byteNodeAlignment-1);
+      return true;
+    }
+
+    /* quantized nodes store child offsets relative to the node */
+    const size_t nbytes = nodeBytes(node);
+    if (nbytes == 0 || node.isBarrier())
+      return false;
+
+    bytes += (nbytes+byteNodeAlignment-1) & ~(byteNodeAlignment-1);
+    const BaseNode* n = node.baseNode(BVH_FLAG_ALIGNED_NODE);
+    for (size_t i=0; i<N; i++)
+      if (!compactBytes(n->child(i),bytes))
+        return false;
+    return true;
+  }
+
+  template<int N>
+  typename BVHN<N>::NodeRef BVHN<N>::compactRecursion(NodeRef node, FastAllocator& allocator)
+  {
+    size_t bytes = nodeBytes(node);
+    if (node.isLeaf())
+    {
+      if (bytes == 0) return node;
+      size_t num; const char* prims = node.leaf(num);
+      void* leaf = allocator.malloc(bytes,byteNodeAlignment,false);
+      memcpy(leaf,prims,bytes);
+      return NodeRef((size_t)leaf | (node & items_mask));
+    }
+    
+    BaseNode* n = (BaseNode*) allocator.malloc(bytes,byteNodeAlignment,false);
+    memcpy(n,node.baseNode(BVH_FLAG_ALIGNED_NODE),bytes);
+    for (size_t i=0; i<N; i++)
+      n->child(i) = compactRecursion(n->child(i),allocator);
+    return NodeRef((size_t)n | node.type());
+  }
+
+  template<int N>
+  float BVHN<N>::childArea(NodeRef node, size_t i) const
+  {
+    if (node.isAlignedNode()) return halfArea(node.alignedNode()->bounds(i));
+    else if (node.isAlignedNodeMB() || node.isAlignedNodeMB4D()) return halfArea(node.alignedNodeMB()->bounds(i));
+    else return 1.0f; // all children of unaligned nodes are treated equally
+  }
+
+  template<int N>
+  typename BVHN<N>::NodeRef BVHN<N>::compactTreelets(NodeRef root, FastAllocator& allocator)
+  {
+    if (root.isLeaf())
+      return compactRecursion(root,allocator);
+
+    /* grow a treelet of about one page by greedily adding the node
+     * with the largest surface area, thus the most likely traversed
+     * nodes end up next to each other */
+    struct Item {
+      NodeRef node;
+      size_t parent;
+      size_t slot;
+      float area;
+    };
+    const size_t maxTreeletBytes = PAGE_SIZE;
+    std::vector<Item> treelet;
+    std::vector<Item> frontier;
+    frontier.push_back({ root, size_t(-1), 0, float(inf) });
+    size_t treeletBytes = 0;
+    while (frontier.size())
+    {
+      auto best = std::max_element(frontier.begin(),frontier.end(),[] (const Item& a, const Item& b) { return a.area < b.area; });
+      const size_t bytes = nodeBytes(best->node);
+      if (treelet.size() && treeletBytes+bytes > maxTreeletBytes) break;
+      const Item item = *best;
+      frontier.erase(best);
+      treeletBytes += bytes;
+      const size_t index = treelet.size();
+      treelet.push_back(item);
+
+      const BaseNode* node = item.node.baseNode(BVH_FLAG_ALIGNED_NODE);
+      for (size_t i=0; i<N; i++)
+        if (!node->child(i).isLeaf())
+          frontier.push_back({ node->child(i), index, i, childArea(item.node,i) });
+    }
+
+    /* store the nodes of the treelet first followed by their leaves */
+    std::vector<BaseNode*> nodes(treelet.size());
+    for (size_t j=0; j<treelet.size(); j++)
+    {
+      size_t bytes = nodeBytes(treelet[j].node);
+      nodes[j] = (BaseNode*) allocator.malloc(bytes,byteNodeAlignment,false);
+      memcpy(nodes[j],treelet[j].node.baseNode(BVH_FLAG_ALIGNED_NODE),bytes);
+      if (j) nodes[treelet[j].parent]->child(treelet[j].slot) = NodeRef((size_t)nodes[j] | treelet[j].node.type());
+    }
+    for (size_t j=0; j<treelet.size(); j++)
+      for (size_t i=0; i<N; i++)
+        if (nodes[j]->child(i).isLeaf())
+          nodes[j]->child(i) = compactRecursion(nodes[j]->child(i),allocator);
+
+    /* the remaining nodes start new treelets */
+    for (const Item& item : frontier)
+      nodes[item.parent]->child(item.slot) = compactTreelets(item.node,allocator);
+
+    return NodeRef((size_t)nodes[0] | root.type());
+  }
+
+  template<int N>
+  void BVHN<N>::compactMemory()
+  {
+    /* two-level BVHs point into the nodes of their object BVHs and
+     * subdivision leaves point to grids stored in the BVH memory */
+    if (objects.size() || primTy == &SubdivPatch1::type)
+      return;
+
+    size_t bytes = 0;
+    if (!compactBytes(root,bytes))
+      return;
+
+    /* empty BVHs need no memory */
+    if (bytes == 0) {
+      alloc.clear();
+      return;
+    }
+
+    /* copy all nodes and leaves into a single block */
+    const size_t bytesOld = FastAllocator::Statistics(&alloc,FastAllocator::ANY_TYPE).bytesAllocatedTotal();
+    const size_t bytesReserve = bytes+byteNodeAlignment;
+    FastAllocator compacted(device,scene->isStaticAccel());
+    compacted.init(bytesReserve,bytesReserve,bytesReserve);
+    if (device->bvh_layout == "treelets")
+      root = compactTreelets(root,compacted);
+    else if (device->bvh_layout == "default" || device->bvh_layout == "depth_first")
+      root = compactRecursion(root,compacted);
+    else
+      throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"unknown BVH layout "+device->bvh_layout);
+
+    /* the old memory gets freed with the temporary allocator */
+    alloc.swap(compacted);
+
+    if (device->verbosity(2))
+    {
+      const size_t bytesNew = FastAllocator::Statistics(&alloc,FastAllocator::ANY_TYPE).bytesAllocatedTotal();
+      Lock<MutexSys> lock(g_printMutex);
+      std::cout << "compacted BVH" << N << "<" << primTy->name << "> from " << 1E-6*double(bytesOld) << " MB to " << 1E-6*double(bytesNew) << " MB" << std::endl;
+    }
+  }
+
   template<int N>
   double BVHN<N>::preBuild(const std::string& builderName)
   {
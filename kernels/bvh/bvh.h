@@ -844,6 +844,11 @@ namespace embree
             return encodeNode(node);
           }
         }
+
+        template<typename BuildRecord>
+        __forceinline NodeRef operator() (BuildRecord* children, const size_t num, const FastAllocator::CachedAllocator& alloc, bool hasTimeSplits = true) const {
+          return operator() (alloc,hasTimeSplits);
+        }
       };
 
       struct Set
@@ -1443,6 +1448,18 @@ namespace embree
     void layoutLargeNodes(size_t num);
     NodeRef layoutLargeNodesRecursion(NodeRef& node, const FastAllocator::CachedAllocator& allocator);
 
+    /*! copies all nodes and leaves in depth first order into tightly sized memory */
+    void compactMemory();
+    bool compactBytes(NodeRef node, size_t& bytes) const;
+    NodeRef compactRecursion(NodeRef node, FastAllocator& allocator);
+    NodeRef compactTreelets(NodeRef node, FastAllocator& allocator);
+
+    /*! returns the number of bytes of a node or leaf */
+    size_t nodeBytes(NodeRef node) const;
+
+    /*! returns the surface area of some child of a node */
+    float childArea(NodeRef node, size_t i) const;
+
     /*! called by all builders before build starts */
     double preBuild(const std::string& builderName);
 
@@ -16,6 +16,7 @@
 
 #include "bvh.h"
 #include "bvh_builder.h"
+#include "bvh_optimize.h"
 #include "../builders/primrefgen.h"
 #include "../builders/splitter.h"
 
@@ -176,6 +177,9 @@ namespace embree
             /* call BVH builder */
             NodeRef root = BVHNBuilderVirtual<N>::build(&bvh->alloc,CreateLeaf<N,Primitive>(bvh),bvh->scene->progressInterface,prims.data(),pinfo,settings);
             bvh->set(root,LBBox3fa(pinfo.geomBounds),pinfo.size());
+            /* spend more build time for faster traversal */
+            if ((mesh ? mesh->quality : scene->quality_flags) == RTC_BUILD_QUALITY_HIGH)
+              BVHNOptimizer<N>::optimize(bvh);
             bvh->layoutLargeNodes(size_t(pinfo.size()*0.005f));
 
 #if PROFILE
@@ -526,6 +530,9 @@ namespace embree
         /* call BVH builder */
         NodeRef root = BVHNBuilderVirtual<N>::build(&bvh->alloc,CreateLeafGrid<N,SubGridQBVHN<N>>(bvh,sgrids.data()),bvh->scene->progressInterface,prims.data(),pinfo,settings);
         bvh->set(root,LBBox3fa(pinfo.geomBounds),pinfo.size());
+        /* spend more build time for faster traversal */
+        if ((mesh ? mesh->quality : scene->quality_flags) == RTC_BUILD_QUALITY_HIGH)
+          BVHNOptimizer<N>::optimize(bvh);
         bvh->layoutLargeNodes(size_t(pinfo.size()*0.005f));
 
         /* clear temporary array */
@@ -16,6 +16,7 @@
 
 #include "bvh.h"
 #include "bvh_builder.h"
+#include "bvh_optimize.h"
 
 #include "../builders/primrefgen.h"
 #include "../builders/splitter.h"
@@ -75,11 +76,11 @@ namespace embree
 
       BVHNBuilderFastSpatialSAH (BVH* bvh, Scene* scene, const size_t sahBlockSize, const float intCost, const size_t minLeafSize, const size_t maxLeafSize, const size_t mode)
         : bvh(bvh), scene(scene), mesh(nullptr), prims0(scene->device,0), settings(sahBlockSize, minLeafSize, min(maxLeafSize,Primitive::max_size()*BVH::maxLeafBlocks), travCost, intCost, DEFAULT_SINGLE_THREAD_THRESHOLD),
-          splitFactor(scene->device->max_spatial_split_replications) {}
+          splitFactor(scene->maxSpatialSplitReplications()) {}
 
       BVHNBuilderFastSpatialSAH (BVH* bvh, Mesh* mesh, const size_t sahBlockSize, const float intCost, const size_t minLeafSize, const size_t maxLeafSize, const size_t mode)
         : bvh(bvh), scene(nullptr), mesh(mesh), prims0(bvh->device,0), settings(sahBlockSize, minLeafSize, min(maxLeafSize,Primitive::max_size()*BVH::maxLeafBlocks), travCost, intCost, DEFAULT_SINGLE_THREAD_THRESHOLD),
-          splitFactor(scene->device->max_spatial_split_replications) {}
+          splitFactor(scene->maxSpatialSplitReplications()) {}
 
       // FIXME: shrink bvh->alloc in destructor here and in other builders too
 
@@ -133,6 +134,9 @@ namespace embree
           pinfo,settings);
 
         bvh->set(root,LBBox3fa(pinfo.geomBounds),pinfo.size());
+        /* spend more build time for faster traversal */
+        if ((mesh ? mesh->quality : scene->quality_flags) == RTC_BUILD_QUALITY_HIGH)
+          BVHNOptimizer<N>::optimize(bvh);
         bvh->layoutLargeNodes(size_t(pinfo.size()*0.005f));
 
 	/* clear temporary data for static geometry */
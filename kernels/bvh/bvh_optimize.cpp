@@ -0,0 +1,218 @@
+// ======================================================================== //
+// Copyright 2009-2018 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "bvh_optimize.h"
+#include "../../common/algorithms/parallel_for.h"
+
+namespace embree
+{
+  namespace isa
+  {
+    template<int N>
+    size_t BVHNOptimizer<N>::optimize(BVH* bvh, size_t rounds)
+    {
+      if (!bvh->root.isAlignedNode())
+        return 0;
+
+      /* each round visits all nodes bottom up, thus optimized
+       * treelets become the subtrees of treelets further up */
+      std::atomic<size_t> numRestructured(0);
+      for (size_t r=0; r<rounds; r++)
+      {
+        const size_t numRestructuredBefore = numRestructured;
+        recurse(bvh,bvh->root,0,numRestructured);
+        if (numRestructured == numRestructuredBefore) break;
+      }
+
+      if (bvh->device->verbosity(2))
+      {
+        Lock<MutexSys> lock(g_printMutex);
+        std::cout << "restructured " << numRestructured << " treelets of BVH" << N << "<" << bvh->primTy->name << ">" << std::endl;
+      }
+      return numRestructured;
+    }
+
+    template<int N>
+    size_t BVHNOptimizer<N>::recurse(BVH* bvh, NodeRef ref, size_t depth, std::atomic<size_t>& numRestructured)
+    {
+      if (ref.isLeaf()) return 0;
+
+      /* other node types are kept as they are, their depth is not known */
+      if (ref.isBarrier() || !ref.isAlignedNode()) return BVH::maxBuildDepthLeaf;
+      AlignedNode* node = ref.alignedNode();
+
+      /* optimize all subtrees first */
+      size_t cdepth[N];
+      if (depth < PARALLEL_DEPTH)
+      {
+        parallel_for(size_t(0), size_t(N), size_t(1), [&](const range<size_t>& r) {
+            for (size_t i=r.begin(); i<r.end(); i++)
+              cdepth[i] = recurse(bvh,node->child(i),depth+1,numRestructured);
+          });
+      }
+      else
+      {
+        for (size_t i=0; i<N; i++)
+          cdepth[i] = recurse(bvh,node->child(i),depth+1,numRestructured);
+      }
+
+      bool restructured = false;
+      const size_t newDepth = restructure(bvh,node,depth,cdepth,restructured);
+      if (restructured) numRestructured++;
+      return newDepth;
+    }
+
+    template<int N>
+    size_t BVHNOptimizer<N>::restructure(BVH* bvh, AlignedNode* node, size_t depth, const size_t cdepth[N], bool& restructured)
+    {
+      /* the subtrees below the node and its aligned child nodes form the items of the treelet */
+      Item items[MAX_TREELET_ITEMS];
+      AlignedNode* inner[N];
+      size_t numItems = 0, numInner = 0, oldDepth = 0;
+      float oldCost = 0.0f;
+      for (size_t i=0; i<N; i++)
+      {
+        NodeRef child = node->child(i);
+        if (child == BVH::emptyNode) continue;
+        oldDepth = max(oldDepth,1+cdepth[i]);
+
+        if (!child.isBarrier() && child.isAlignedNode())
+        {
+          AlignedNode* cnode = child.alignedNode();
+          inner[numInner++] = cnode;
+          oldCost += halfArea(node->bounds(i));
+          for (size_t j=0; j<N; j++)
+            if (cnode->child(j) != BVH::emptyNode)
+              items[numItems++] = { cnode->child(j), cnode->bounds(j), cdepth[i]-1 };
+        }
+        else
+          items[numItems++] = { child, node->bounds(i), cdepth[i] };
+      }
+      if (numInner == 0)
+        return oldDepth;
+
+      /* For each axis we sort the items by their centroids and
+       * distribute consecutive items over the N children of the node
+       * using dynamic programming. A single item becomes a direct
+       * child, multiple items get a new inner node, whose area
+       * contributes to the SAH cost. */
+      const size_t M = numItems;
+      float area[MAX_TREELET_ITEMS][N+1];
+      float cost[MAX_TREELET_ITEMS+1][N+1];
+      unsigned char split[MAX_TREELET_ITEMS+1][N+1];
+      unsigned char bestSplit[MAX_TREELET_ITEMS+1][N+1];
+      unsigned char order[MAX_TREELET_ITEMS], bestOrder[MAX_TREELET_ITEMS];
+      float bestCost = 0.999f*oldCost; // only accept significant improvements
+      size_t bestGroups = 0;
+
+      for (size_t dim=0; dim<3; dim++)
+      {
+        for (size_t i=0; i<M; i++) order[i] = (unsigned char) i;
+        std::sort(order,order+M,[&] (unsigned char a, unsigned char b) {
+            return center2(items[a].bounds)[dim] < center2(items[b].bounds)[dim];
+          });
+
+        for (size_t a=0; a<M; a++)
+        {
+          BBox3fa bounds = items[order[a]].bounds;
+          area[a][1] = 0.0f;
+          for (size_t len=2; len<=N && a+len<=M; len++) {
+            bounds.extend(items[order[a+len-1]].bounds);
+            area[a][len] = halfArea(bounds);
+          }
+        }
+
+        for (size_t i=0; i<=M; i++)
+          for (size_t k=0; k<=N; k++)
+            cost[i][k] = inf;
+        cost[0][0] = 0.0f;
+
+        for (size_t i=1; i<=M; i++)
+          for (size_t k=1; k<=N; k++)
+            for (size_t len=1; len<=min(size_t(N),i); len++)
+            {
+              const float c = cost[i-len][k-1] + area[i-len][len];
+              if (c < cost[i][k]) {
+                cost[i][k] = c;
+                split[i][k] = (unsigned char) len;
+              }
+            }
+
+        for (size_t k=1; k<=N; k++)
+        {
+          if (cost[M][k] >= bestCost) continue;
+          bestCost = cost[M][k];
+          bestGroups = k;
+          for (size_t i=0; i<M; i++) bestOrder[i] = order[i];
+          for (size_t i=0; i<=M; i++)
+            for (size_t j=0; j<=N; j++)
+              bestSplit[i][j] = split[i][j];
+        }
+      }
+
+      if (bestGroups == 0)
+        return oldDepth;
+
+      /* extract the groups and reject the treelet if it gets too deep */
+      size_t groupBegin[N], groupSize[N];
+      size_t newDepth = 0;
+      for (size_t i=M, k=bestGroups; k>0; k--)
+      {
+        const size_t len = bestSplit[i][k];
+        i -= len;
+        groupBegin[k-1] = i;
+        groupSize [k-1] = len;
+
+        size_t d = 0;
+        for (size_t j=i; j<i+len; j++)
+          d = max(d,items[bestOrder[j]].depth);
+        newDepth = max(newDepth, len == 1 ? 1+d : 2+d);
+      }
+      if (newDepth > oldDepth && depth+newDepth > BVH::maxBuildDepthLeaf)
+        return oldDepth;
+
+      /* rebuild the treelet, reusing the memory of the old child nodes */
+      size_t numUsed = 0;
+      node->clear();
+      for (size_t k=0; k<bestGroups; k++)
+      {
+        const Item* first = &items[bestOrder[groupBegin[k]]];
+        if (groupSize[k] == 1) {
+          node->set(k,first->ref,first->bounds);
+          continue;
+        }
+
+        AlignedNode* cnode = numUsed < numInner ? inner[numUsed++] : (AlignedNode*) bvh->alloc.getCachedAllocator().malloc0(sizeof(AlignedNode),BVH::byteNodeAlignment);
+        cnode->clear();
+        BBox3fa bounds(empty);
+        for (size_t j=0; j<groupSize[k]; j++) {
+          const Item& item = items[bestOrder[groupBegin[k]+j]];
+          cnode->set(j,item.ref,item.bounds);
+          bounds.extend(item.bounds);
+        }
+        node->set(k,BVH::encodeNode(cnode),bounds);
+      }
+
+      restructured = true;
+      return newDepth;
+    }
+
+    template class BVHNOptimizer<4>;
+#if defined(__AVX__)
+    template class BVHNOptimizer<8>;
+#endif
+  }
+}
@@ -0,0 +1,59 @@
+// ======================================================================== //
+// Copyright 2009-2018 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "bvh.h"
+
+namespace embree
+{
+  namespace isa
+  {
+    /* Restructures the treelets formed by each aligned node and its
+     * aligned child nodes to minimize the SAH cost. The subtrees below
+     * a treelet are redistributed over a new set of child nodes, thus
+     * the pass works for all leaf types. */
+    template<int N>
+    class BVHNOptimizer
+    {
+      typedef BVHN<N> BVH;
+      typedef typename BVH::NodeRef NodeRef;
+      typedef typename BVH::AlignedNode AlignedNode;
+
+      /* maximal number of subtrees of a treelet */
+      static const size_t MAX_TREELET_ITEMS = N*N;
+
+      /* the top of the tree is optimized with that many levels of parallel tasks */
+      static const size_t PARALLEL_DEPTH = N == 4 ? 4 : 3;
+
+      struct Item
+      {
+        NodeRef ref;
+        BBox3fa bounds;
+        size_t depth;
+      };
+
+    public:
+
+      /* optimizes the BVH in multiple rounds, returns the number of restructured treelets */
+      static size_t optimize(BVH* bvh, size_t rounds = 2);
+
+    private:
+      static size_t recurse(BVH* bvh, NodeRef ref, size_t depth, std::atomic<size_t>& numRestructured);
+      static __noinline size_t restructure(BVH* bvh, AlignedNode* node, size_t depth, const size_t cdepth[N], bool& restructured);
+    };
+  }
+}
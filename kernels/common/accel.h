@@ -41,6 +41,9 @@ namespace embree
     /*! clears the acceleration structure data */
     virtual void clear() = 0;
 
+    /*! copies the committed acceleration structure into tightly sized memory */
+    virtual void compactMemory() {}
+
     /*! returns normal bounds */
     __forceinline BBox3fa getBounds() const {
       return bounds.bounds();
@@ -47,6 +47,11 @@ namespace embree
       if (builder) builder->clear();
     }
 
+    void compactMemory() {
+      builder.reset(nullptr);
+      if (accel) accel->compactMemory();
+    }
+
   private:
     std::unique_ptr<AccelData> accel;
     std::unique_ptr<Builder> builder;
@@ -22,7 +22,32 @@
 namespace embree
 {
   AccelN::AccelN()
-    : Accel(AccelData::TY_ACCELN), accels(nullptr), validAccels(nullptr) {}
+    : Accel(AccelData::TY_ACCELN), accels(nullptr), validAccels(nullptr), ordered(false) {}
+
+  /* sorts the valid acceleration structures front to back along the ray and drops the ones the ray misses */
+  static __forceinline size_t orderAccels(const AccelN* This, const RTCRay& ray, size_t order[24], float dist[24])
+  {
+    const Vec3fa org(ray.org_x,ray.org_y,ray.org_z);
+    const Vec3fa rdir = rcp_safe(Vec3fa(ray.dir_x,ray.dir_y,ray.dir_z));
+    size_t M = 0;
+    for (size_t i=0; i<This->validAccels.size(); i++)
+    {
+      const BBox3fa& b = This->validBounds[i];
+      const Vec3fa t0 = (b.lower-org)*rdir;
+      const Vec3fa t1 = (b.upper-org)*rdir;
+      const float tmin = max(reduce_max(min(t0,t1)),ray.tnear);
+      const float tmax = min(reduce_min(max(t0,t1)),ray.tfar);
+      if (!(tmin <= tmax)) continue;
+
+      /* insertion sort, there are only few acceleration structures */
+      size_t j = M++;
+      for (; j>0 && dist[j-1] > tmin; j--) {
+        dist[j] = dist[j-1]; order[j] = order[j-1];
+      }
+      dist[j] = tmin; order[j] = i;
+    }
+    return M;
+  }
 
   AccelN::~AccelN() 
   {
@@ -46,6 +71,7 @@ namespace embree
     
     accels.clear();
     validAccels.clear();
+    validBounds.clear();
   }
   
   void AccelN::intersect (Accel::Intersectors* This_in, RTCRayHit& ray, IntersectContext* context) 
@@ -55,6 +81,19 @@ namespace embree
       This->validAccels[i]->intersectors.intersect(ray,context);
   }
 
+  void AccelN::intersectOrdered (Accel::Intersectors* This_in, RTCRayHit& ray, IntersectContext* context) 
+  {
+    AccelN* This = (AccelN*)This_in->ptr;
+    size_t order[24]; float dist[24];
+    const size_t M = orderAccels(This,ray.ray,order,dist);
+
+    /* closer hits cull the traversal of farther acceleration structures */
+    for (size_t i=0; i<M; i++) {
+      if (dist[i] > ray.ray.tfar) break;
+      This->validAccels[order[i]]->intersectors.intersect(ray,context);
+    }
+  }
+
   void AccelN::intersect4 (const void* valid, Accel::Intersectors* This_in, RTCRayHit4& ray, IntersectContext* context) 
   {
     AccelN* This = (AccelN*)This_in->ptr;
@@ -92,6 +131,17 @@ namespace embree
     }
   }
 
+  void AccelN::occludedOrdered (Accel::Intersectors* This_in, RTCRay& ray, IntersectContext* context) 
+  {
+    AccelN* This = (AccelN*)This_in->ptr;
+    size_t order[24]; float dist[24];
+    const size_t M = orderAccels(This,ray,order,dist);
+    for (size_t i=0; i<M; i++) {
+      This->validAccels[order[i]]->intersectors.occluded(ray,context); 
+      if (ray.tfar < 0.0f) break; 
+    }
+  }
+
   void AccelN::occluded4 (const void* valid, Accel::Intersectors* This_in, RTCRay4& ray, IntersectContext* context) 
   {
     AccelN* This = (AccelN*)This_in->ptr;
@@ -163,6 +213,13 @@ namespace embree
       accels[i]->immutable();
   }
   
+  void AccelN::compactMemory ()
+  {
+    parallel_for (accels.size(), [&] (size_t i) { 
+        accels[i]->compactMemory();
+      });
+  }
+  
   void AccelN::build () 
   {
     /* build all acceleration structures in parallel */
@@ -172,6 +229,7 @@ namespace embree
 
     /* create list of non-empty acceleration structures */
     validAccels.clear();
+    validBounds.clear();
     bool valid1 = true;
     bool valid4 = true;
     bool valid8 = true;
@@ -179,6 +237,11 @@ namespace embree
     for (size_t i=0; i<accels.size(); i++) {
       if (accels[i]->bounds.empty()) continue;
       validAccels.push_back(accels[i]);
+
+      /* enlarge bounds slightly to never cull rays the acceleration structure would hit */
+      const BBox3fa b = accels[i]->bounds.bounds();
+      const float eps = 4.0f*float(ulp)*reduce_max(max(abs(b.lower),abs(b.upper)));
+      validBounds.push_back(BBox3fa(b.lower-Vec3fa(eps),b.upper+Vec3fa(eps)));
       valid1 &= (bool) accels[i]->intersectors.intersector1;
       valid4 &= (bool) accels[i]->intersectors.intersector4;
       valid8 &= (bool) accels[i]->intersectors.intersector8;
@@ -191,7 +254,10 @@ namespace embree
     else 
     {
       intersectors.ptr = this;
-      intersectors.intersector1  = Intersector1(&intersect,&occluded,valid1 ? "AccelN::intersector1": nullptr);
+      if (ordered)
+        intersectors.intersector1 = Intersector1(&intersectOrdered,&occludedOrdered,valid1 ? "AccelN::intersector1Ordered": nullptr);
+      else
+        intersectors.intersector1 = Intersector1(&intersect,&occluded,valid1 ? "AccelN::intersector1": nullptr);
       intersectors.intersector4  = Intersector4(&intersect4,&occluded4,valid4 ? "AccelN::intersector4" : nullptr);
       intersectors.intersector8  = Intersector8(&intersect8,&occluded8,valid8 ? "AccelN::intersector8" : nullptr);
       intersectors.intersector16 = Intersector16(&intersect16,&occluded16,valid16 ? "AccelN::intersector16": nullptr);
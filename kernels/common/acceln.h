@@ -20,7 +20,9 @@
 
 namespace embree
 {
-  /*! merges N acceleration structures together, by processing them in order */
+  /*! merges N acceleration structures together, if ordered is set
+   *  single rays process them front to back and skip the ones they
+   *  miss, otherwise all rays process them in order */
   class AccelN : public Accel
   {
   public:
@@ -37,6 +39,7 @@ namespace embree
     static void intersect8 (const void* valid, Accel::Intersectors* This, RTCRayHit8& ray, IntersectContext* context);
     static void intersect16 (const void* valid, Accel::Intersectors* This, RTCRayHit16& ray, IntersectContext* context);
     static void intersectN (Accel::Intersectors* This, RTCRayHitN** ray, const size_t N, IntersectContext* context);
+    static void intersectOrdered (Accel::Intersectors* This, RTCRayHit& ray, IntersectContext* context);
 
   public:
     static void occluded (Accel::Intersectors* This, RTCRay& ray, IntersectContext* context);
@@ -44,6 +47,7 @@ namespace embree
     static void occluded8 (const void* valid, Accel::Intersectors* This, RTCRay8& ray, IntersectContext* context);
     static void occluded16 (const void* valid, Accel::Intersectors* This, RTCRay16& ray, IntersectContext* context);
     static void occludedN (Accel::Intersectors* This, RTCRayN** ray, const size_t N, IntersectContext* context);
+    static void occludedOrdered (Accel::Intersectors* This, RTCRay& ray, IntersectContext* context);
 
   public:
     void print(size_t ident);
@@ -52,9 +56,12 @@ namespace embree
     void select(bool filter);
     void deleteGeometry(size_t geomID);
     void clear ();
+    void compactMemory ();
 
   public:
     darray_t<Accel*,24> accels;
     darray_t<Accel*,24> validAccels;
+    darray_t<BBox3fa,24> validBounds;  //!< conservative bounds of valid acceleration structures
+    bool ordered;                      //!< traverse single rays front to back through the valid acceleration structures
   };
 }
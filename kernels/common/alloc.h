@@ -222,6 +222,11 @@ namespace embree
 
   private:
 
+    template<typename T>
+    static __forceinline void swapAtomic(std::atomic<T>& a, std::atomic<T>& b) {
+      T t = a.load(); a.store(b.load()); b.store(t);
+    }
+
     /*! returns both fast thread local allocators */
     __forceinline ThreadLocal2* threadLocal2() 
     {
@@ -462,6 +467,28 @@ namespace embree
       thread_local_allocators.clear();
     }
 
+    /*! exchanges the memory blocks of two allocators */
+    void swap(FastAllocator& other)
+    {
+      cleanup();
+      other.cleanup();
+
+      swapAtomic(usedBlocks,other.usedBlocks);
+      swapAtomic(freeBlocks,other.freeBlocks);
+      for (size_t i=0; i<MAX_THREAD_USED_BLOCK_SLOTS; i++) {
+        swapAtomic(threadUsedBlocks[i],other.threadUsedBlocks[i]);
+        swapAtomic(threadBlocks[i],other.threadBlocks[i]);
+      }
+      swapAtomic(bytesUsed,other.bytesUsed);
+      swapAtomic(bytesFree,other.bytesFree);
+      swapAtomic(bytesWasted,other.bytesWasted);
+
+      /* the shared primref array may hold nodes of morton builds */
+      mvector<PrimRef> primrefs(std::move(primrefarray));
+      primrefarray = std::move(other.primrefarray);
+      other.primrefarray = std::move(primrefs);
+    }
+
     /*! frees all allocated memory */
     __forceinline void clear()
     {
@@ -687,6 +714,16 @@ namespace embree
         std::cout << "  2M    : " << stat_2M.str(numPrimitives) << std::endl;
         std::cout << "  malloc: " << stat_malloc.str(numPrimitives) << std::endl;
         std::cout << "  shared: " << stat_shared.str(numPrimitives) << std::endl;
+
+        const OSPageStatistics pages = os_page_statistics();
+        std::stringstream str2;
+        str2.setf(std::ios::fixed, std::ios::floatfield);
+        str2 << "  pages : "
+             << "os = " << std::setw(7) << std::setprecision(3) << 1E-6f*pages.bytesAllocated << " MB, "
+             << "hugetlb = " << std::setw(7) << std::setprecision(3) << 1E-6f*pages.bytesHugeTLB << " MB, "
+             << "thp = " << std::setw(7) << std::setprecision(3) << 1E-6f*pages.bytesTransparentHugePages << " MB, "
+             << "interleave failures = " << pages.numInterleaveFailures;
+        std::cout << str2.str() << std::endl;
       }
 
     private:
@@ -746,6 +783,8 @@ namespace embree
             const size_t alignment = maxAlignment;
             if (device) device->memoryMonitor(bytesAllocate+alignment,false);
             ptr = alignedMalloc(bytesAllocate,alignment);
+            os_register_malloc(ptr,bytesAllocate);
+            os_prefault(ptr,bytesAllocate);
 
             /* give hint to transparently convert these pages to 2MB pages */
             const size_t ptr_aligned_begin = ((size_t)ptr) & ~size_t(PAGE_SIZE_2M-1);
@@ -760,6 +799,8 @@ namespace embree
             const size_t alignment = maxAlignment;
             if (device) device->memoryMonitor(bytesAllocate+alignment,false);
             ptr = alignedMalloc(bytesAllocate,alignment);
+            os_register_malloc(ptr,bytesAllocate);
+            os_prefault(ptr,bytesAllocate);
             return new (ptr) Block(ALIGNED_MALLOC,bytesAllocate-sizeof_Header,bytesAllocate-sizeof_Header,next,alignment);
           }
         }
@@ -767,6 +808,7 @@ namespace embree
         {
           if (device) device->memoryMonitor(bytesAllocate,false);
           bool huge_pages; ptr = os_malloc(bytesReserve,huge_pages);
+          os_prefault(ptr,bytesAllocate); // only prefault the allocated part, the reserved part gets committed on demand
           return new (ptr) Block(OS_MALLOC,bytesAllocate-sizeof_Header,bytesReserve-sizeof_Header,next,0,huge_pages);
         }
         else
@@ -807,6 +849,7 @@ namespace embree
         const ssize_t sizeof_Alloced = wasted+sizeof_Header+getBlockAllocatedBytes();
 
         if (atype == ALIGNED_MALLOC) {
+          os_unregister_malloc(this,sizeof_Header+getBlockAllocatedBytes());
           alignedFree(this);
           if (device) device->memoryMonitor(-sizeof_Alloced,true);
         }
@@ -260,4 +260,30 @@ namespace embree
       vfloat4::storeu((float*)(ptr_ofs + i*stride), (vfloat4)v);
     }
   };
+
+  /*! loads N indices stored as unsigned shorts or unsigned chars */
+  template<int N>
+  __forceinline void decodeIndices(const char* ptr, RTCFormat format, uint32_t* v)
+  {
+    if (format == RTC_FORMAT_USHORT3 || format == RTC_FORMAT_USHORT4) {
+      for (size_t i=0; i<N; i++) v[i] = ((const unsigned short*)ptr)[i];
+    } else {
+      for (size_t i=0; i<N; i++) v[i] = ((const unsigned char*)ptr)[i];
+    }
+  }
+
+  /*! decodes a vertex stored as 3 half precision floats or as 3 normalized unsigned shorts */
+  __forceinline Vec3fa decodeCompactVertex(const char* ptr, RTCFormat format)
+  {
+    const unsigned short* p = (const unsigned short*) ptr;
+    const vint4 h(p[0],p[1],p[2],0);
+    if (format == RTC_FORMAT_USHORT3)
+      return Vec3fa(vfloat4(h)*vfloat4(1.0f/65535.0f));
+
+    /* shift exponent and mantissa into place and rebias exponent by multiplying with 2^112 */
+    const vint4 em = h & 0x7FFF;
+    const vfloat4 f = asFloat(em << 13) * asFloat(vint4(0x77800000));
+    const vfloat4 g = select(em >= 0x7C00, asFloat((em << 13) | 0x7F800000), f); // Inf and NaN
+    return Vec3fa(asFloat(asInt(g) | ((h & 0x8000) << 16)));
+  }
 }
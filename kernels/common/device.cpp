@@ -72,6 +72,7 @@ namespace embree
       State::hugepages_success &= win_enable_selockmemoryprivilege(State::verbosity(3));
 #endif
     State::hugepages_success &= os_init(State::hugepages,State::verbosity(3));
+    os_set_page_policy(State::transparent_hugepages,State::prefault_pages,State::interleave_pages,State::verbosity(1));
     
     /*! set tessellation cache size */
     setCacheSize( State::tessellation_cache_size );
@@ -327,6 +328,17 @@ namespace embree
   void Device::initTaskingSystem(size_t numThreads) 
   {
     Lock<MutexSys> lock(g_mutex);
+
+#if defined(TASKING_INTERNAL)
+    /* devices with isolated threads neither use nor resize the shared thread pool */
+    if (State::isolated_threads)
+    {
+      if (!threadPool) threadPool.reset(new TaskScheduler::ThreadPool(State::set_affinity,State::first_core));
+      threadPool->setNumThreads(numThreads ? numThreads : std::numeric_limits<size_t>::max(),State::start_threads);
+      return;
+    }
+#endif
+
     if (numThreads == 0) 
       g_num_threads_map[this] = std::numeric_limits<size_t>::max();
     else 
@@ -343,6 +355,14 @@ namespace embree
   void Device::exitTaskingSystem() 
   {
     Lock<MutexSys> lock(g_mutex);
+
+#if defined(TASKING_INTERNAL)
+    if (threadPool) {
+      threadPool.reset();
+      return;
+    }
+#endif
+
     g_num_threads_map.erase(this);
 
     /* terminate tasking system */
@@ -370,6 +390,18 @@ namespace embree
     case 1000003: debug_int3 = val; return;
     }
 
+    /* documented properties */
+    switch (prop)
+    {
+    case RTC_DEVICE_PROPERTY_NUM_THREADS:
+      if (val < 0) throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "invalid number of threads");
+      State::numThreads = val;
+      initTaskingSystem(val);
+      return;
+
+    default: break;
+    }
+
     throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "unknown writable property");
   }
 
@@ -451,8 +483,15 @@ namespace embree
 
 #if defined(TASKING_INTERNAL)
     case RTC_DEVICE_PROPERTY_TASKING_SYSTEM: return 0;
+    case RTC_DEVICE_PROPERTY_NUM_THREADS: return threadPool ? threadPool->size() : TaskScheduler::threadCount();
+#else
+    case RTC_DEVICE_PROPERTY_NUM_THREADS: return TaskScheduler::threadCount();
 #endif
 
+    case RTC_DEVICE_PROPERTY_OS_ALLOCATED_BYTES: return os_page_statistics().bytesAllocated;
+    case RTC_DEVICE_PROPERTY_HUGETLB_BYTES: return os_page_statistics().bytesHugeTLB;
+    case RTC_DEVICE_PROPERTY_TRANSPARENT_HUGE_PAGE_BYTES: return os_page_statistics().bytesTransparentHugePages;
+
 #if defined(TASKING_TBB)
     case RTC_DEVICE_PROPERTY_TASKING_SYSTEM: return 1;
 #endif
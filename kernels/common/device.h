@@ -67,6 +67,20 @@ namespace embree
     /*! gets a property */
     ssize_t getProperty(const RTCDeviceProperty prop);
 
+    /*! executes the closure such that the parallel algorithms it calls run on the threads of this device */
+    template<typename Closure>
+      void execute(const Closure& closure)
+    {
+#if defined(TASKING_INTERNAL)
+      if (threadPool && !TaskScheduler::isRunningTask()) {
+        Ref<TaskScheduler> scheduler = new TaskScheduler(threadPool.get(),hierarchical_stealing);
+        scheduler->spawn_root(closure);
+        return;
+      }
+#endif
+      closure();
+    }
+
   private:
 
     /*! initializes the tasking system */
@@ -91,6 +105,10 @@ namespace embree
 #if USE_TASK_ARENA
     std::unique_ptr<tbb::task_arena> arena;
 #endif
+
+#if defined(TASKING_INTERNAL)
+    std::unique_ptr<TaskScheduler::ThreadPool> threadPool; //!< isolated thread pool of this device, or nullptr when using the shared one
+#endif
     
     /* ray streams filter */
     RayStreamFilterFuncs rayStreamFilters;
@@ -223,6 +223,14 @@ namespace embree
       throw_RTCError(RTC_ERROR_INVALID_OPERATION,"operation not supported for this geometry"); 
     }
 
+    /*! sets scale and offset to decode compact vertex positions */
+    virtual void setVertexQuantization(const Vec3fa& scale, const Vec3fa& offset) {
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"operation not supported for this geometry"); 
+    }
+
+    /*! returns true if vertices can not be loaded directly through premultiplied 32 bit offsets */
+    virtual bool hasIndirectVertices() const { return false; }
+
     /*! Set user data pointer. */
     virtual void setUserData(void* ptr);
       
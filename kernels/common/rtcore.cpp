@@ -227,6 +227,27 @@ namespace embree
     RTC_CATCH_END2(scene);
     return RTC_SCENE_FLAG_NONE;
   }
+
+  RTC_API void rtcSetSceneMemoryBudget (RTCScene hscene, size_t bytes) 
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcSetSceneMemoryBudget);
+    RTC_VERIFY_HANDLE(hscene);
+    scene->setMemoryBudget(bytes);
+    RTC_CATCH_END2(scene);
+  }
+
+  RTC_API RTCSceneMemoryFallback rtcGetSceneMemoryFallback(RTCScene hscene)
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcGetSceneMemoryFallback);
+    RTC_VERIFY_HANDLE(hscene);
+    return scene->getMemoryFallback();
+    RTC_CATCH_END2(scene);
+    return RTC_SCENE_MEMORY_FALLBACK_NONE;
+  }
   
   RTC_API void rtcCommitScene (RTCScene hscene) 
   {
@@ -248,6 +269,16 @@ namespace embree
     RTC_CATCH_END2(scene);
   }
 
+  RTC_API void rtcCompactScene (RTCScene hscene) 
+  {
+    Scene* scene = (Scene*) hscene;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcCompactScene);
+    RTC_VERIFY_HANDLE(hscene);
+    scene->compactMemory();
+    RTC_CATCH_END2(scene);
+  }
+
   RTC_API void rtcGetSceneBounds(RTCScene hscene, RTCBounds* bounds_o)
   {
     Scene* scene = (Scene*) hscene;
@@ -1119,6 +1150,18 @@ namespace embree
     RTC_CATCH_END2(geometry);
   }
 
+  RTC_API void rtcSetGeometryVertexQuantization (RTCGeometry hgeometry, const float* scale, const float* offset)
+  {
+    Ref<Geometry> geometry = (Geometry*) hgeometry;
+    RTC_CATCH_BEGIN;
+    RTC_TRACE(rtcSetGeometryVertexQuantization);
+    RTC_VERIFY_HANDLE(hgeometry);
+    RTC_VERIFY_HANDLE(scale);
+    RTC_VERIFY_HANDLE(offset);
+    geometry->setVertexQuantization(Vec3fa(scale[0],scale[1],scale[2]),Vec3fa(offset[0],offset[1],offset[2]));
+    RTC_CATCH_END2(geometry);
+  }
+
   RTC_API void rtcSetGeometrySubdivisionMode (RTCGeometry hgeometry, unsigned topologyID, RTCSubdivisionMode mode) 
   {
     Ref<Geometry> geometry = (Geometry*) hgeometry;
@@ -1407,7 +1450,7 @@ namespace embree
     RTC_CATCH_BEGIN;
     RTC_TRACE(rtcCommitGeometry);
     RTC_VERIFY_HANDLE(hgeometry);
-    return geometry->commit();
+    geometry->device->execute([&] { geometry->commit(); });
     RTC_CATCH_END2(geometry);
   }
 
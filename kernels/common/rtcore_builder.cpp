@@ -28,15 +28,43 @@
 
 #include "../builders/bvh_builder_sah.h"
 #include "../builders/bvh_builder_morton.h"
+#include "../builders/bvh_builder_msmblur.h"
 
 namespace embree
 { 
   namespace isa // FIXME: support more ISAs for builders
   {
+    /*! reference to a user node together with its entry in the recorded topology */
+    struct BuildRef
+    {
+      __forceinline BuildRef () {}
+
+      __forceinline BuildRef (void* ptr, unsigned int id)
+        : ptr(ptr), id(id) {}
+
+    public:
+      void* ptr;
+      unsigned int id;
+    };
+
     struct BVH : public RefCount
     {
+      static const unsigned int INVALID_ID = -1;
+
+      /*! node of the BVH topology recorded for refitting */
+      struct RefitNode
+      {
+        void* ptr;     //!< user node or leaf
+        size_t begin;  //!< first child entry or first primitive
+        size_t end;    //!< end of child entries or primitives
+        size_t size;   //!< number of primitives of the subtree
+        bool leaf;
+      };
+
       BVH (Device* device)
-        : device(device), allocator(device,true), morton_src(device,0), morton_tmp(device,0)
+        : device(device), allocator(device,true), morton_src(device,0), morton_tmp(device,0),
+          refitNodes(device,0), refitChildren(device,0), numRefitNodes(0), numRefitChildren(0),
+          recordTopology(false), refitMB(false), refitRoot(INVALID_ID), refitPrimitiveCount(0)
       {
         device->refInc();
       }
@@ -45,13 +73,140 @@ namespace embree
         device->refDec();
       }
 
+      /*! prepares recording of the topology of a BVH over up to numPrimitives primitive references */
+      void initTopology(bool record, bool mb, size_t numPrimitives)
+      {
+        clearTopology();
+        recordTopology = record;
+        refitMB = mb;
+        if (!record) return;
+        refitNodes.resize(2*numPrimitives+1);
+        refitChildren.resize(2*numPrimitives+1);
+      }
+
+      /*! finishes recording of the topology */
+      void finishTopology(const BuildRef& root)
+      {
+        if (!recordTopology) return;
+        refitRoot = root.ptr ? root.id : INVALID_ID;
+        refitPrimitiveCount = 0;
+        for (size_t i=0; i<numRefitNodes; i++)
+          if (refitNodes[i].leaf) refitPrimitiveCount = max(refitPrimitiveCount,refitNodes[i].end);
+      }
+
+      /*! frees the recorded topology */
+      void clearTopology()
+      {
+        refitNodes.clear();
+        refitChildren.clear();
+        numRefitNodes = numRefitChildren = 0;
+        recordTopology = false;
+        refitRoot = INVALID_ID;
+        refitPrimitiveCount = 0;
+      }
+
+      /*! records a leaf over the primitives [begin,end) */
+      unsigned int recordLeaf(void* ptr, size_t begin, size_t end)
+      {
+        if (!recordTopology) return INVALID_ID;
+        const size_t id = numRefitNodes++;
+        RefitNode& node = refitNodes[id];
+        node.ptr = ptr; node.begin = begin; node.end = end; node.size = end-begin; node.leaf = true;
+        return (unsigned int) id;
+      }
+
+      /*! records an inner node, its children get set using recordChild */
+      unsigned int recordNode(void* ptr, size_t numChildren, size_t size)
+      {
+        if (!recordTopology) return INVALID_ID;
+        const size_t begin = numRefitChildren.fetch_add(numChildren);
+        const size_t id = numRefitNodes++;
+        RefitNode& node = refitNodes[id];
+        node.ptr = ptr; node.begin = begin; node.end = begin+numChildren; node.size = size; node.leaf = false;
+        return (unsigned int) id;
+      }
+
+      /*! records an inner node over already recorded children */
+      unsigned int recordNode(void* ptr, const BuildRef* children, size_t numChildren)
+      {
+        if (!recordTopology) return INVALID_ID;
+        size_t size = 0;
+        for (size_t i=0; i<numChildren; i++)
+          size += refitNodes[children[i].id].size;
+        const unsigned int id = recordNode(ptr,numChildren,size);
+        for (size_t i=0; i<numChildren; i++)
+          recordChild(id,i,children[i]);
+        return id;
+      }
+
+      /*! sets the i'th child of a recorded inner node */
+      __forceinline void recordChild(unsigned int node, size_t i, const BuildRef& child)
+      {
+        if (!recordTopology) return;
+        refitChildren[refitNodes[node].begin+i] = child.id;
+      }
+
     public:
       Device* device;
       FastAllocator allocator;
       mvector<BVHBuilderMorton::BuildPrim> morton_src;
       mvector<BVHBuilderMorton::BuildPrim> morton_tmp;
+
+      mvector<RefitNode> refitNodes;          //!< recorded nodes and leaves
+      mvector<unsigned int> refitChildren;    //!< child entries of recorded inner nodes
+      std::atomic<size_t> numRefitNodes;
+      std::atomic<size_t> numRefitChildren;
+      bool recordTopology;                    //!< true if the topology gets recorded during build
+      bool refitMB;                           //!< true if the topology got recorded for a motion blur build
+      unsigned int refitRoot;                 //!< root of the recorded topology
+      size_t refitPrimitiveCount;             //!< number of primitive references the topology refers to
     };
 
+    /*! recomputes the bounds of a recorded subtree bottom up and passes them to setNode */
+    template<typename BBox, typename PrimitiveBounds, typename SetNode>
+    BBox refitTopology(BVH* bvh, unsigned int id, const PrimitiveBounds& primitiveBounds, const SetNode& setNode)
+    {
+      const BVH::RefitNode& node = bvh->refitNodes[id];
+
+      if (node.leaf)
+      {
+        BBox bounds = empty;
+        for (size_t i=node.begin; i<node.end; i++)
+          bounds.extend(primitiveBounds(i));
+        return bounds;
+      }
+
+      const size_t N = node.end-node.begin;
+      BBox cbounds[GeneralBVHBuilder::MAX_BRANCHING_FACTOR];
+      if (node.size > 1024)
+      {
+        parallel_for(size_t(0), N, [&] (const range<size_t>& r) {
+            for (size_t i=r.begin(); i<r.end(); i++)
+              cbounds[i] = refitTopology<BBox>(bvh,bvh->refitChildren[node.begin+i],primitiveBounds,setNode);
+          });
+      }
+      else
+      {
+        for (size_t i=0; i<N; i++)
+          cbounds[i] = refitTopology<BBox>(bvh,bvh->refitChildren[node.begin+i],primitiveBounds,setNode);
+      }
+
+      setNode(node,cbounds,N);
+
+      BBox bounds = empty;
+      for (size_t i=0; i<N; i++)
+        bounds.extend(cbounds[i]);
+      return bounds;
+    }
+
+    /*! returns the linear bounds of a motion blur build primitive */
+    __forceinline LBBox3fa linearBounds(const RTCBuildPrimitiveMB& prim)
+    {
+      const BBox3fa bounds0(Vec3fa(prim.lower0_x,prim.lower0_y,prim.lower0_z),Vec3fa(prim.upper0_x,prim.upper0_y,prim.upper0_z));
+      const BBox3fa bounds1(Vec3fa(prim.lower1_x,prim.lower1_y,prim.lower1_z),Vec3fa(prim.upper1_x,prim.upper1_y,prim.upper1_z));
+      return LBBox3fa(bounds0,bounds1);
+    }
+
     RTC_API RTCBVH rtcNewBVH(RTCDevice device)
     {
       RTC_CATCH_BEGIN;
@@ -103,7 +258,7 @@ namespace embree
         });
 
       /* start morton build */
-      std::pair<void*,BBox3fa> root = BVHBuilderMorton::build<std::pair<void*,BBox3fa>>(
+      std::pair<BuildRef,BBox3fa> root = BVHBuilderMorton::build<std::pair<BuildRef,BBox3fa>>(
         
         /* thread local allocator for fast allocations */
         [&] () -> FastAllocator::CachedAllocator { 
@@ -116,28 +271,36 @@ namespace embree
         },
         
         /* lambda function that sets bounds */
-        [&] (void* node, const std::pair<void*,BBox3fa>* children, size_t N) -> std::pair<void*,BBox3fa>
+        [&] (void* node, const std::pair<BuildRef,BBox3fa>* children, size_t N) -> std::pair<BuildRef,BBox3fa>
         {
           BBox3fa bounds = empty;
           void* childptrs[BVHBuilderMorton::MAX_BRANCHING_FACTOR];
+          BuildRef childrefs[BVHBuilderMorton::MAX_BRANCHING_FACTOR];
           const RTCBounds* cbounds[BVHBuilderMorton::MAX_BRANCHING_FACTOR];
           for (size_t i=0; i<N; i++) {
             bounds.extend(children[i].second);
-            childptrs[i] = children[i].first;
+            childptrs[i] = children[i].first.ptr;
+            childrefs[i] = children[i].first;
             cbounds[i] = (const RTCBounds*)&children[i].second;
           }
           setNodeBounds(node,cbounds,(unsigned int)N,userPtr);
           setNodeChildren(node,childptrs, (unsigned int)N,userPtr);
-          return std::make_pair(node,bounds);
+          return std::make_pair(BuildRef(node,bvh->recordNode(node,childrefs,N)),bounds);
         },
         
         /* lambda function that creates BVH leaves */
-        [&]( const range<unsigned>& current, const FastAllocator::CachedAllocator& alloc) -> std::pair<void*,BBox3fa>
+        [&]( const range<unsigned>& current, const FastAllocator::CachedAllocator& alloc) -> std::pair<BuildRef,BBox3fa>
         {
-          const size_t id = morton_src[current.begin()].index;
-          const BBox3fa bounds = prims[id].bounds(); 
-          void* node = createLeaf((RTCThreadLocalAllocator)&alloc,prims_i+current.begin(),current.size(),userPtr);
-          return std::make_pair(node,bounds);
+          RTCBuildPrimitive localBuildPrims[RTC_BUILD_MAX_PRIMITIVES_PER_LEAF];
+          BBox3fa bounds = empty;
+          for (size_t i=0; i<current.size(); i++)
+          {
+            const size_t id = morton_src[current.begin()+i].index;
+            bounds.extend(prims[id].bounds());
+            localBuildPrims[i] = prims_i[id];
+          }
+          void* node = createLeaf((RTCThreadLocalAllocator)&alloc,localBuildPrims,current.size(),userPtr);
+          return std::make_pair(BuildRef(node,bvh->recordLeaf(node,current.begin(),current.end())),bounds);
         },
         
         /* lambda that calculates the bounds for some primitive */
@@ -156,8 +319,21 @@ namespace embree
         morton_src.data(),morton_tmp.data(),primitiveCount,
         *arguments);
 
+      /* reorder primitives such that leaves reference consecutive ranges */
+      if (bvh->recordTopology)
+      {
+        mvector<PrimRef> tmp(bvh->device,primitiveCount);
+        parallel_for(size_t(0), primitiveCount, [&](const range<size_t>& r) {
+            for (size_t i=r.begin(); i<r.end(); i++) tmp[i] = prims[morton_src[i].index];
+          });
+        parallel_for(size_t(0), primitiveCount, [&](const range<size_t>& r) {
+            for (size_t i=r.begin(); i<r.end(); i++) prims[i] = tmp[i];
+          });
+      }
+
+      bvh->finishTopology(root.first);
       bvh->allocator.cleanup();
-      return root.first;
+      return root.first.ptr;
     }
 
     void* rtcBuildBVHBinnedSAH(const RTCBuildArguments* arguments)
@@ -188,7 +364,7 @@ namespace embree
       const PrimInfo pinfo(0,primitiveCount,bounds);
       
       /* build BVH */
-      void* root = BVHBuilderBinnedSAH::build<void*>(
+      BuildRef root = BVHBuilderBinnedSAH::build<BuildRef>(
         
         /* thread local allocator for fast allocations */
         [&] () -> FastAllocator::CachedAllocator { 
@@ -206,14 +382,18 @@ namespace embree
         },
 
         /* lambda function that updates BVH nodes */
-        [&](const BVHBuilderBinnedSAH::BuildRecord& precord, const BVHBuilderBinnedSAH::BuildRecord* crecords, void* node, void** children, const size_t N) -> void* {
-          setNodeChildren(node,children, (unsigned int)N,userPtr);
-          return node;
+        [&](const BVHBuilderBinnedSAH::BuildRecord& precord, const BVHBuilderBinnedSAH::BuildRecord* crecords, void* node, BuildRef* children, const size_t N) -> BuildRef
+        {
+          void* childptrs[GeneralBVHBuilder::MAX_BRANCHING_FACTOR];
+          for (size_t i=0; i<N; i++) childptrs[i] = children[i].ptr;
+          setNodeChildren(node,childptrs, (unsigned int)N,userPtr);
+          return BuildRef(node,bvh->recordNode(node,children,N));
         },
         
         /* lambda function that creates BVH leaves */
-        [&](const PrimRef* prims, const range<size_t>& range, const FastAllocator::CachedAllocator& alloc) -> void* {
-          return createLeaf((RTCThreadLocalAllocator)&alloc,(RTCBuildPrimitive*)(prims+range.begin()),range.size(),userPtr);
+        [&](const PrimRef* prims, const range<size_t>& range, const FastAllocator::CachedAllocator& alloc) -> BuildRef {
+          void* node = createLeaf((RTCThreadLocalAllocator)&alloc,(RTCBuildPrimitive*)(prims+range.begin()),range.size(),userPtr);
+          return BuildRef(node,bvh->recordLeaf(node,range.begin(),range.end()));
         },
         
         /* progress monitor function */
@@ -226,8 +406,9 @@ namespace embree
         
         (PrimRef*)prims,pinfo,*arguments);
         
+      bvh->finishTopology(root);
       bvh->allocator.cleanup();
-      return root;
+      return root.ptr;
     }
 
     void* rtcBuildBVHSpatialSAH(const RTCBuildArguments* arguments)
@@ -285,7 +466,7 @@ namespace embree
       };
 
       /* build BVH */
-      void* root = BVHBuilderBinnedFastSpatialSAH::build<void*>(
+      BuildRef root = BVHBuilderBinnedFastSpatialSAH::build<BuildRef>(
         
         /* thread local allocator for fast allocations */
         [&] () -> FastAllocator::CachedAllocator { 
@@ -303,14 +484,18 @@ namespace embree
         },
 
         /* lambda function that updates BVH nodes */
-        [&] (const BVHBuilderBinnedFastSpatialSAH::BuildRecord& precord, const BVHBuilderBinnedFastSpatialSAH::BuildRecord* crecords, void* node, void** children, const size_t N) -> void* {
-          setNodeChildren(node,children, (unsigned int)N,userPtr);
-          return node;
+        [&] (const BVHBuilderBinnedFastSpatialSAH::BuildRecord& precord, const BVHBuilderBinnedFastSpatialSAH::BuildRecord* crecords, void* node, BuildRef* children, const size_t N) -> BuildRef
+        {
+          void* childptrs[GeneralBVHBuilder::MAX_BRANCHING_FACTOR];
+          for (size_t i=0; i<N; i++) childptrs[i] = children[i].ptr;
+          setNodeChildren(node,childptrs, (unsigned int)N,userPtr);
+          return BuildRef(node,bvh->recordNode(node,children,N));
         },
         
         /* lambda function that creates BVH leaves */
-        [&] (const PrimRef* prims, const range<size_t>& range, const FastAllocator::CachedAllocator& alloc) -> void* {
-          return createLeaf((RTCThreadLocalAllocator)&alloc,(RTCBuildPrimitive*)(prims+range.begin()),range.size(),userPtr);
+        [&] (const PrimRef* prims, const range<size_t>& range, const FastAllocator::CachedAllocator& alloc) -> BuildRef {
+          void* node = createLeaf((RTCThreadLocalAllocator)&alloc,(RTCBuildPrimitive*)(prims+range.begin()),range.size(),userPtr);
+          return BuildRef(node,bvh->recordLeaf(node,range.begin(),range.end()));
         },
         
         /* returns the splitter */
@@ -330,8 +515,163 @@ namespace embree
         arguments->primitiveArrayCapacity,
         pinfo,*arguments);
         
+      bvh->finishTopology(root);
       bvh->allocator.cleanup();
-      return root;
+      return root.ptr;
+    }
+
+    /*! recalculates primitive references over a time range for linear motion build primitives */
+    struct RecalculateBuildPrimRefMB
+    {
+      const RTCBuildPrimitiveMB* prims;
+
+      __forceinline RecalculateBuildPrimRefMB (const RTCBuildPrimitiveMB* prims)
+        : prims(prims) {}
+
+      __forceinline PrimRefMB operator() (const PrimRefMB& prim, const BBox1f time_range) const {
+        return PrimRefMB(linearBounds(prim,time_range),1,1,prim.ID());
+      }
+
+      __forceinline LBBox3fa linearBounds(const PrimRefMB& prim, const BBox1f time_range) const {
+        return embree::isa::linearBounds(prims[prim.ID()]).interpolate(time_range);
+      }
+    };
+
+    /*! creates user nodes for the motion blur builder, children and bounds are set after the build */
+    struct CreateNodeMB
+    {
+      BVH* bvh;
+      RTCCreateNodeFunction createNode;
+      void* userPtr;
+
+      __forceinline CreateNodeMB (BVH* bvh, RTCCreateNodeFunction createNode, void* userPtr)
+        : bvh(bvh), createNode(createNode), userPtr(userPtr) {}
+
+      template<typename BuildRecord>
+      __forceinline BuildRef operator() (BuildRecord* children, const size_t N, const FastAllocator::CachedAllocator& alloc, bool hasTimeSplits) const
+      {
+        size_t size = 0;
+        for (size_t i=0; i<N; i++) size += children[i].size();
+        void* node = createNode((RTCThreadLocalAllocator)&alloc,(unsigned int)N,userPtr);
+        return BuildRef(node,bvh->recordNode(node,N,size));
+      }
+    };
+
+    void* rtcBuildBVHMSMBlur(const RTCBuildArguments* arguments)
+    {
+      BVH* bvh = (BVH*) arguments->bvh;
+      RTCBuildPrimitiveMB* prims_i = arguments->primitivesMB;
+      size_t primitiveCount = arguments->primitiveCount;
+      RTCSetNodeChildrenFunction setNodeChildren = arguments->setNodeChildren;
+      RTCSetNodeLinearBoundsFunction setNodeLinearBounds = arguments->setNodeLinearBounds;
+      RTCCreateLeafMBFunction createLeafMB = arguments->createLeafMB;
+      RTCProgressMonitorFunction buildProgress = arguments->buildProgress;
+      void* userPtr = arguments->userPtr;
+
+      std::atomic<size_t> progress(0);
+
+      /* create primitive references with a single linear time segment */
+      mvector<PrimRefMB> prims(bvh->device,primitiveCount);
+      auto createPrimRefs = [&](const range<size_t>& r) -> PrimInfoMB
+        {
+          PrimInfoMB pinfo(empty);
+          for (size_t i=r.begin(); i<r.end(); i++) {
+            prims[i] = PrimRefMB(linearBounds(prims_i[i]),1,1,i);
+            pinfo.add_primref(prims[i]);
+          }
+          return pinfo;
+        };
+      const PrimInfoMB pinfo =
+        parallel_reduce(size_t(0),primitiveCount,size_t(1024),size_t(1024),PrimInfoMB(empty), createPrimRefs, PrimInfoMB::merge2);
+
+      /* settings for BVH build */
+      BVHBuilderMSMBlur::Settings settings;
+      if (RTC_BUILD_ARGUMENTS_HAS((*arguments),maxBranchingFactor)) settings.branchingFactor = arguments->maxBranchingFactor;
+      if (RTC_BUILD_ARGUMENTS_HAS((*arguments),maxDepth          )) settings.maxDepth        = arguments->maxDepth;
+      if (RTC_BUILD_ARGUMENTS_HAS((*arguments),sahBlockSize      )) settings.logBlockSize    = bsr(arguments->sahBlockSize);
+      if (RTC_BUILD_ARGUMENTS_HAS((*arguments),minLeafSize       )) settings.minLeafSize     = arguments->minLeafSize;
+      if (RTC_BUILD_ARGUMENTS_HAS((*arguments),maxLeafSize       )) settings.maxLeafSize     = arguments->maxLeafSize;
+      if (RTC_BUILD_ARGUMENTS_HAS((*arguments),traversalCost     )) settings.travCost        = arguments->traversalCost;
+      if (RTC_BUILD_ARGUMENTS_HAS((*arguments),intersectionCost  )) settings.intCost         = arguments->intersectionCost;
+
+      /* build BVH */
+      const BVHNodeRecordMB4D<BuildRef> root = BVHBuilderMSMBlur::build<BuildRef>(
+        prims,pinfo,bvh->device,
+
+        /* recalculates primitive references for temporal splits */
+        RecalculateBuildPrimRefMB(prims_i),
+
+        /* thread local allocator for fast allocations */
+        [&] () -> FastAllocator::CachedAllocator { 
+          return bvh->allocator.getCachedAllocator();
+        },
+
+        /* creates BVH nodes */
+        CreateNodeMB(bvh,arguments->createNode,userPtr),
+
+        /* lambda function that sets a child of a BVH node */
+        [&] (const BuildRef& node, size_t i, const BVHNodeRecordMB4D<BuildRef>& child) {
+          bvh->recordChild(node.id,i,child.ref);
+        },
+
+        /* lambda function that creates BVH leaves */
+        [&] (const BVHBuilderMSMBlur::BuildRecord& current, const FastAllocator::CachedAllocator& alloc) -> BVHNodeRecordMB4D<BuildRef>
+        {
+          RTCBuildPrimitiveMB localBuildPrims[RTC_BUILD_MAX_PRIMITIVES_PER_LEAF];
+          const range<size_t> r = current.prims.object_range;
+          LBBox3fa bounds = empty;
+          for (size_t i=0; i<r.size(); i++)
+          {
+            const size_t id = prims[r.begin()+i].ID();
+            bounds.extend(linearBounds(prims_i[id]));
+            localBuildPrims[i] = prims_i[id];
+          }
+          void* node = createLeafMB((RTCThreadLocalAllocator)&alloc,localBuildPrims,r.size(),userPtr);
+          return BVHNodeRecordMB4D<BuildRef>(BuildRef(node,bvh->recordLeaf(node,r.begin(),r.end())),bounds,current.prims.time_range);
+        },
+
+        /* progress monitor function */
+        [&] (size_t dn) {
+          if (!buildProgress) return true;
+          const size_t n = progress.fetch_add(dn)+dn;
+          const double f = std::min(1.0,double(n)/double(primitiveCount));
+          return buildProgress(userPtr,f);
+        },
+
+        settings);
+
+      /* reorder primitives such that leaves reference consecutive ranges */
+      {
+        mvector<LBBox3fa> tmp(bvh->device,primitiveCount);
+        parallel_for(size_t(0), primitiveCount, [&](const range<size_t>& r) {
+            for (size_t i=r.begin(); i<r.end(); i++) tmp[i] = (const LBBox3fa&) prims_i[prims[i].ID()];
+          });
+        parallel_for(size_t(0), primitiveCount, [&](const range<size_t>& r) {
+            for (size_t i=r.begin(); i<r.end(); i++) (LBBox3fa&) prims_i[i] = tmp[i];
+          });
+      }
+
+      /* set children and linear bounds of all nodes */
+      bvh->finishTopology(root.ref);
+      if (bvh->refitRoot != BVH::INVALID_ID)
+      {
+        refitTopology<LBBox3fa>(bvh,bvh->refitRoot,
+          [&] (size_t i) { return linearBounds(prims_i[i]); },
+          [&] (const BVH::RefitNode& node, const LBBox3fa* cbounds, size_t N)
+          {
+            void* childptrs[GeneralBVHBuilder::MAX_BRANCHING_FACTOR];
+            const RTCLinearBounds* clbounds[GeneralBVHBuilder::MAX_BRANCHING_FACTOR];
+            for (size_t i=0; i<N; i++) {
+              childptrs[i] = bvh->refitNodes[bvh->refitChildren[node.begin+i]].ptr;
+              clbounds[i] = (const RTCLinearBounds*) &cbounds[i];
+            }
+            setNodeLinearBounds(node.ptr,clbounds,(unsigned int)N,userPtr);
+            setNodeChildren(node.ptr,childptrs,(unsigned int)N,userPtr);
+          });
+      }
+
+      bvh->allocator.cleanup();
+      return root.ref.ptr;
     }
 
     RTC_API void* rtcBuildBVH(const RTCBuildArguments* arguments)
@@ -343,41 +683,122 @@ namespace embree
       RTC_VERIFY_HANDLE(arguments);
       RTC_VERIFY_HANDLE(arguments->createNode);
       RTC_VERIFY_HANDLE(arguments->setNodeChildren);
-      RTC_VERIFY_HANDLE(arguments->setNodeBounds);
-      RTC_VERIFY_HANDLE(arguments->createLeaf);
 
-      if (arguments->primitiveArrayCapacity < arguments->primitiveCount)
+      const bool motionBlur = RTC_BUILD_ARGUMENTS_HAS((*arguments),createLeafMB) && arguments->primitivesMB;
+      if (motionBlur) {
+        RTC_VERIFY_HANDLE(arguments->setNodeLinearBounds);
+        RTC_VERIFY_HANDLE(arguments->createLeafMB);
+      } else {
+        RTC_VERIFY_HANDLE(arguments->setNodeBounds);
+        RTC_VERIFY_HANDLE(arguments->createLeaf);
+      }
+
+      if (!motionBlur && arguments->primitiveArrayCapacity < arguments->primitiveCount)
         throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"primitiveArrayCapacity must be greater or equal to primitiveCount")
 
-      /* initialize the allocator */
-      bvh->allocator.init_estimate(arguments->primitiveCount*sizeof(BBox3fa));
-      bvh->allocator.reset();
-
-      /* switch between differnet builders based on quality level */
-      if (arguments->buildQuality == RTC_BUILD_QUALITY_LOW)
-        return rtcBuildBVHMorton(arguments);
-      else if (arguments->buildQuality == RTC_BUILD_QUALITY_MEDIUM)
-        return rtcBuildBVHBinnedSAH(arguments);
-      else if (arguments->buildQuality == RTC_BUILD_QUALITY_HIGH) {
-        if (arguments->splitPrimitive == nullptr || arguments->primitiveArrayCapacity <= arguments->primitiveCount)
-          return rtcBuildBVHBinnedSAH(arguments);
+      const bool lowQuality = arguments->buildQuality == RTC_BUILD_QUALITY_LOW;
+      if ((motionBlur || lowQuality) && arguments->maxLeafSize > RTC_BUILD_MAX_PRIMITIVES_PER_LEAF)
+        throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"maxLeafSize must not exceed RTC_BUILD_MAX_PRIMITIVES_PER_LEAF");
+
+      /* the build runs on the threads of the device */
+      void* root = nullptr;
+      bvh->device->execute([&] {
+        /* initialize the allocator */
+        bvh->allocator.init_estimate(arguments->primitiveCount*sizeof(BBox3fa));
+        bvh->allocator.reset();
+
+        /* the motion blur builder always records the topology to set children and bounds after the build */
+        const bool refit = arguments->buildFlags & RTC_BUILD_FLAG_REFIT;
+        bvh->initTopology(refit || motionBlur, motionBlur, motionBlur ? arguments->primitiveCount : arguments->primitiveArrayCapacity);
+
+        /* switch between differnet builders based on quality level */
+        if (motionBlur)
+          root = rtcBuildBVHMSMBlur(arguments);
+        else if (arguments->buildQuality == RTC_BUILD_QUALITY_LOW)
+          root = rtcBuildBVHMorton(arguments);
+        else if (arguments->buildQuality == RTC_BUILD_QUALITY_MEDIUM)
+          root = rtcBuildBVHBinnedSAH(arguments);
+        else if (arguments->buildQuality == RTC_BUILD_QUALITY_HIGH) {
+          if (arguments->splitPrimitive == nullptr || arguments->primitiveArrayCapacity <= arguments->primitiveCount)
+            root = rtcBuildBVHBinnedSAH(arguments);
+          else
+            root = rtcBuildBVHSpatialSAH(arguments);
+        }
         else
-          return rtcBuildBVHSpatialSAH(arguments);
-      }
-      else
-        throw_RTCError(RTC_ERROR_INVALID_OPERATION,"invalid build quality");
+          throw_RTCError(RTC_ERROR_INVALID_OPERATION,"invalid build quality");
 
-      /* if we are in dynamic mode, then do not clear temporary data */
-      if (!(arguments->buildFlags & RTC_BUILD_FLAG_DYNAMIC))
-      {
-        bvh->morton_src.clear();
-        bvh->morton_tmp.clear();
-      }
+        /* if we are in dynamic mode, then do not clear temporary data */
+        if (!(arguments->buildFlags & RTC_BUILD_FLAG_DYNAMIC))
+        {
+          bvh->morton_src.clear();
+          bvh->morton_tmp.clear();
+        }
+
+        /* the topology is only kept for refitting */
+        if (!refit)
+          bvh->clearTopology();
+      });
 
+      return root;
       RTC_CATCH_END(bvh->device);
       return nullptr;
     }
 
+    RTC_API void rtcRefitBVH(const RTCBuildArguments* arguments)
+    {
+      BVH* bvh = (BVH*) arguments->bvh;
+      RTC_CATCH_BEGIN;
+      RTC_TRACE(rtcRefitBVH);
+      RTC_VERIFY_HANDLE(bvh);
+      RTC_VERIFY_HANDLE(arguments);
+
+      if (bvh->refitNodes.size() == 0)
+        throw_RTCError(RTC_ERROR_INVALID_OPERATION,"BVH was not built with RTC_BUILD_FLAG_REFIT");
+
+      const bool motionBlur = RTC_BUILD_ARGUMENTS_HAS((*arguments),createLeafMB) && arguments->primitivesMB;
+      if (motionBlur != bvh->refitMB)
+        throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"primitive type does not match the type used to build the BVH");
+
+      if (max(arguments->primitiveCount,arguments->primitiveArrayCapacity) < bvh->refitPrimitiveCount)
+        throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"primitive array is smaller than the one used to build the BVH");
+
+      if (bvh->refitRoot == BVH::INVALID_ID)
+        return;
+
+      bvh->device->execute([&] {
+        void* userPtr = arguments->userPtr;
+        if (motionBlur)
+        {
+          RTC_VERIFY_HANDLE(arguments->setNodeLinearBounds);
+          const RTCBuildPrimitiveMB* prims = arguments->primitivesMB;
+          RTCSetNodeLinearBoundsFunction setNodeLinearBounds = arguments->setNodeLinearBounds;
+          refitTopology<LBBox3fa>(bvh,bvh->refitRoot,
+            [&] (size_t i) { return linearBounds(prims[i]); },
+            [&] (const BVH::RefitNode& node, const LBBox3fa* cbounds, size_t N)
+            {
+              const RTCLinearBounds* clbounds[GeneralBVHBuilder::MAX_BRANCHING_FACTOR];
+              for (size_t i=0; i<N; i++) clbounds[i] = (const RTCLinearBounds*) &cbounds[i];
+              setNodeLinearBounds(node.ptr,clbounds,(unsigned int)N,userPtr);
+            });
+        }
+        else
+        {
+          RTC_VERIFY_HANDLE(arguments->setNodeBounds);
+          const PrimRef* prims = (const PrimRef*) arguments->primitives;
+          RTCSetNodeBoundsFunction setNodeBounds = arguments->setNodeBounds;
+          refitTopology<BBox3fa>(bvh,bvh->refitRoot,
+            [&] (size_t i) { return prims[i].bounds(); },
+            [&] (const BVH::RefitNode& node, const BBox3fa* cbounds, size_t N)
+            {
+              const RTCBounds* crbounds[GeneralBVHBuilder::MAX_BRANCHING_FACTOR];
+              for (size_t i=0; i<N; i++) crbounds[i] = (const RTCBounds*) &cbounds[i];
+              setNodeBounds(node.ptr,crbounds,(unsigned int)N,userPtr);
+            });
+        }
+      });
+      RTC_CATCH_END(bvh->device);
+    }
+
     RTC_API void* rtcThreadLocalAlloc(RTCThreadLocalAllocator localAllocator, size_t bytes, size_t align)
     {
       FastAllocator::CachedAllocator* alloc = (FastAllocator::CachedAllocator*) localAllocator;
@@ -396,6 +817,7 @@ namespace embree
       RTC_VERIFY_HANDLE(hbvh);
       bvh->morton_src.clear();
       bvh->morton_tmp.clear();
+      bvh->clearTopology();
       RTC_CATCH_END(bvh->device);
     }
 
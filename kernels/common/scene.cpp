@@ -35,7 +35,8 @@ namespace embree
       flags_modified(true),
       scene_flags(RTC_SCENE_FLAG_NONE),
       quality_flags(RTC_BUILD_QUALITY_MEDIUM),
-      is_build(false), modified(true),
+      memory_budget(device->scene_memory_budget), memory_fallback(RTC_SCENE_MEMORY_FALLBACK_NONE),
+      is_build(false), modified(true), indirectVertices(false),
       progressInterface(this), progress_monitor_function(nullptr), progress_monitor_ptr(nullptr), progress_monitor_counter(0), 
       numIntersectionFiltersN(0)
   {
@@ -50,6 +51,7 @@ namespace embree
 #endif
 
     intersectors = Accel::Intersectors(missing_rtcCommit);
+    accels.ordered = device->ordered_accels;
 
     /* one can overwrite flags through device for debugging */
     if (device->quality_flags != -1)
@@ -673,6 +675,13 @@ namespace embree
           geometries[i]->preCommit();
       });
 
+    /* select cheaper acceleration structures if the scene would exceed its memory budget */
+    const RTCSceneMemoryFallback fallback = selectMemoryFallback();
+    if (fallback != memory_fallback) {
+      memory_fallback = fallback;
+      flags_modified = true;
+    }
+
     /* select acceleration structures to build */
     if (flags_modified)
     {    
@@ -706,6 +715,10 @@ namespace embree
     if (!isDynamicAccel()) {
       accels.immutable();
       flags_modified = true; // in non-dynamic mode we have to re-create accels
+
+      /* copy the BVHs into the configured cache friendly layout */
+      if (device->bvh_layout != "default")
+        accels.compactMemory();
     }
 
     /* call postCommit function of each geometry */
@@ -713,6 +726,12 @@ namespace embree
         if (geometries[i] && geometries[i]->isEnabled())
           geometries[i]->postCommit();
       });
+
+    /* indexed triangles and quads have to load vertices through the mesh for compact formats and huge vertex buffers */
+    indirectVertices = false;
+    for (size_t i=0; i<geometries.size(); i++)
+      if (geometries[i] && geometries[i]->isEnabled() && geometries[i]->hasIndirectVertices())
+        indirectVertices = true;
       
     updateInterface();
 
@@ -726,6 +745,18 @@ namespace embree
     setModified(false);
   }
 
+  void Scene::compactMemory()
+  {
+    Lock<MutexSys> lock(buildMutex);
+    if (!isBuild() || isModified())
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION,"scene got not committed");
+
+    accels.compactMemory();
+
+    /* the builders got released, thus the next commit has to create new acceleration structures */
+    flags_modified = true;
+  }
+
   void Scene::setBuildQuality(RTCBuildQuality quality_flags_i)
   {
     if (quality_flags == quality_flags_i) return;
@@ -747,6 +778,66 @@ namespace embree
   RTCSceneFlags Scene::getSceneFlags() const {
     return scene_flags;
   }
+
+  void Scene::setMemoryBudget(size_t bytes)
+  {
+    if (memory_budget == bytes) return;
+    memory_budget = bytes;
+    setModified();
+  }
+
+  RTCSceneMemoryFallback Scene::getMemoryFallback() const {
+    return memory_fallback;
+  }
+
+  size_t Scene::estimateMemory(RTCSceneMemoryFallback fallback) const
+  {
+    /* the estimates follow the builders: 8 bytes of BVH4 or BVH8 nodes
+     * per primitive, 20% slack for partially filled leaves, and one
+     * temporary PrimRef per primitive reference during the build */
+    const bool compact = (scene_flags & RTC_SCENE_FLAG_COMPACT) || fallback >= RTC_SCENE_MEMORY_FALLBACK_COMPACT;
+    const bool spatial = quality_flags == RTC_BUILD_QUALITY_HIGH && !compact && !isRobustAccel() && fallback < RTC_SCENE_MEMORY_FALLBACK_NO_SPATIAL_SPLITS;
+    const double replications = spatial ? max(1.0f,device->max_spatial_split_replications) : 1.0;
+    const double nodeBytes = 8.0;
+    const double primRefBytes = 32.0;
+    const double triangleBytes = 1.2*(compact ?  80.0 : 176.0)/4.0; // Triangle4i : Triangle4 or Triangle4v
+    const double quadBytes     = 1.2*(compact ?  96.0 : 224.0)/4.0; // Quad4i : Quad4v
+
+    double bytes = 0.0;
+    bytes += replications*double(world.numTriangles)*(triangleBytes+nodeBytes+primRefBytes);
+    bytes += replications*double(world.numQuads    )*(quadBytes    +nodeBytes+primRefBytes);
+
+    /* the remaining geometry types are not affected by the fallbacks, motion blur
+     * builders use 64 byte PrimRefMB and store two bounds per node child */
+    const double otherBytes = 32.0;
+    const size_t numOther = world.size() - world.numTriangles - world.numQuads;
+    bytes += double(numOther)*(otherBytes+nodeBytes+primRefBytes);
+    bytes += double(worldMB.size())*(2.0*otherBytes+2.0*nodeBytes+2.0*primRefBytes);
+    return size_t(bytes);
+  }
+
+  RTCSceneMemoryFallback Scene::selectMemoryFallback() const
+  {
+    if (memory_budget == 0)
+      return RTC_SCENE_MEMORY_FALLBACK_NONE;
+
+    static const char* names[] = { "none", "no spatial splits", "compact" };
+    RTCSceneMemoryFallback fallback = RTC_SCENE_MEMORY_FALLBACK_NONE;
+    size_t bytes = estimateMemory(fallback);
+    while (bytes > memory_budget && fallback < RTC_SCENE_MEMORY_FALLBACK_COMPACT) {
+      fallback = (RTCSceneMemoryFallback) (fallback+1);
+      bytes = estimateMemory(fallback);
+    }
+
+    if (device->verbosity(1) && fallback != RTC_SCENE_MEMORY_FALLBACK_NONE)
+    {
+      std::cout << "scene memory budget of " << 1E-6*double(memory_budget) << " MB exceeded by " << 1E-6*double(estimateMemory(RTC_SCENE_MEMORY_FALLBACK_NONE)) << " MB estimate, ";
+      std::cout << "using memory fallback \"" << names[fallback] << "\" with " << 1E-6*double(bytes) << " MB estimate";
+      if (bytes > memory_budget) std::cout << " (still over budget)";
+      std::cout << std::endl;
+    }
+    return fallback;
+  }
                    
 #if defined(TASKING_INTERNAL)
 
@@ -761,7 +852,7 @@ namespace embree
       scheduler = this->scheduler;
       if (scheduler == null) {
         buildLock.lock();
-        this->scheduler = scheduler = new TaskScheduler;
+        this->scheduler = scheduler = new TaskScheduler(device->threadPool.get(),device->hierarchical_stealing);
       }
     }
 
@@ -176,9 +176,19 @@ namespace embree
     
     void setSceneFlags(RTCSceneFlags scene_flags);
     RTCSceneFlags getSceneFlags() const;
+
+    void setMemoryBudget(size_t bytes);
+    RTCSceneMemoryFallback getMemoryFallback() const;
+
+    /*! estimates the peak memory consumption of building the scene with some memory fallback */
+    size_t estimateMemory(RTCSceneMemoryFallback fallback) const;
+
+    /*! selects the first memory fallback whose estimate fits into the memory budget */
+    RTCSceneMemoryFallback selectMemoryFallback() const;
     
     void commit (bool join);
     void commit_task ();
+    void compactMemory ();
     void build () {}
 
     void updateInterface();
@@ -230,7 +240,7 @@ namespace embree
 
     /* flag decoding */
     __forceinline bool isFastAccel() const { return !isCompactAccel() && !isRobustAccel(); }
-    __forceinline bool isCompactAccel() const { return scene_flags & RTC_SCENE_FLAG_COMPACT; }
+    __forceinline bool isCompactAccel() const { return (scene_flags & RTC_SCENE_FLAG_COMPACT) || memory_fallback >= RTC_SCENE_MEMORY_FALLBACK_COMPACT; }
     __forceinline bool isRobustAccel()  const { return scene_flags & RTC_SCENE_FLAG_ROBUST; }
     __forceinline bool isStaticAccel()  const { return !(scene_flags & RTC_SCENE_FLAG_DYNAMIC); }
     __forceinline bool isDynamicAccel() const { return scene_flags & RTC_SCENE_FLAG_DYNAMIC; }
@@ -248,6 +258,11 @@ namespace embree
     /* test if scene got already build */
     __forceinline bool isBuild() const { return is_build; }
 
+    /* maximal spatial split replications of the builders, spatial splits are disabled by the memory fallback */
+    __forceinline float maxSpatialSplitReplications() const {
+      return memory_fallback >= RTC_SCENE_MEMORY_FALLBACK_NO_SPATIAL_SPLITS ? 1.0f : device->max_spatial_split_replications;
+    }
+
   public:
     IDPool<unsigned,0xFFFFFFFE> id_pool;
     vector<Ref<Geometry>> geometries; //!< list of all user geometries
@@ -258,11 +273,14 @@ namespace embree
     bool flags_modified;
     RTCSceneFlags scene_flags;
     RTCBuildQuality quality_flags;
+    size_t memory_budget;                   //!< memory budget for building the scene, 0 means unlimited
+    RTCSceneMemoryFallback memory_fallback; //!< memory fallback selected by the last commit
     AccelN accels;
     MutexSys buildMutex;
     SpinLock geometriesMutex;
     bool is_build;
-    bool modified;                   //!< true if scene got modified
+    std::atomic<bool> modified;      //!< true if scene got modified, atomic as geometries may get attached and committed in parallel
+    bool indirectVertices;           //!< true if some mesh vertices can not be loaded through premultiplied offsets
     
     /*! global lock step task scheduler */
 #if defined(TASKING_INTERNAL) 
@@ -26,7 +26,7 @@ namespace embree
 #if defined(EMBREE_LOWEST_ISA)
 
   CurveGeometry::CurveGeometry (Device* device, GType gtype)
-    : Geometry(device,gtype,0,1), tessellationRate(4)
+    : Geometry(device,gtype,0,1), tessellationRate(4), flatness(device->curve_flatness)
   {
     vertices.resize(numTimeSteps);
   }
@@ -192,6 +192,7 @@ namespace embree
     BufferView<char> flags;                 //!< start, end flag per segment
     vector<BufferView<char>> vertexAttribs; //!< user buffers
     int tessellationRate;                   //!< tessellation rate for bezier curve
+    float flatness;                         //!< round curve segments flatter than this fraction of their radius get intersected without further subdivision
   };
   
   DECLARE_ISA_FUNCTION(CurveGeometry*, createCurves, Device* COMMA Geometry::GType);
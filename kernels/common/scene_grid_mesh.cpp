@@ -68,10 +68,6 @@ namespace embree
       if (format != RTC_FORMAT_FLOAT3)
         throw_RTCError(RTC_ERROR_INVALID_OPERATION, "invalid vertex buffer format");
 
-      /* if buffer is larger than 16GB the premultiplied index optimization does not work */
-      if (stride*num > 16ll*1024ll*1024ll*1024ll)
-        throw_RTCError(RTC_ERROR_INVALID_OPERATION, "vertex buffer can be at most 16GB large");
-
       if (slot >= vertices.size())
         throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "invalid vertex buffer slot");
 
@@ -48,6 +48,8 @@ namespace embree
     void enabling();
     void disabling();
     void setMask(unsigned mask);
+    void setVertexQuantization(const Vec3fa& scale, const Vec3fa& offset);
+    bool hasIndirectVertices() const;
     void setNumTimeSteps (unsigned int numTimeSteps);
     void setVertexAttributeCount (unsigned int N);
     void setBuffer(RTCBufferType type, unsigned int slot, RTCFormat format, const Ref<Buffer>& buffer, size_t offset, size_t stride, unsigned int num);
@@ -66,13 +68,17 @@ namespace embree
     }
     
     /*! returns i'th quad */
-    __forceinline const Quad& quad(size_t i) const {
-      return quads[i];
+    __forceinline const Quad quad(size_t i) const 
+    {
+      if (likely(quads.getFormat() == RTC_FORMAT_UINT4)) return quads[i];
+      Quad q; decodeIndices<4>(quads.getPtr(i),quads.getFormat(),q.v);
+      return q;
     }
 
     /*! returns i'th vertex of itime'th timestep */
     __forceinline const Vec3fa vertex(size_t i) const {
-      return vertices0[i];
+      if (likely(vertices0.getFormat() == RTC_FORMAT_FLOAT3)) return vertices0[i];
+      return decodeVertex(vertices0.getPtr(i),vertices0.getFormat());
     }
 
     /*! returns i'th vertex of itime'th timestep */
@@ -82,7 +88,8 @@ namespace embree
 
     /*! returns i'th vertex of itime'th timestep */
     __forceinline const Vec3fa vertex(size_t i, size_t itime) const {
-      return vertices[itime][i];
+      if (likely(vertices[itime].getFormat() == RTC_FORMAT_FLOAT3)) return vertices[itime][i];
+      return decodeVertex(vertices[itime].getPtr(i),vertices[itime].getFormat());
     }
 
     /*! returns i'th vertex of itime'th timestep */
@@ -90,6 +97,36 @@ namespace embree
       return vertices[itime].getPtr(i);
     }
 
+    /*! returns true if premultiplied 32 bit offsets can not address all vertices */
+    __forceinline bool hugeVertexBuffer() const {
+      return vertices0.bytes() > 16ll*1024ll*1024ll*1024ll;
+    }
+
+    /*! returns true if indexed primitives store vertex indices instead of
+     *  premultiplied 32 bit offsets, which is the case for huge vertex
+     *  buffers and for compact vertices whose stride is no multiple of 4 */
+    __forceinline bool vertexIndexOffsets() const {
+      return hugeVertexBuffer() || (vertices0.getStride() & 3);
+    }
+
+    /*! returns the factor to convert vertex indices into vertex offsets of indexed primitives */
+    __forceinline unsigned int vertexOffsetStride() const {
+      return vertexIndexOffsets() ? 1 : vertices0.getStride()/4;
+    }
+
+    /*! returns the vertex at the specified offset of the itime'th timestep */
+    __forceinline const Vec3fa vertexAtOffset(size_t ofs, size_t itime = 0) const
+    {
+      const char* ptr = vertices[itime].getPtr() + (vertexIndexOffsets() ? ofs*vertices0.getStride() : 4*ofs);
+      if (likely(vertices0.getFormat() == RTC_FORMAT_FLOAT3)) return Vec3fa::loadu(ptr);
+      return decodeVertex(ptr,vertices0.getFormat());
+    }
+
+    /*! decodes a vertex stored in a compact vertex format */
+    __forceinline const Vec3fa decodeVertex(const char* ptr, RTCFormat format) const {
+      return madd(decodeCompactVertex(ptr,format),vertexScale,vertexOffset);
+    }
+
     /*! calculates the bounds of the i'th quad */
     __forceinline BBox3fa bounds(size_t i) const 
     {
@@ -215,6 +252,8 @@ namespace embree
     BufferView<Vec3fa> vertices0;           //!< fast access to first vertex buffer
     vector<BufferView<Vec3fa>> vertices;    //!< vertex array for each timestep
     vector<BufferView<char>> vertexAttribs; //!< vertex attribute buffers
+    Vec3fa vertexScale;                     //!< scale to decode compact vertices
+    Vec3fa vertexOffset;                    //!< offset to decode compact vertices
   };
 
   namespace isa
@@ -23,6 +23,7 @@ namespace embree
 
   TriangleMesh::TriangleMesh (Device* device)
     : Geometry(device,GTY_TRIANGLE_MESH,0,1)
+    , vertexScale(one), vertexOffset(zero)
   {
     vertices.resize(numTimeSteps);
   }
@@ -45,6 +46,17 @@ namespace embree
     Geometry::update();
   }
 
+  void TriangleMesh::setVertexQuantization (const Vec3fa& scale, const Vec3fa& offset)
+  {
+    vertexScale = scale;
+    vertexOffset = offset;
+    Geometry::update();
+  }
+
+  bool TriangleMesh::hasIndirectVertices() const {
+    return vertices0.getFormat() != RTC_FORMAT_FLOAT3 || hugeVertexBuffer();
+  }
+
   void TriangleMesh::setNumTimeSteps (unsigned int numTimeSteps)
   {
     vertices.resize(numTimeSteps);
@@ -59,24 +71,24 @@ namespace embree
   
   void TriangleMesh::setBuffer(RTCBufferType type, unsigned int slot, RTCFormat format, const Ref<Buffer>& buffer, size_t offset, size_t stride, unsigned int num)
   {
-    /* verify that all accesses are 4 bytes aligned */
-    if (((size_t(buffer->getPtr()) + offset) & 0x3) || (stride & 0x3)) 
-      throw_RTCError(RTC_ERROR_INVALID_OPERATION, "data must be 4 bytes aligned");
+    /* verify that all accesses are 4 bytes aligned, 16 and 8 bit indices and vertices only need to be aligned to their size */
+    size_t align = 4;
+    if (type == RTC_BUFFER_TYPE_VERTEX && (format == RTC_FORMAT_HALF3 || format == RTC_FORMAT_USHORT3)) align = 2;
+    if (type == RTC_BUFFER_TYPE_INDEX && format == RTC_FORMAT_USHORT3) align = 2;
+    if (type == RTC_BUFFER_TYPE_INDEX && format == RTC_FORMAT_UCHAR3 ) align = 1;
+    if (((size_t(buffer->getPtr()) + offset) & (align-1)) || (stride & (align-1))) 
+      throw_RTCError(RTC_ERROR_INVALID_OPERATION, "data must be " + toString(align) + " bytes aligned");
 
     if (type == RTC_BUFFER_TYPE_VERTEX)
     {
-      if (format != RTC_FORMAT_FLOAT3)
+      if (format != RTC_FORMAT_FLOAT3 && format != RTC_FORMAT_HALF3 && format != RTC_FORMAT_USHORT3)
         throw_RTCError(RTC_ERROR_INVALID_OPERATION, "invalid vertex buffer format");
 
-      /* if buffer is larger than 16GB the premultiplied index optimization does not work */
-      if (stride*num > 16ll*1024ll*1024ll*1024ll)
-        throw_RTCError(RTC_ERROR_INVALID_OPERATION, "vertex buffer can be at most 16GB large");
-
       if (slot >= vertices.size())
         throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "invalid vertex buffer slot");
 
       vertices[slot].set(buffer, offset, stride, num, format);
-      vertices[slot].checkPadding16();
+      if (format == RTC_FORMAT_FLOAT3) vertices[slot].checkPadding16(); // compact formats are decoded without overfetch
       vertices0 = vertices[0];
     }
     else if (type == RTC_BUFFER_TYPE_VERTEX_ATTRIBUTE)
@@ -94,7 +106,7 @@ namespace embree
     {
       if (slot != 0)
         throw_RTCError(RTC_ERROR_INVALID_ARGUMENT, "invalid buffer slot");
-      if (format != RTC_FORMAT_UINT3)
+      if (format != RTC_FORMAT_UINT3 && format != RTC_FORMAT_USHORT3 && format != RTC_FORMAT_UCHAR3)
         throw_RTCError(RTC_ERROR_INVALID_OPERATION, "invalid index buffer format");
 
       triangles.set(buffer, offset, stride, num, format);
@@ -166,6 +178,11 @@ namespace embree
       if (vertices[t].getStride() != vertices[0].getStride())
         throw_RTCError(RTC_ERROR_INVALID_OPERATION,"stride of vertex buffers have to be identical for each time step");
 
+    /* verify that format of all time steps are identical */
+    for (unsigned int t=0; t<numTimeSteps; t++)
+      if (vertices[t].getFormat() != vertices[0].getFormat())
+        throw_RTCError(RTC_ERROR_INVALID_OPERATION,"format of vertex buffers have to be identical for each time step");
+
     Geometry::preCommit();
   }
 
@@ -197,15 +214,15 @@ namespace embree
 
     /*! verify triangle indices */
     for (size_t i=0; i<size(); i++) {     
-      if (triangles[i].v[0] >= numVertices()) return false; 
-      if (triangles[i].v[1] >= numVertices()) return false; 
-      if (triangles[i].v[2] >= numVertices()) return false; 
+      if (triangle(i).v[0] >= numVertices()) return false; 
+      if (triangle(i).v[1] >= numVertices()) return false; 
+      if (triangle(i).v[2] >= numVertices()) return false; 
     }
 
     /*! verify vertices */
-    for (const auto& buffer : vertices)
-      for (size_t i=0; i<buffer.size(); i++)
-	if (!isvalid(buffer[i])) 
+    for (size_t t=0; t<vertices.size(); t++)
+      for (size_t i=0; i<vertices[t].size(); i++)
+	if (!isvalid(vertex(i,t))) 
 	  return false;
 
     return true;
@@ -238,6 +255,9 @@ namespace embree
       src    = vertices[bufferSlot].getPtr();
       stride = vertices[bufferSlot].getStride();
     }
+
+    /* vertex positions stored in a compact format get decoded */
+    const bool decode = bufferType == RTC_BUFFER_TYPE_VERTEX && vertices[bufferSlot].getFormat() != RTC_FORMAT_FLOAT3;
     
     for (unsigned int i=0; i<valueCount; i+=4)
     {
@@ -245,9 +265,9 @@ namespace embree
       const float w = 1.0f-u-v;
       const Triangle& tri = triangle(primID);
       const vbool4 valid = vint4((int)i)+vint4(step) < vint4(int(valueCount));
-      const vfloat4 p0 = vfloat4::loadu(valid,(float*)&src[tri.v[0]*stride+ofs]);
-      const vfloat4 p1 = vfloat4::loadu(valid,(float*)&src[tri.v[1]*stride+ofs]);
-      const vfloat4 p2 = vfloat4::loadu(valid,(float*)&src[tri.v[2]*stride+ofs]);
+      const vfloat4 p0 = decode ? vfloat4(vertex(tri.v[0],bufferSlot)) : vfloat4::loadu(valid,(float*)&src[tri.v[0]*stride+ofs]);
+      const vfloat4 p1 = decode ? vfloat4(vertex(tri.v[1],bufferSlot)) : vfloat4::loadu(valid,(float*)&src[tri.v[1]*stride+ofs]);
+      const vfloat4 p2 = decode ? vfloat4(vertex(tri.v[2],bufferSlot)) : vfloat4::loadu(valid,(float*)&src[tri.v[2]*stride+ofs]);
       
       if (P) {
         vfloat4::storeu(valid,P+i,madd(w,p0,madd(u,p1,v*p2)));
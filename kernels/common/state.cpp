@@ -95,8 +95,14 @@ namespace embree
 
     max_spatial_split_replications = 2.0f;
 
+    curve_flatness = 0.0f;
+
     tessellation_cache_size = 128*1024*1024;
 
+    scene_memory_budget = 0;
+    bvh_layout = "default";
+    ordered_accels = false;
+
     subdiv_accel = "default";
     subdiv_accel_mb = "default";
 
@@ -127,6 +133,9 @@ namespace embree
     /* per default enable affinity on KNL */
     if (hasISA(AVX512KNL)) set_affinity = true;
 
+    hierarchical_stealing = true;
+    isolated_threads = false;
+    first_core = 0;
     start_threads = false;
     enable_selockmemoryprivilege = false;
 #if defined(__LINUX__)
@@ -135,6 +144,9 @@ namespace embree
     hugepages = false;
 #endif
     hugepages_success = true;
+    transparent_hugepages = true;
+    prefault_pages = false;
+    interleave_pages = false;
 
     alloc_main_block_size = 0;
     alloc_num_main_slots = 0;
@@ -254,6 +266,15 @@ namespace embree
       
       else if (tok == Token::Id("start_threads")&& cin->trySymbol("=")) 
         start_threads = cin->get().Int();
+
+      else if (tok == Token::Id("hierarchical_stealing")&& cin->trySymbol("=")) 
+        hierarchical_stealing = cin->get().Int();
+
+      else if (tok == Token::Id("isolated_threads")&& cin->trySymbol("=")) 
+        isolated_threads = cin->get().Int();
+
+      else if (tok == Token::Id("first_core")&& cin->trySymbol("=")) 
+        first_core = cin->get().Int();
       
       else if (tok == Token::Id("isa") && cin->trySymbol("=")) {
         std::string isa = toLowerCase(cin->get().Identifier());
@@ -278,6 +299,12 @@ namespace embree
       else if (tok == Token::Id("hugepages") && cin->trySymbol("=")) {
         hugepages = cin->get().Int();
       }
+      else if (tok == Token::Id("transparent_hugepages") && cin->trySymbol("="))
+        transparent_hugepages = cin->get().Int();
+      else if (tok == Token::Id("prefault_pages") && cin->trySymbol("="))
+        prefault_pages = cin->get().Int();
+      else if (tok == Token::Id("interleave_pages") && cin->trySymbol("="))
+        interleave_pages = cin->get().Int();
 
       else if (tok == Token::Id("ignore_config_files") && cin->trySymbol("="))
         ignore_config_files = cin->get().Int();
@@ -412,11 +439,24 @@ namespace embree
       else if (tok == Token::Id("max_spatial_split_replications") && cin->trySymbol("="))
         max_spatial_split_replications = cin->get().Float();
 
+      else if (tok == Token::Id("curve_flatness") && cin->trySymbol("="))
+        curve_flatness = cin->get().Float();
+
       else if (tok == Token::Id("tessellation_cache_size") && cin->trySymbol("="))
         tessellation_cache_size = size_t(cin->get().Float()*1024.0f*1024.0f);
       else if (tok == Token::Id("cache_size") && cin->trySymbol("="))
         tessellation_cache_size = size_t(cin->get().Float()*1024.0f*1024.0f);
 
+      else if (tok == Token::Id("scene_memory_budget") && cin->trySymbol("="))
+        scene_memory_budget = size_t(cin->get().Float()*1024.0f*1024.0f);
+      else if (tok == Token::Id("bvh_layout") && cin->trySymbol("=")) {
+        bvh_layout = cin->get().Identifier();
+        if (bvh_layout != "default" && bvh_layout != "depth_first" && bvh_layout != "treelets")
+          throw_RTCError(RTC_ERROR_INVALID_ARGUMENT,"unknown BVH layout "+bvh_layout);
+      }
+      else if (tok == Token::Id("ordered_accels") && cin->trySymbol("="))
+        ordered_accels = cin->get().Int();
+
       else if (tok == Token::Id("alloc_main_block_size") && cin->trySymbol("="))
         alloc_main_block_size = cin->get().Int();
        else if (tok == Token::Id("alloc_num_main_slots") && cin->trySymbol("="))
@@ -440,15 +480,25 @@ namespace embree
     std::cout << "  build threads = " << numThreads   << std::endl;
     std::cout << "  start_threads = " << start_threads << std::endl;
     std::cout << "  affinity      = " << set_affinity << std::endl;
+    std::cout << "  hierarchical stealing = " << hierarchical_stealing << std::endl;
+    std::cout << "  isolated threads = " << isolated_threads << std::endl;
+    std::cout << "  first core    = " << first_core << std::endl;
     
     std::cout << "  hugepages     = ";
     if (!hugepages) std::cout << "disabled" << std::endl;
     else if (hugepages_success) std::cout << "enabled" << std::endl;
     else std::cout << "failed" << std::endl;
+    std::cout << "  transparent_hugepages = " << transparent_hugepages << std::endl;
+    std::cout << "  prefault_pages = " << prefault_pages << std::endl;
+    std::cout << "  interleave_pages = " << interleave_pages << std::endl;
 
     std::cout << "  verbosity     = " << verbose << std::endl;
     std::cout << "  cache_size    = " << float(tessellation_cache_size)*1E-6 << " MB" << std::endl;
+    std::cout << "  scene_memory_budget = " << float(scene_memory_budget)*1E-6 << " MB" << std::endl;
+    std::cout << "  bvh_layout    = " << bvh_layout << std::endl;
+    std::cout << "  ordered_accels = " << ordered_accels << std::endl;
     std::cout << "  max_spatial_split_replications = " << max_spatial_split_replications << std::endl;
+    std::cout << "  curve_flatness = " << curve_flatness << std::endl;
     
     std::cout << "triangles:" << std::endl;
     std::cout << "  accel         = " << tri_accel << std::endl;
@@ -93,6 +93,9 @@ namespace embree
     std::string hair_builder_mb;           //!< builder to use for motion blur hair
     std::string hair_traverser_mb;         //!< traverser to use for motion blur hair
 
+  public:
+    float curve_flatness;                  //!< round curve segments flatter than this fraction of their radius are not subdivided further
+
   public:
     std::string object_accel;               //!< acceleration structure for user geometries
     std::string object_builder;             //!< builder for user geometries
@@ -118,6 +121,9 @@ namespace embree
   public:
     float max_spatial_split_replications;  //!< maximally replications*N many primitives in accel for spatial splits
     size_t tessellation_cache_size;        //!< size of the shared tessellation cache 
+    size_t scene_memory_budget;            //!< default memory budget of scenes, 0 means unlimited
+    std::string bvh_layout;                //!< memory layout of BVHs of static scenes
+    bool ordered_accels;                   //!< single rays traverse the acceleration structures of a scene front to back
 
   public:
     size_t instancing_open_min;            //!< instancing opens tree to minimally that number of subtrees
@@ -137,12 +143,18 @@ namespace embree
   public:
     size_t numThreads;                     //!< number of threads to use in builders
     bool set_affinity;                     //!< sets affinity for worker threads
+    bool hierarchical_stealing;            //!< worker threads prefer to steal from threads sharing their last level cache
+    bool isolated_threads;                 //!< device builds on its own thread pool instead of the shared one
+    size_t first_core;                     //!< first logical thread the isolated thread pool gets affinitized to
     bool start_threads;                    //!< true when threads should be started at device creation time
     int enabled_cpu_features;              //!< CPU ISA features to use
     int enabled_builder_cpu_features;      //!< CPU ISA features to use for builders only
     bool enable_selockmemoryprivilege;     //!< configures the SeLockMemoryPrivilege under Windows to enable huge pages
     bool hugepages;                        //!< true if huge pages should get used
     bool hugepages_success;                //!< status for enabling huge pages
+    bool transparent_hugepages;            //!< true if transparent huge pages should get advised
+    bool prefault_pages;                   //!< true if BVH blocks should get prefaulted when allocated
+    bool interleave_pages;                 //!< true if OS allocations should get interleaved over NUMA nodes
 
   public:
     size_t alloc_main_block_size;          //!< main allocation block size (shared between threads)
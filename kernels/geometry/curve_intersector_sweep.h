@@ -66,6 +66,14 @@ namespace embree
       return epilog(hit);
     }
 
+    template<typename Ray, typename Epilog>
+    __forceinline bool intersect_bezier_cylinder(const Ray& ray, const float dt, const float t, const float u, const Vec3fa& Ng, const Epilog& epilog)
+    {
+      if (!(t+dt > ray.tnear() && t+dt < ray.tfar)) return false;
+      BezierCurveHit hit(t+dt,u,Ng);
+      return epilog(hit);
+    }
+
     template<typename NativeCurve3fa, typename Ray, typename Epilog> 
      __forceinline bool intersect_bezier_iterative_jacobian(const Ray& ray, const float dt, const NativeCurve3fa& curve, float u, float t, const Epilog& epilog)
     {
@@ -127,7 +135,7 @@ namespace embree
 
     template<typename NativeCurve3fa, typename Ray, typename Epilog>
     bool intersect_bezier_recursive_jacobian(const Ray& ray, const float dt, const NativeCurve3fa& curve,
-                                             const float u0, const float u1, const size_t depth, const Epilog& epilog)
+                                             const float u0, const float u1, const size_t depth, const float flatness, const Epilog& epilog)
     {
       int maxDepth = numBezierSubdivisions;
       //int maxDepth = Device::debug_int1+1;
@@ -183,6 +191,9 @@ namespace embree
       vfloatx u_inner0; Vec3vfx Ng_inner0; vfloatx u_inner1; Vec3vfx Ng_inner1;
       const vboolx valid_inner = cylinder_inner.intersect(org,dir,tc_inner,u_inner0,Ng_inner0,u_inner1,Ng_inner1);
 
+      /* segments whose bounding cylinders enclose the surface tightly get intersected directly */
+      const vboolx flat = (r_outer-r_inner <= flatness*r_outer) & valid_inner & (flatness > 0.0f);
+
       /* at the unstable area we subdivide deeper */
       const vboolx unstable0 = (!valid_inner) | (abs(dot(Vec3vfx(normalize(ray.dir)),normalize(Ng_inner0))) < 0.3f);
       const vboolx unstable1 = (!valid_inner) | (abs(dot(Vec3vfx(normalize(ray.dir)),normalize(Ng_inner1))) < 0.3f);
@@ -200,9 +211,15 @@ namespace embree
       {
         const size_t i = select_min(valid0,tp0.lower); clear(valid0,i);
         const size_t termDepth = unstable0[i] ? maxDepth+1 : maxDepth;
-        if (depth >= termDepth) found = found | intersect_bezier_iterative_jacobian(ray,dt,curve,u_outer0[i],tp0.lower[i],epilog);
+        if (flat[i]) {
+          Vec3fa Ng = Vec3fa(Ng_outer0.x[i],Ng_outer0.y[i],Ng_outer0.z[i]);
+          if (h0.lower[i] == tp0.lower[i]) Ng = -Vec3fa(dP0du.x[i],dP0du.y[i],dP0du.z[i]);
+          if (h1.lower[i] == tp0.lower[i]) Ng = +Vec3fa(dP3du.x[i],dP3du.y[i],dP3du.z[i]);
+          found = found | intersect_bezier_cylinder(ray,dt,tp0.lower[i],u_outer0[i],Ng,epilog);
+        }
+        else if (depth >= termDepth) found = found | intersect_bezier_iterative_jacobian(ray,dt,curve,u_outer0[i],tp0.lower[i],epilog);
         //if (depth >= maxDepth) found = found | intersect_bezier_iterative_debug   (ray,dt,curve,i,u_outer0,tp0,h0,h1,Ng_outer0,dP0du,dP3du,epilog);
-        else                   found = found | intersect_bezier_recursive_jacobian(ray,dt,curve,vu0[i+0],vu0[i+1],depth+1,epilog);
+        else                   found = found | intersect_bezier_recursive_jacobian(ray,dt,curve,vu0[i+0],vu0[i+1],depth+1,flatness,epilog);
         valid0 &= tp0.lower+dt <= ray.tfar;
       }
       valid1 &= tp1.lower+dt <= ray.tfar;
@@ -212,9 +229,15 @@ namespace embree
       {
         const size_t i = select_min(valid1,tp1.lower); clear(valid1,i);
         const size_t termDepth = unstable1[i] ? maxDepth+1 : maxDepth;
-        if (depth >= termDepth) found = found | intersect_bezier_iterative_jacobian(ray,dt,curve,u_outer1[i],tp1.upper[i],epilog);
+        if (flat[i]) {
+          Vec3fa Ng = Vec3fa(Ng_outer1.x[i],Ng_outer1.y[i],Ng_outer1.z[i]);
+          if (h0.upper[i] == tp1.upper[i]) Ng = -Vec3fa(dP0du.x[i],dP0du.y[i],dP0du.z[i]);
+          if (h1.upper[i] == tp1.upper[i]) Ng = +Vec3fa(dP3du.x[i],dP3du.y[i],dP3du.z[i]);
+          found = found | intersect_bezier_cylinder(ray,dt,tp1.upper[i],u_outer1[i],Ng,epilog);
+        }
+        else if (depth >= termDepth) found = found | intersect_bezier_iterative_jacobian(ray,dt,curve,u_outer1[i],tp1.upper[i],epilog);
         //if (depth >= maxDepth) found = found | intersect_bezier_iterative_debug   (ray,dt,curve,i,u_outer1,tp1,h0,h1,Ng_outer1,dP0du,dP3du,epilog);
-        else                   found = found | intersect_bezier_recursive_jacobian(ray,dt,curve,vu0[i+0],vu0[i+1],depth+1,epilog);
+        else                   found = found | intersect_bezier_recursive_jacobian(ray,dt,curve,vu0[i+0],vu0[i+1],depth+1,flatness,epilog);
         valid1 &= tp1.lower+dt <= ray.tfar;
       }
       return found;
@@ -240,7 +263,7 @@ namespace embree
         const Vec3fa p3 = v3-ref;
 
         const NativeCurve3fa curve(p0,p1,p2,p3);
-        return intersect_bezier_recursive_jacobian(ray,dt,curve,0.0f,1.0f,1,epilog);
+        return intersect_bezier_recursive_jacobian(ray,dt,curve,0.0f,1.0f,1,geom->flatness,epilog);
       }
     };
 
@@ -282,7 +305,7 @@ namespace embree
         const Vec3fa p3 = v3-ref;
 
         const NativeCurve3fa curve(p0,p1,p2,p3);
-        return intersect_bezier_recursive_jacobian(ray,dt,curve,0.0f,1.0f,1,epilog);
+        return intersect_bezier_recursive_jacobian(ray,dt,curve,0.0f,1.0f,1,geom->flatness,epilog);
       }
     };
   }
@@ -77,8 +77,12 @@ namespace embree
     __forceinline const vuint<M>& primID() const { return primIDs; }
     __forceinline unsigned int primID(const size_t i) const { assert(i<M); return primIDs[i]; }
 
-    __forceinline Vec3f& getVertex(const vuint<M>& v, const size_t index, const Scene *const scene) const
+    __forceinline Vec3f getVertex(const vuint<M>& v, const size_t index, const Scene *const scene) const
     {
+      if (unlikely(scene->indirectVertices)) {
+        const Vec3fa p = scene->get<QuadMesh>(geomID(index))->vertexAtOffset(v[index]);
+        return Vec3f(p.x,p.y,p.z);
+      }
       const float* vertices = scene->vertices[geomID(index)];
       return (Vec3f&) vertices[v[index]];
     }
@@ -87,10 +91,8 @@ namespace embree
     __forceinline Vec3<T> getVertex(const vuint<M> &v, const size_t index, const Scene *const scene, const size_t itime, const T& ftime) const
     {
       const QuadMesh* mesh = scene->get<QuadMesh>(geomID(index));
-      const float* vertices0 = (const float*) mesh->vertexPtr(0,itime+0);
-      const float* vertices1 = (const float*) mesh->vertexPtr(0,itime+1);
-      const Vec3fa v0 = Vec3fa::loadu(vertices0+v[index]);
-      const Vec3fa v1 = Vec3fa::loadu(vertices1+v[index]);
+      const Vec3fa v0 = mesh->vertexAtOffset(v[index],itime+0);
+      const Vec3fa v1 = mesh->vertexAtOffset(v[index],itime+1);
       const Vec3<T> p0(v0.x,v0.y,v0.z);
       const Vec3<T> p1(v1.x,v1.y,v1.z);
       return lerp(p0,p1,ftime);
@@ -104,16 +106,26 @@ namespace embree
 
       for (size_t mask=movemask(valid), i=bsf(mask); mask; mask=btc(mask,i), i=bsf(mask))
       {
-        const float* vertices0 = (const float*) mesh->vertexPtr(0,itime[i]+0);
-        const float* vertices1 = (const float*) mesh->vertexPtr(0,itime[i]+1);
-        const Vec3fa v0 = Vec3fa::loadu(vertices0+v[index]);
-        const Vec3fa v1 = Vec3fa::loadu(vertices1+v[index]);
+        const Vec3fa v0 = mesh->vertexAtOffset(v[index],itime[i]+0);
+        const Vec3fa v1 = mesh->vertexAtOffset(v[index],itime[i]+1);
         p0.x[i] = v0.x; p0.y[i] = v0.y; p0.z[i] = v0.z;
         p1.x[i] = v1.x; p1.y[i] = v1.y; p1.z[i] = v1.z;
       }
       return (T(one)-ftime)*p0 + ftime*p1;
     }
 
+    /* loads M vertices through the meshes, required for compact vertex formats and huge vertex buffers */
+    __forceinline Vec3vf<M> decodeVertices(const vuint<M>& v, const Scene *const scene, const vint<M>& itime) const
+    {
+      Vec3vf<M> p;
+      for (size_t i=0; i<M; i++)
+      {
+        const Vec3fa p_i = scene->get<QuadMesh>(geomID(i))->vertexAtOffset(v[i],itime[i]);
+        p.x[i] = p_i.x; p.y[i] = p_i.y; p.z[i] = p_i.z;
+      }
+      return p;
+    }
+
     /* Gather the quads */
     __forceinline void gather(Vec3vf<M>& p0,
                               Vec3vf<M>& p1,
@@ -184,11 +196,11 @@ namespace embree
       BBox3fa bounds = empty;
       for (size_t i=0; i<M && valid(i); i++)
       {
-        const float* vertices = (const float*) scene->get<QuadMesh>(geomID(i))->vertexPtr(0,itime);
-        bounds.extend(Vec3fa::loadu(vertices+v0[i]));
-        bounds.extend(Vec3fa::loadu(vertices+v1[i]));
-        bounds.extend(Vec3fa::loadu(vertices+v2[i]));
-        bounds.extend(Vec3fa::loadu(vertices+v3[i]));
+        const QuadMesh* mesh = scene->get<QuadMesh>(geomID(i));
+        bounds.extend(mesh->vertexAtOffset(v0[i],itime));
+        bounds.extend(mesh->vertexAtOffset(v1[i],itime));
+        bounds.extend(mesh->vertexAtOffset(v2[i],itime));
+        bounds.extend(mesh->vertexAtOffset(v3[i],itime));
       }
       return bounds;
     }
@@ -236,7 +248,7 @@ namespace embree
         if (begin<end) {
           geomID[i] = prim->geomID();
           primID[i] = prim->primID();
-          unsigned int_stride = mesh->vertices0.getStride()/4;
+          unsigned int_stride = mesh->vertexOffsetStride();
           v0[i] = q.v[0] * int_stride;
           v1[i] = q.v[1] * int_stride;
           v2[i] = q.v[2] * int_stride;
@@ -313,6 +325,16 @@ namespace embree
   {
     prefetchL1(((char*)this)+0*64);
     prefetchL1(((char*)this)+1*64);
+
+    if (unlikely(scene->indirectVertices))
+    {
+      p0 = decodeVertices(v0,scene,vint4(zero));
+      p1 = decodeVertices(v1,scene,vint4(zero));
+      p2 = decodeVertices(v2,scene,vint4(zero));
+      p3 = decodeVertices(v3,scene,vint4(zero));
+      return;
+    }
+
     const float* vertices0 = scene->vertices[geomID(0)];
     const float* vertices1 = scene->vertices[geomID(1)];
     const float* vertices2 = scene->vertices[geomID(2)];
@@ -347,6 +369,19 @@ namespace embree
                                        Vec3vf16& p3,
                                        const Scene *const scene) const // FIXME: why do we have this special path here and not for triangles?
   {
+    if (unlikely(scene->indirectVertices))
+    {
+      const Vec3vf4 a0 = decodeVertices(v0,scene,vint4(zero));
+      const Vec3vf4 a1 = decodeVertices(v1,scene,vint4(zero));
+      const Vec3vf4 a2 = decodeVertices(v2,scene,vint4(zero));
+      const Vec3vf4 a3 = decodeVertices(v3,scene,vint4(zero));
+      p0 = Vec3vf16(vfloat16(a0.x),vfloat16(a0.y),vfloat16(a0.z));
+      p1 = Vec3vf16(vfloat16(a1.x),vfloat16(a1.y),vfloat16(a1.z));
+      p2 = Vec3vf16(vfloat16(a2.x),vfloat16(a2.y),vfloat16(a2.z));
+      p3 = Vec3vf16(vfloat16(a3.x),vfloat16(a3.y),vfloat16(a3.z));
+      return;
+    }
+
     const vint16 perm(0,4,8,12,1,5,9,13,2,6,10,14,3,7,11,15);
     const float* vertices0 = scene->vertices[geomID(0)];
     const float* vertices1 = scene->vertices[geomID(1)];
@@ -449,6 +484,15 @@ namespace embree
     vfloat4 ftime;
     const vint4 itime = getTimeSegment(vfloat4(time), numTimeSegments, ftime);
 
+    if (unlikely(scene->indirectVertices))
+    {
+      p0 = lerp(decodeVertices(v0,scene,itime),decodeVertices(v0,scene,itime+1),ftime);
+      p1 = lerp(decodeVertices(v1,scene,itime),decodeVertices(v1,scene,itime+1),ftime);
+      p2 = lerp(decodeVertices(v2,scene,itime),decodeVertices(v2,scene,itime+1),ftime);
+      p3 = lerp(decodeVertices(v3,scene,itime),decodeVertices(v3,scene,itime+1),ftime);
+      return;
+    }
+
     Vec3vf4 a0,a1,a2,a3; gather(a0,a1,a2,a3,mesh0,mesh1,mesh2,mesh3,itime);
     Vec3vf4 b0,b1,b2,b3; gather(b0,b1,b2,b3,mesh0,mesh1,mesh2,mesh3,itime+1);
     p0 = lerp(a0,b0,ftime);
@@ -75,8 +75,12 @@ namespace embree
     __forceinline unsigned int primID(const size_t i) const { assert(i<M); return primIDs[i]; }
 
     /* loads a single vertex */
-    __forceinline Vec3f& getVertex(const vuint<M>& v, const size_t index, const Scene *const scene) const
+    __forceinline Vec3f getVertex(const vuint<M>& v, const size_t index, const Scene *const scene) const
     {
+      if (unlikely(scene->indirectVertices)) {
+        const Vec3fa p = scene->get<TriangleMesh>(geomID(index))->vertexAtOffset(v[index]);
+        return Vec3f(p.x,p.y,p.z);
+      }
       const float* vertices = scene->vertices[geomID(index)];
       return (Vec3f&) vertices[v[index]];
     }
@@ -85,10 +89,8 @@ namespace embree
     __forceinline Vec3<T> getVertex(const vuint<M>& v, const size_t index, const Scene *const scene, const size_t itime, const T& ftime) const
     {
       const TriangleMesh* mesh = scene->get<TriangleMesh>(geomID(index));
-      const float* vertices0 = (const float*) mesh->vertexPtr(0,itime+0);
-      const float* vertices1 = (const float*) mesh->vertexPtr(0,itime+1);
-      const Vec3fa v0 = Vec3fa::loadu(vertices0+v[index]);
-      const Vec3fa v1 = Vec3fa::loadu(vertices1+v[index]);
+      const Vec3fa v0 = mesh->vertexAtOffset(v[index],itime+0);
+      const Vec3fa v1 = mesh->vertexAtOffset(v[index],itime+1);
       const Vec3<T> p0(v0.x,v0.y,v0.z);
       const Vec3<T> p1(v1.x,v1.y,v1.z);
       return lerp(p0,p1,ftime);
@@ -102,16 +104,26 @@ namespace embree
 
       for (size_t mask=movemask(valid), i=bsf(mask); mask; mask=btc(mask,i), i=bsf(mask))
       {
-        const float* vertices0 = (const float*) mesh->vertexPtr(0,itime[i]+0);
-        const float* vertices1 = (const float*) mesh->vertexPtr(0,itime[i]+1);
-        const Vec3fa v0 = Vec3fa::loadu(vertices0+v[index]);
-        const Vec3fa v1 = Vec3fa::loadu(vertices1+v[index]);
+        const Vec3fa v0 = mesh->vertexAtOffset(v[index],itime[i]+0);
+        const Vec3fa v1 = mesh->vertexAtOffset(v[index],itime[i]+1);
         p0.x[i] = v0.x; p0.y[i] = v0.y; p0.z[i] = v0.z;
         p1.x[i] = v1.x; p1.y[i] = v1.y; p1.z[i] = v1.z;
       }
       return (T(one)-ftime)*p0 + ftime*p1;
     }
 
+    /* loads M vertices through the meshes, required for compact vertex formats and huge vertex buffers */
+    __forceinline Vec3vf<M> decodeVertices(const vuint<M>& v, const Scene *const scene, const vint<M>& itime) const
+    {
+      Vec3vf<M> p;
+      for (size_t i=0; i<M; i++)
+      {
+        const Vec3fa p_i = scene->get<TriangleMesh>(geomID(i))->vertexAtOffset(v[i],itime[i]);
+        p.x[i] = p_i.x; p.y[i] = p_i.y; p.z[i] = p_i.z;
+      }
+      return p;
+    }
+
     /* Gather the triangles */
     __forceinline void gather(Vec3vf<M>& p0, Vec3vf<M>& p1, Vec3vf<M>& p2, const Scene* const scene) const;
 
@@ -163,10 +175,10 @@ namespace embree
       BBox3fa bounds = empty;
       for (size_t i=0; i<M && valid(i); i++)
       {
-        const float* vertices = (const float*) scene->get<TriangleMesh>(geomID(i))->vertexPtr(0,itime);
-        bounds.extend(Vec3fa::loadu(vertices+v0[i]));
-        bounds.extend(Vec3fa::loadu(vertices+v1[i]));
-        bounds.extend(Vec3fa::loadu(vertices+v2[i]));
+        const TriangleMesh* mesh = scene->get<TriangleMesh>(geomID(i));
+        bounds.extend(mesh->vertexAtOffset(v0[i],itime));
+        bounds.extend(mesh->vertexAtOffset(v1[i],itime));
+        bounds.extend(mesh->vertexAtOffset(v2[i],itime));
       }
       return bounds;
     }
@@ -223,7 +235,7 @@ namespace embree
         if (begin<end) {
           geomID[i] = prim->geomID();
           primID[i] = prim->primID();
-          unsigned int int_stride = mesh->vertices0.getStride()/4;
+          unsigned int int_stride = mesh->vertexOffsetStride();
           v0[i] = tri.v[0] * int_stride;
           v1[i] = tri.v[1] * int_stride;
           v2[i] = tri.v[2] * int_stride;
@@ -288,6 +300,14 @@ namespace embree
                                            Vec3vf4& p2,
                                            const Scene* const scene) const
   {
+    if (unlikely(scene->indirectVertices))
+    {
+      p0 = decodeVertices(v0,scene,vint4(zero));
+      p1 = decodeVertices(v1,scene,vint4(zero));
+      p2 = decodeVertices(v2,scene,vint4(zero));
+      return;
+    }
+
     const float* vertices0 = scene->vertices[geomID(0)];
     const float* vertices1 = scene->vertices[geomID(1)];
     const float* vertices2 = scene->vertices[geomID(2)];
@@ -356,6 +376,14 @@ namespace embree
     vfloat4 ftime;
     const vint4 itime = getTimeSegment(vfloat4(time), numTimeSegments, ftime);
 
+    if (unlikely(scene->indirectVertices))
+    {
+      p0 = lerp(decodeVertices(v0,scene,itime),decodeVertices(v0,scene,itime+1),ftime);
+      p1 = lerp(decodeVertices(v1,scene,itime),decodeVertices(v1,scene,itime+1),ftime);
+      p2 = lerp(decodeVertices(v2,scene,itime),decodeVertices(v2,scene,itime+1),ftime);
+      return;
+    }
+
     Vec3vf4 a0,a1,a2; gather(a0,a1,a2,mesh0,mesh1,mesh2,mesh3,itime);
     Vec3vf4 b0,b1,b2; gather(b0,b1,b2,mesh0,mesh1,mesh2,mesh3,itime+1);
     p0 = lerp(a0,b0,ftime);
@@ -101,6 +101,61 @@ namespace embree
     }
   };
 
+  struct InnerNodeMB : public Node
+  {
+    LBBox3fa bounds[2];
+    Node* children[2];
+
+    InnerNodeMB() {
+      bounds[0] = bounds[1] = empty;
+      children[0] = children[1] = nullptr;
+    }
+
+    float sah() {
+      return 1.0f + (bounds[0].expectedHalfArea()*children[0]->sah() + bounds[1].expectedHalfArea()*children[1]->sah())/merge(bounds[0],bounds[1]).expectedHalfArea();
+    }
+
+    static void* create (RTCThreadLocalAllocator alloc, unsigned int numChildren, void* userPtr)
+    {
+      assert(numChildren == 2);
+      void* ptr = rtcThreadLocalAlloc(alloc,sizeof(InnerNodeMB),16);
+      return (void*) new (ptr) InnerNodeMB;
+    }
+
+    static void  setChildren (void* nodePtr, void** childPtr, unsigned int numChildren, void* userPtr)
+    {
+      assert(numChildren == 2);
+      for (size_t i=0; i<2; i++)
+        ((InnerNodeMB*)nodePtr)->children[i] = (Node*) childPtr[i];
+    }
+
+    static void  setBounds (void* nodePtr, const RTCLinearBounds** bounds, unsigned int numChildren, void* userPtr)
+    {
+      assert(numChildren == 2);
+      for (size_t i=0; i<2; i++)
+        ((InnerNodeMB*)nodePtr)->bounds[i] = *(const LBBox3fa*) bounds[i];
+    }
+  };
+
+  struct LeafNodeMB : public Node
+  {
+    unsigned id;
+
+    LeafNodeMB (unsigned id)
+      : id(id) {}
+
+    float sah() {
+      return 1.0f;
+    }
+
+    static void* create (RTCThreadLocalAllocator alloc, const RTCBuildPrimitiveMB* prims, size_t numPrims, void* userPtr)
+    {
+      assert(numPrims == 1);
+      void* ptr = rtcThreadLocalAlloc(alloc,sizeof(LeafNodeMB),16);
+      return (void*) new (ptr) LeafNodeMB(prims->primID);
+    }
+  };
+
   void build(RTCBuildQuality quality, avector<RTCBuildPrimitive>& prims_i, char* cfg, size_t extraSpace = 0)
   {
     rtcSetDeviceMemoryMonitorFunction(g_device,memoryMonitor,nullptr);
@@ -114,7 +169,7 @@ namespace embree
     /* settings for BVH build */
     RTCBuildArguments arguments = rtcDefaultBuildArguments();
     arguments.byteSize = sizeof(arguments);
-    arguments.buildFlags = RTC_BUILD_FLAG_DYNAMIC;
+    arguments.buildFlags = (RTCBuildFlags) (RTC_BUILD_FLAG_DYNAMIC | RTC_BUILD_FLAG_REFIT);
     arguments.buildQuality = quality;
     arguments.maxBranchingFactor = 2;
     arguments.maxDepth = 1024;
@@ -146,8 +201,67 @@ namespace embree
       double t1 = getSeconds();
       const float sah = root ? root->sah() : 0.0f;
       std::cout << 1000.0f*(t1-t0) << "ms, " << 1E-6*double(prims.size())/(t1-t0) << " Mprims/s, sah = " << sah << " [DONE]" << std::endl;
+
+      /* move all primitives and refit the BVH, the build ordered the primitives such that leaves reference consecutive ranges */
+      if (i == 9 && extraSpace == 0)
+      {
+        for (size_t j=0; j<prims.size(); j++) {
+          prims[j].lower_x += 1.0f; prims[j].upper_x += 1.0f;
+        }
+        std::cout << "refitting BVH over " << prims.size() << " primitives, " << std::flush;
+        double t2 = getSeconds();
+        rtcRefitBVH(&arguments);
+        double t3 = getSeconds();
+        const float sah = root ? root->sah() : 0.0f;
+        std::cout << 1000.0f*(t3-t2) << "ms, " << 1E-6*double(prims.size())/(t3-t2) << " Mprims/s, sah = " << sah << " [DONE]" << std::endl;
+      }
+    }
+
+    rtcReleaseBVH(bvh);
+  }
+
+  void buildMB(avector<RTCBuildPrimitive>& prims_i, char* cfg)
+  {
+    RTCBVH bvh = rtcNewBVH(g_device);
+
+    /* primitives move by a random offset during the shutter interval */
+    avector<RTCBuildPrimitiveMB> prims;
+    prims.resize(prims_i.size());
+
+    RTCBuildArguments arguments = rtcDefaultBuildArguments();
+    arguments.byteSize = sizeof(arguments);
+    arguments.maxBranchingFactor = 2;
+    arguments.maxDepth = 1024;
+    arguments.minLeafSize = 1;
+    arguments.maxLeafSize = 1;
+    arguments.bvh = bvh;
+    arguments.primitiveCount = prims.size();
+    arguments.createNode = InnerNodeMB::create;
+    arguments.setNodeChildren = InnerNodeMB::setChildren;
+    arguments.createLeafMB = LeafNodeMB::create;
+    arguments.setNodeLinearBounds = InnerNodeMB::setBounds;
+    arguments.primitivesMB = prims.data();
+
+    for (size_t j=0; j<prims.size(); j++)
+    {
+      const BBox3fa b0 = *(BBox3fa*) &prims_i[j];
+      const Vec3fa d = 10.0f*Vec3fa(float(drand48()),float(drand48()),float(drand48()));
+      RTCBuildPrimitiveMB& prim = prims[j];
+      prim.lower0_x = b0.lower.x;   prim.lower0_y = b0.lower.y;   prim.lower0_z = b0.lower.z;
+      prim.upper0_x = b0.upper.x;   prim.upper0_y = b0.upper.y;   prim.upper0_z = b0.upper.z;
+      prim.lower1_x = b0.lower.x+d.x; prim.lower1_y = b0.lower.y+d.y; prim.lower1_z = b0.lower.z+d.z;
+      prim.upper1_x = b0.upper.x+d.x; prim.upper1_y = b0.upper.y+d.y; prim.upper1_z = b0.upper.z+d.z;
+      prim.geomID = 0;
+      prim.primID = prims_i[j].primID;
     }
 
+    std::cout << "building motion blur BVH over " << prims.size() << " primitives, " << std::flush;
+    double t0 = getSeconds();
+    Node* root = (Node*) rtcBuildBVH(&arguments);
+    double t1 = getSeconds();
+    const float sah = root ? root->sah() : 0.0f;
+    std::cout << 1000.0f*(t1-t0) << "ms, " << 1E-6*double(prims.size())/(t1-t0) << " Mprims/s, sah = " << sah << " [DONE]" << std::endl;
+
     rtcReleaseBVH(bvh);
   }
 
@@ -190,6 +304,9 @@ namespace embree
 
     std::cout << "High quality BVH build:" << std::endl;
     build(RTC_BUILD_QUALITY_HIGH,prims,cfg,extraSpace);
+
+    std::cout << "Motion blur BVH build:" << std::endl;
+    buildMB(prims,cfg);
   }
 
   /* task that renders a single screen tile */
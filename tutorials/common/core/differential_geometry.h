@@ -32,6 +32,8 @@ struct DifferentialGeometry
   Vec3fa Tx; //direction along hair
   Vec3fa Ty;
   float eps;
+  Vec3fa dPdx, dPdy;  // change of the hit position from one pixel to the next
+  Vec2f duvdx, duvdy; // change of the texture coordinates from one pixel to the next
 };
 
 } // namespace embree
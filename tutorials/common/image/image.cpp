@@ -64,6 +64,18 @@ namespace embree
     return image_cache[fileName];
   }
 
+  /*! opens an image for reading regions on demand with auto-detection of format */
+  Ref<ImageReader> openImage(const FileName& fileName)
+  {
+    std::string ext = toLowerCase(fileName.ext());
+    if (ext == "pfm") return openPFM(fileName);
+    if (ext == "ppm") {
+      Ref<ImageReader> reader = openPPM(fileName);
+      if (reader) return reader;
+    }
+    return nullptr;
+  }
+
   /*! stores an image to file with auto-detection of format */
   void storeImage(const Ref<Image>& img, const FileName& fileName)
   {
@@ -143,6 +143,25 @@ namespace embree
     T* data;
   };
   
+  /* virtual interface to read regions of an image on demand, without
+     keeping the entire image in memory */
+  class ImageReader : public RefCount {
+  public:
+    ImageReader (size_t width, size_t height, const std::string& name) : width(width), height(height), name(name) {}
+    virtual ~ImageReader() {}
+
+    /*! reads the pixels [x0,x0+w) x [y0,y0+h) row by row as RGBA8, has to be thread safe */
+    virtual void readRGBA8(size_t x0, size_t y0, size_t w, size_t h, unsigned char* dest) const = 0;
+
+  private:
+    ImageReader (const ImageReader& other) DELETED; // do not implement
+    ImageReader& operator= (const ImageReader& other) DELETED; // do not implement
+
+  public:
+    size_t width,height;
+    std::string name;
+  };
+
   /*! Shortcuts for common image types. */
   typedef ImageT<Col3uc> Image3uc;
   typedef ImageT<Col3f> Image3f;
@@ -173,6 +192,18 @@ namespace embree
   /*! Loads image from TIFF file. */
 //Ref<Image> loadTIFF(const FileName& fileName);
   
+  /*! Opens image for reading regions on demand. Format is auto
+   *  detected, only PFM and binary 8 bit PPM files support random
+   *  access, for all other files nullptr is returned. */
+  Ref<ImageReader> openImage(const FileName& filename);
+
+  /*! Opens binary PFM file for reading regions on demand. */
+  Ref<ImageReader> openPFM(const FileName& fileName);
+
+  /*! Opens binary PPM file for reading regions on demand, returns
+   *  nullptr for PPM files in text format. */
+  Ref<ImageReader> openPPM(const FileName& fileName);
+
   /*! Store image to file. Format is auto detected. */
   void storeImage(const Ref<Image>& image, const FileName& filename);
 
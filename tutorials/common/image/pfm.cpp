@@ -15,6 +15,7 @@
 // ======================================================================== //
 
 #include "image.h"
+#include "../../../common/sys/mapped_file.h"
 
 #include <iostream>
 #include <cstring>
@@ -79,6 +80,65 @@ namespace embree
     return img;
   }
 
+  /*! reads regions of a PFM file directly from the mapped file */
+  class PFMReader : public ImageReader
+  {
+  public:
+    PFMReader (const FileName& fileName, size_t width, size_t height, size_t ofs, float scale)
+      : ImageReader(width,height,fileName), file(new MappedFile(fileName)), ofs(ofs), scale(scale)
+    {
+      if (ofs+3*sizeof(float)*width*height > file->size())
+        THROW_RUNTIME_ERROR("PFM file " + fileName.str() + " is truncated");
+    }
+
+    void readRGBA8(size_t x0, size_t y0, size_t w, size_t h, unsigned char* dest) const
+    {
+      for (size_t y=0; y<h; y++)
+      {
+        /* rows are stored from bottom to top */
+        const float* rgb = (const float*) (file->data() + ofs) + 3*((height-1-(y0+y))*width+x0);
+        for (size_t x=0; x<w; x++, rgb+=3, dest+=4)
+        {
+          dest[0] = (unsigned char)(clamp(rgb[0]*scale)*255.0f);
+          dest[1] = (unsigned char)(clamp(rgb[1]*scale)*255.0f);
+          dest[2] = (unsigned char)(clamp(rgb[2]*scale)*255.0f);
+          dest[3] = 255;
+        }
+      }
+    }
+
+  private:
+    std::unique_ptr<MappedFile> file;
+    size_t ofs;      //!< offset of the first pixel in the file
+    float scale;
+  };
+
+  /*! open PFM file for reading regions on demand */
+  Ref<ImageReader> openPFM(const FileName& fileName)
+  {
+    /* open file for reading */
+    std::fstream file;
+    file.exceptions (std::fstream::failbit | std::fstream::badbit);
+    file.open (fileName.c_str(), std::fstream::in | std::fstream::binary);
+
+    /* read file type */
+    char cty[2]; file.read(cty,2);
+    skipSpacesAndComments(file);
+    std::string type(cty,2);
+    if (type != "PF") THROW_RUNTIME_ERROR("Invalid magic value in PFM file");
+
+    /* read width, height, and maximum color value */
+    int width; file >> width;
+    skipSpacesAndComments(file);
+    int height; file >> height;
+    skipSpacesAndComments(file);
+    float maxColor; file >> maxColor;
+    if (maxColor > 0) THROW_RUNTIME_ERROR("Big endian PFM files not supported");
+    file.ignore(); // skip space or return
+
+    return new PFMReader(fileName,width,height,size_t(file.tellg()),-1.0f/float(maxColor));
+  }
+
   /*! store PFM file to disk */
   void storePFM(const Ref<Image>& img, const FileName& fileName)
   {
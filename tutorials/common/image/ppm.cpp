@@ -15,6 +15,7 @@
 // ======================================================================== //
 
 #include "image.h"
+#include "../../../common/sys/mapped_file.h"
 
 #include <iostream>
 #include <cstring>
@@ -104,6 +105,65 @@ namespace embree
     return img;
   }
 
+  /*! reads regions of a binary 8 bit PPM file directly from the mapped file */
+  class PPMReader : public ImageReader
+  {
+  public:
+    PPMReader (const FileName& fileName, size_t width, size_t height, size_t ofs, int maxColor)
+      : ImageReader(width,height,fileName), file(new MappedFile(fileName)), ofs(ofs), maxColor(maxColor)
+    {
+      if (ofs+3*width*height > file->size())
+        THROW_RUNTIME_ERROR("PPM file " + fileName.str() + " is truncated");
+    }
+
+    void readRGBA8(size_t x0, size_t y0, size_t w, size_t h, unsigned char* dest) const
+    {
+      for (size_t y=0; y<h; y++)
+      {
+        const unsigned char* rgb = (const unsigned char*) file->data() + ofs + 3*((y0+y)*width+x0);
+        for (size_t x=0; x<w; x++, rgb+=3, dest+=4)
+        {
+          dest[0] = (unsigned char)(rgb[0]*255/maxColor);
+          dest[1] = (unsigned char)(rgb[1]*255/maxColor);
+          dest[2] = (unsigned char)(rgb[2]*255/maxColor);
+          dest[3] = 255;
+        }
+      }
+    }
+
+  private:
+    std::unique_ptr<MappedFile> file;
+    size_t ofs;      //!< offset of the first pixel in the file
+    int maxColor;
+  };
+
+  /*! open PPM file for reading regions on demand */
+  Ref<ImageReader> openPPM(const FileName& fileName)
+  {
+    /* open file for reading */
+    std::fstream file;
+    file.exceptions (std::fstream::failbit | std::fstream::badbit);
+    file.open (fileName.c_str(), std::fstream::in | std::fstream::binary);
+
+    /* read file type */
+    char cty[2]; file.read(cty,2);
+    skipSpacesAndComments(file);
+    std::string type(cty,2);
+
+    /* read width, height, and maximum color value */
+    int width; file >> width;
+    skipSpacesAndComments(file);
+    int height; file >> height;
+    skipSpacesAndComments(file);
+    int maxColor; file >> maxColor;
+    if (maxColor <= 0) THROW_RUNTIME_ERROR("Invalid maxColor value in PPM file");
+    file.ignore(); // skip space or return
+
+    /* only binary 8 bit files can be accessed randomly */
+    if (type != "P6" || maxColor > 255) return nullptr;
+    return new PPMReader(fileName,width,height,size_t(file.tellg()),maxColor);
+  }
+
   /*! store PPM file to disk */
   void storePPM(const Ref<Image>& img, const FileName& fileName)
   {
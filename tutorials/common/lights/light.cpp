@@ -29,6 +29,16 @@ Light_EvalRes Light_eval(const Light* uniform,
   return res;
 }
 
+Light_Bounds Light_bounds(const Light* uniform)
+{
+  Light_Bounds res;
+  res.bounds = empty;
+  res.axis = Vec3fa(0.f,0.f,1.f);
+  res.cosTheta = -1.f;
+  res.power = 0.f;
+  return res;
+}
+
 extern "C" void Light_destroy(Light* light)
 {
   alignedFree(light);
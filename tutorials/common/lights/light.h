@@ -17,6 +17,7 @@
 #pragma once
 
 #include "../core/differential_geometry.h"
+#include "../../../common/math/bbox.h"
 
 namespace embree {
 
@@ -51,17 +52,32 @@ typedef Light_EvalRes (*Light_EvalFunc)(const Light* self,
                                         const Vec3fa& dir);              /*! direction towards the light source >*/
 
 
+struct Light_Bounds
+{
+  BBox3fa bounds;   //!< bounds of the emitting surface, empty for lights at infinity
+  Vec3fa axis;      //!< central direction of emission
+  float cosTheta;   //!< cosine of the cone of emission directions around axis, -1 emits in all directions
+  float power;      //!< estimated emitted power, used as sampling importance
+};
+
+typedef Light_Bounds (*Light_BoundsFunc)(const Light* self);
+
+
 struct Light
 {
   Light_SampleFunc sample;
   Light_EvalFunc eval;
+  Light_BoundsFunc bounds;
 };
 
 Light_EvalRes Light_eval(const Light* self, const DifferentialGeometry& dg, const Vec3fa& dir);
 
+Light_Bounds Light_bounds(const Light* self);
+
 inline void Light_Constructor(Light* self)
 {
   self->eval = Light_eval;
+  self->bounds = Light_bounds;
 }
 
 } // namespace embree
@@ -0,0 +1,205 @@
+// ======================================================================== //
+// Copyright 2009-2018 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "light_tree.h"
+#include "../../../common/algorithms/parallel_for.h"
+#include "../../../common/algorithms/parallel_reduce.h"
+#include "../../../common/algorithms/parallel_sort.h"
+
+namespace embree {
+
+/* subtrees with more lights get built in parallel */
+#define PARALLEL_THRESHOLD 4096
+
+LightTree::LightTree(Light** lights, unsigned int numLights)
+{
+  /* query the bounds of all lights */
+  avector<Light_Bounds> bounds(numLights);
+  parallel_for(size_t(0),size_t(numLights),size_t(1024),[&](const range<size_t>& r) {
+    for (size_t i=r.begin(); i<r.end(); i++)
+      bounds[i] = lights[i]->bounds(lights[i]);
+  });
+
+  std::vector<unsigned int> finiteLights;
+  for (unsigned int i=0; i<numLights; i++) {
+    if (bounds[i].bounds.empty()) infiniteLights.push_back(i);
+    else finiteLights.push_back(i);
+  }
+  const size_t N = finiteLights.size();
+  if (N == 0) return;
+
+  /* sort the lights along a morton curve through their centers */
+  const BBox3fa centBounds = parallel_reduce(size_t(0),N,size_t(1024),BBox3fa(embree::empty),[&](const range<size_t>& r) -> BBox3fa {
+      BBox3fa b(embree::empty);
+      for (size_t i=r.begin(); i<r.end(); i++) b.extend(center(bounds[finiteLights[i]].bounds));
+      return b;
+    }, [] (const BBox3fa& a, const BBox3fa& b) { return merge(a,b); });
+
+  const Vec3fa diag = centBounds.size();
+  const Vec3fa scale = Vec3fa(diag.x > 0.0f ? 1023.0f/diag.x : 0.0f,
+                              diag.y > 0.0f ? 1023.0f/diag.y : 0.0f,
+                              diag.z > 0.0f ? 1023.0f/diag.z : 0.0f);
+
+  std::vector<uint64_t> keys(N), tmp(N);
+  parallel_for(size_t(0),N,size_t(1024),[&](const range<size_t>& r) {
+    for (size_t i=r.begin(); i<r.end(); i++) {
+      const Vec3fa p = (center(bounds[finiteLights[i]].bounds)-centBounds.lower)*scale;
+      const unsigned int code = bitInterleave((unsigned int)p.x,(unsigned int)p.y,(unsigned int)p.z);
+      keys[i] = (uint64_t(code) << 32) | finiteLights[i];
+    }
+  });
+  radix_sort_u64(keys.data(),tmp.data(),N);
+
+  /* a binary tree over N lights has 2N-1 nodes */
+  nodes.resize(2*N-1);
+  build(0,keys.data(),0,N,bounds);
+}
+
+void LightTree::build(unsigned int nodeID, const uint64_t* keys, size_t begin, size_t end, const avector<Light_Bounds>& bounds)
+{
+  Node& node = nodes[nodeID];
+
+  if (end-begin == 1)
+  {
+    const unsigned int light = (unsigned int) keys[begin];
+    node.bounds = bounds[light].bounds;
+    node.axis = bounds[light].axis;
+    node.cosTheta = bounds[light].cosTheta;
+    node.power = bounds[light].power;
+    node.right = 0;
+    node.light = light;
+    return;
+  }
+
+  /* split at the highest bit the morton codes differ in, or in the middle if all codes are equal */
+  size_t split = (begin+end)/2;
+  const unsigned int code0 = (unsigned int)(keys[begin] >> 32);
+  const unsigned int code1 = (unsigned int)(keys[end-1] >> 32);
+  if (code0 != code1)
+  {
+    const unsigned int bit = 1 << bsr(code0 ^ code1);
+    split = std::partition_point(keys+begin,keys+end,[&] (const uint64_t key) {
+        return ((key >> 32) & bit) == 0;
+      }) - keys;
+  }
+
+  /* the left subtree directly follows the node, the right subtree follows the left one */
+  const unsigned int leftID = nodeID+1;
+  const unsigned int rightID = nodeID+2*unsigned(split-begin);
+  if (end-begin > PARALLEL_THRESHOLD)
+  {
+    parallel_for(size_t(2), [&](const size_t i) {
+        if (i == 0) build(leftID,keys,begin,split,bounds);
+        else        build(rightID,keys,split,end,bounds);
+      });
+  }
+  else
+  {
+    build(leftID,keys,begin,split,bounds);
+    build(rightID,keys,split,end,bounds);
+  }
+
+  combine(node,nodes[leftID],nodes[rightID]);
+  node.right = rightID;
+  node.light = -1;
+}
+
+void LightTree::combine(Node& node, const Node& a, const Node& b)
+{
+  node.bounds = merge(a.bounds,b.bounds);
+  node.power = a.power+b.power;
+
+  /* calculate the cone that bounds both cones of emission directions */
+  node.axis = Vec3fa(0.0f,0.0f,1.0f);
+  node.cosTheta = -1.0f;
+  if (a.cosTheta <= -1.0f || b.cosTheta <= -1.0f)
+    return;
+
+  const float thetaA = acos(a.cosTheta);
+  const float thetaB = acos(b.cosTheta);
+  const float thetaD = acos(clamp(dot(a.axis,b.axis),-1.0f,1.0f));
+  if (min(thetaD+thetaB,float(pi)) <= thetaA) {
+    node.axis = a.axis; node.cosTheta = a.cosTheta;
+    return;
+  }
+  if (min(thetaD+thetaA,float(pi)) <= thetaB) {
+    node.axis = b.axis; node.cosTheta = b.cosTheta;
+    return;
+  }
+
+  const float thetaO = 0.5f*(thetaA+thetaD+thetaB);
+  const Vec3fa ortho = b.axis - a.axis*dot(a.axis,b.axis);
+  if (thetaO >= float(pi) || dot(ortho,ortho) < 1E-12f)
+    return;
+
+  /* rotate the axis of cone a towards the axis of cone b */
+  const float thetaR = thetaO-thetaA;
+  node.axis = normalize(a.axis*cos(thetaR) + normalize(ortho)*sin(thetaR));
+  node.cosTheta = cos(thetaO);
+}
+
+float LightTree::importance(const Node& node, const Vec3fa& P)
+{
+  /* power falls off with squared distance, clamped by the squared radius of the bounds */
+  const Vec3fa d = P - center(node.bounds);
+  const float dist2 = dot(d,d);
+  const float radius2 = 0.25f*dot(node.bounds.size(),node.bounds.size());
+  const float I = node.power * rcp(max(dist2,radius2));
+  if (node.cosTheta <= -1.0f || dist2 <= radius2)
+    return I;
+
+  /* angle between the cone and P, reduced by the angle the bounds subtend from P */
+  const float cosT = clamp(dot(node.axis,d)*rsqrt(dist2),-1.0f,1.0f);
+  const float sinU = min(sqrt(radius2/dist2),1.0f);
+  const float theta = acos(cosT) - acos(node.cosTheta) - asin(sinU);
+  if (theta <= 0.0f) return I;
+  if (theta >= 0.5f*float(pi)) return 0.0f;
+  return I*cos(theta);
+}
+
+int LightTree::sample(const Vec3fa& P, float u, float& pmf) const
+{
+  pmf = 0.0f;
+  if (nodes.empty()) return -1;
+
+  /* descend into the children proportional to their importance and reuse the random number */
+  float p = 1.0f;
+  unsigned int nodeID = 0;
+  while (nodes[nodeID].right)
+  {
+    const unsigned int leftID = nodeID+1;
+    const unsigned int rightID = nodes[nodeID].right;
+    const float wl = importance(nodes[leftID],P);
+    const float wr = importance(nodes[rightID],P);
+    if (wl+wr <= 0.0f) return -1;
+
+    const float pl = wl/(wl+wr);
+    if (u < pl) {
+      u = min(u/pl,1.0f-float(ulp));
+      p *= pl;
+      nodeID = leftID;
+    } else {
+      u = min((u-pl)/(1.0f-pl),1.0f-float(ulp));
+      p *= 1.0f-pl;
+      nodeID = rightID;
+    }
+  }
+
+  pmf = p;
+  return nodes[nodeID].light;
+}
+
+} // namespace embree
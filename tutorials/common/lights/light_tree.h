@@ -0,0 +1,63 @@
+// ======================================================================== //
+// Copyright 2009-2018 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "light.h"
+#include "../../../common/sys/vector.h"
+
+namespace embree {
+
+/*! Bounding volume hierarchy over the lights of a scene. Each node
+ *  stores the bounds, the cone of emission directions, and the power
+ *  of all lights below it. A light is selected by walking down the
+ *  tree, choosing each child with probability proportional to its
+ *  estimated contribution to the shading point, thus sampling costs
+ *  logarithmic time in the number of lights. Lights at infinity have
+ *  no position and are not part of the hierarchy. */
+struct LightTree
+{
+  struct Node
+  {
+    BBox3fa bounds;      //!< bounds of all lights below the node
+    Vec3fa axis;         //!< axis of the cone bounding all emission directions
+    float cosTheta;      //!< cosine of the cone half angle, -1 for all directions
+    float power;         //!< summed power of all lights below the node
+    unsigned int right;  //!< index of the right child, the left child directly follows the node
+    unsigned int light;  //!< light index for leaf nodes
+  };
+
+  /*! builds the tree over all lights with bounds, in parallel */
+  LightTree(Light** lights, unsigned int numLights);
+
+  /*! returns true if no light is in the tree */
+  __forceinline bool empty() const { return nodes.size() == 0; }
+
+  /*! selects a light for point P using the random number u, returns
+   *  the light index and its probability or -1 if no light contributes */
+  int sample(const Vec3fa& P, float u, float& pmf) const;
+
+private:
+  static float importance(const Node& node, const Vec3fa& P);
+  static void combine(Node& node, const Node& left, const Node& right);
+  void build(unsigned int nodeID, const uint64_t* keys, size_t begin, size_t end, const avector<Light_Bounds>& bounds);
+
+public:
+  std::vector<unsigned int> infiniteLights; //!< lights that are not part of the tree
+  avector<Node> nodes;                      //!< nodes in depth first order
+};
+
+} // namespace embree
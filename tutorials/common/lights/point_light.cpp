@@ -116,6 +116,18 @@ Light_EvalRes PointLight_eval(const Light* super,
   return res;
 }
 
+Light_Bounds PointLight_bounds(const Light* super)
+{
+  const PointLight* self = (PointLight*)super;
+  Light_Bounds res;
+  res.bounds = BBox3fa(self->position - Vec3fa(self->radius), self->position + Vec3fa(self->radius));
+  res.axis = Vec3fa(0.f, 0.f, 1.f);
+  res.cosTheta = -1.f; // emits in all directions
+  res.power = 4.f*float(pi) * reduce_add(Vec3f(self->power)) / 3.f;
+  return res;
+}
+
+
 // Exports (called from C++)
 //////////////////////////////////////////////////////////////////////////////
 
@@ -138,6 +150,7 @@ extern "C" void* PointLight_create()
   Light_Constructor(&self->super);
   self->super.sample = PointLight_sample;
   self->super.eval = PointLight_eval;
+  self->super.bounds = PointLight_bounds;
 
   PointLight_set(self, Vec3fa(0.f), Vec3fa(1.f), 0.f);
   return self;
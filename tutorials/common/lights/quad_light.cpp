@@ -65,6 +65,21 @@ Light_SampleRes QuadLight_sample(const Light* super,
 }
 
 
+Light_Bounds QuadLight_bounds(const Light* super)
+{
+  const QuadLight* self = (QuadLight*)super;
+  Light_Bounds res;
+  res.bounds = BBox3fa(self->position);
+  res.bounds.extend(self->position + self->edge1);
+  res.bounds.extend(self->position + self->edge2);
+  res.bounds.extend(self->position + self->edge1 + self->edge2);
+  res.axis = neg(self->nnormal);
+  res.cosTheta = 0.f; // emits into the hemisphere around axis
+  res.power = float(pi) * rcp(self->ppdf) * reduce_add(Vec3f(self->radiance)) / 3.f;
+  return res;
+}
+
+
 // Exports (called from C++)
 //////////////////////////////////////////////////////////////////////////////
 
@@ -93,6 +108,7 @@ extern "C" void* QuadLight_create()
 
   Light_Constructor(&self->super);
   self->super.sample = QuadLight_sample;
+  self->super.bounds = QuadLight_bounds;
 
   QuadLight_set(self,
                 Vec3fa(0.f),
@@ -106,6 +106,18 @@ Light_EvalRes SpotLight_eval(const Light* super,
 }
 
 
+Light_Bounds SpotLight_bounds(const Light* super)
+{
+  const SpotLight* self = (SpotLight*)super;
+  Light_Bounds res;
+  res.bounds = BBox3fa(self->position - Vec3fa(self->radius), self->position + Vec3fa(self->radius));
+  res.axis = self->frame.vz;
+  res.cosTheta = self->cosAngleMax;
+  res.power = 2.f*float(pi)*(1.f - self->cosAngleMax) * reduce_add(Vec3f(self->power)) / 3.f;
+  return res;
+}
+
+
 // Exports (called from C++)
 //////////////////////////////////////////////////////////////////////////////
 
@@ -136,6 +148,7 @@ extern "C" void* SpotLight_create()
   Light_Constructor(&self->super);
   self->super.sample = SpotLight_sample;
   self->super.eval = SpotLight_eval;
+  self->super.bounds = SpotLight_bounds;
 
   SpotLight_set(self,
                 Vec3fa(0.f),
@@ -16,6 +16,10 @@
 
 #include "obj_loader.h"
 #include "texture.h"
+#include "../../../common/sys/mapped_file.h"
+#include "../../../common/algorithms/parallel_for.h"
+#include "../../../common/algorithms/parallel_reduce.h"
+#include "../../../common/algorithms/parallel_prefix_sum.h"
 
 namespace embree
 {
@@ -112,6 +116,43 @@ namespace embree
     return Vec3fa(x,y,z);
   }
 
+  /*! Reads the next line into the line buffer, lines ending with a backslash are continued. */
+  static inline bool getLine(const char*& ptr, const char* end, std::string& line)
+  {
+    if (ptr >= end) return false;
+    const char* eol = (const char*) memchr(ptr,'\n',end-ptr);
+    if (eol == nullptr) eol = end;
+    line.assign(ptr,eol);
+    ptr = eol < end ? eol+1 : end;
+
+    while (!line.empty() && line[line.size()-1] == '\\') {
+      line[line.size()-1] = ' ';
+      if (ptr >= end) break;
+      const char* next = ptr;
+      eol = (const char*) memchr(ptr,'\n',end-ptr);
+      if (eol == nullptr) eol = end;
+      ptr = eol < end ? eol+1 : end;
+      if (next == eol) break;
+      line.append(next,eol);
+    }
+    return true;
+  }
+
+  /*! Returns the start of the first line at or after pos that does not continue a previous line. */
+  static inline const char* findLineStart(const char* begin, const char* pos, const char* end)
+  {
+    if (pos <= begin) return begin;
+    while (pos < end)
+    {
+      if (pos[-1] == '\n' && (pos-1 == begin || pos[-2] != '\\'))
+        return pos;
+      const char* eol = (const char*) memchr(pos,'\n',end-pos);
+      if (eol == nullptr) return end;
+      pos = eol+1;
+    }
+    return end;
+  }
+
   class OBJLoader
   {
   public:
@@ -135,8 +176,12 @@ namespace embree
     avector<Vec3fa> vn;
     std::vector<Vec2f> vt;
     std::vector<Crease> ec;
+    size_t curNumV, curNumVN, curNumVT; //!< vertex data defined before the current statement
 
-    std::vector<std::vector<Vertex> > curGroup;
+    /*! Faces of the file, the current group is a range of these faces. */
+    std::vector<Vertex> faceVertices;
+    std::vector<size_t> faceBegin;
+    size_t curGroupBegin, curGroupEnd;
     std::vector<avector<Vec3fa> > curGroupHair;
 
     /*! Material handling. */
@@ -145,74 +190,202 @@ namespace embree
     std::map<std::string, Ref<SceneGraph::MaterialNode> > material;
     std::map<std::string, std::shared_ptr<Texture>> textureMap; 
 
+    /*! Statement that has to get processed in file order. */
+    struct Command
+    {
+      enum Type { USEMTL, MTLLIB, CREASE, HAIR };
+
+      Command (Type type, size_t face, size_t numV, size_t numVN, size_t numVT)
+        : type(type), face(face), numV(numV), numVN(numVN), numVT(numVT) {}
+
+      Type type;
+      size_t face;            //!< number of faces of the chunk before this statement
+      size_t numV, numVN, numVT; //!< number of positions, normals, and texture coordinates of the file before this statement
+      std::string name;       //!< material or material library name
+      Crease crease;
+      avector<Vec3fa> hair;
+    };
+
+    /*! Part of the file that gets parsed by a single task. */
+    struct Chunk
+    {
+      Chunk ()
+        : begin(nullptr), end(nullptr), numV(0), numVN(0), numVT(0), ofsV(0), ofsVN(0), ofsVT(0), ofsFaces(0), ofsFaceVertices(0) {}
+
+      const char* begin;
+      const char* end;
+      size_t numV, numVN, numVT;  //!< number of positions, normals, and texture coordinates
+      size_t ofsV, ofsVN, ofsVT;  //!< number of positions, normals, and texture coordinates of all previous chunks
+      size_t ofsFaces, ofsFaceVertices;
+      std::vector<Vertex> faceVertices;
+      std::vector<unsigned int> faceSizes;
+      std::vector<Command> commands;
+    };
+
   private:
+    void countChunk(Chunk& chunk);
+    void parseChunk(Chunk& chunk);
     void loadMTL(const FileName& fileName);
-    unsigned int fix_v (int index);
-    unsigned int fix_vt(int index);
-    unsigned int fix_vn(int index);
+    static unsigned int fix(int index, size_t size);
     void flushFaceGroup();
     void flushTriGroup();
     void flushHairGroup();
-    Vertex getUInt3(const char*& token);
+    Vertex getUInt3(const char*& token, size_t numV, size_t numVT, size_t numVN);
     uint32_t getVertex(std::map<Vertex,uint32_t>& vertexMap, Ref<SceneGraph::TriangleMeshNode> mesh, const Vertex& i);
     std::shared_ptr<Texture> loadTexture(const FileName& fname);
   };
 
   OBJLoader::OBJLoader(const FileName &fileName, const bool subdivMode, const bool combineIntoSingleObject) 
-    : group(new SceneGraph::GroupNode), path(fileName.path()), subdivMode(subdivMode)
+    : group(new SceneGraph::GroupNode), path(fileName.path()), subdivMode(subdivMode), curNumV(0), curNumVN(0), curNumVT(0), curGroupBegin(0), curGroupEnd(0)
   {
-    /* open file */
-    std::ifstream cin;
-    cin.open(fileName.c_str());
-    if (!cin.is_open()) {
-      THROW_RUNTIME_ERROR("cannot open " + fileName.str());
-      return;
-    }
+    /* map file */
+    MappedFile file(fileName);
+    const char* begin = file.data();
+    const char* end = begin+file.size();
 
     /* generate default material */
     Ref<SceneGraph::MaterialNode> defaultMaterial = new OBJMaterial("default");
     curMaterialName = "default";
     curMaterial = defaultMaterial;
 
-    while (cin.peek() != -1)
+    /* split the file into chunks at line boundaries */
+    const size_t chunkBytes = 1024*1024;
+    const size_t numChunks = max(size_t(1),file.size()/chunkBytes);
+    std::vector<Chunk> chunks(numChunks);
+    for (size_t i=0; i<numChunks; i++)
+      chunks[i].begin = findLineStart(begin,begin+i*(file.size()/numChunks),end);
+    for (size_t i=0; i<numChunks; i++)
+      chunks[i].end = i+1 < numChunks ? chunks[i+1].begin : end;
+
+    /* count the vertex data of all chunks, such that each chunk knows where to store its vertex data */
+    parallel_for(numChunks, [&](const size_t i) { countChunk(chunks[i]); });
+    size_t numV = 0, numVN = 0, numVT = 0;
+    for (Chunk& chunk : chunks)
     {
-      /* load next multiline */
-      std::string line; std::getline(cin,line);
-      while (!line.empty() && line[line.size()-1] == '\\') {
-	line[line.size()-1] = ' ';
-	std::string next_line; std::getline(cin,next_line);
-	if (next_line.empty()) break;
-	line += next_line;
+      chunk.ofsV = numV; numV += chunk.numV;
+      chunk.ofsVN = numVN; numVN += chunk.numVN;
+      chunk.ofsVT = numVT; numVT += chunk.numVT;
+    }
+    v.resize(numV);
+    vn.resize(numVN);
+    vt.resize(numVT);
+
+    /* parse all chunks */
+    parallel_for(numChunks, [&](const size_t i) { parseChunk(chunks[i]); });
+
+    /* stitch the faces of all chunks together */
+    size_t numFaces = 0, numFaceVertices = 0;
+    for (Chunk& chunk : chunks)
+    {
+      chunk.ofsFaces = numFaces; numFaces += chunk.faceSizes.size();
+      chunk.ofsFaceVertices = numFaceVertices; numFaceVertices += chunk.faceVertices.size();
+    }
+    faceVertices.resize(numFaceVertices);
+    faceBegin.resize(numFaces+1);
+    faceBegin[numFaces] = numFaceVertices;
+
+    parallel_for(numChunks, [&](const size_t i)
+    {
+      Chunk& chunk = chunks[i];
+      std::copy(chunk.faceVertices.begin(),chunk.faceVertices.end(),faceVertices.begin()+chunk.ofsFaceVertices);
+      for (size_t j=0, k=chunk.ofsFaceVertices; j<chunk.faceSizes.size(); k+=chunk.faceSizes[j++])
+        faceBegin[chunk.ofsFaces+j] = k;
+      std::vector<Vertex>().swap(chunk.faceVertices);
+      std::vector<unsigned int>().swap(chunk.faceSizes);
+    });
+
+    /* process all other statements in file order */
+    for (Chunk& chunk : chunks)
+    {
+      for (Command& cmd : chunk.commands)
+      {
+        curGroupEnd = chunk.ofsFaces+cmd.face;
+        curNumV = cmd.numV; curNumVN = cmd.numVN; curNumVT = cmd.numVT;
+        switch (cmd.type)
+        {
+        case Command::USEMTL:
+          if (!combineIntoSingleObject) flushFaceGroup();
+          if (material.find(cmd.name) == material.end()) {
+            curMaterial = defaultMaterial;
+            curMaterialName = "default";
+          }
+          else {
+            curMaterial = material[cmd.name];
+            curMaterialName = cmd.name;
+          }
+          break;
+
+        case Command::MTLLIB:
+          loadMTL(path + cmd.name);
+          break;
+
+        case Command::CREASE:
+          ec.push_back(cmd.crease);
+          break;
+
+        case Command::HAIR:
+          curGroupHair.push_back(std::move(cmd.hair));
+          break;
+        }
       }
+    }
+    curGroupEnd = numFaces;
+    curNumV = numV; curNumVN = numVN; curNumVT = numVT;
+    flushFaceGroup();
+  }
+
+  /*! counts the positions, normals, and texture coordinates of a chunk */
+  void OBJLoader::countChunk(Chunk& chunk)
+  {
+    std::string line;
+    const char* ptr = chunk.begin;
+    while (getLine(ptr,chunk.end,line))
+    {
+      const char* token = trimEnd(line.c_str() + strspn(line.c_str(), " \t"));
+      if (token[0] != 'v') continue;
+      if (isSep(token[1])) chunk.numV++;
+      else if (token[1] == 'n' && isSep(token[2])) chunk.numVN++;
+      else if (token[1] == 't' && isSep(token[2])) chunk.numVT++;
+    }
+  }
+
+  /*! parses a chunk, the vertex data gets stored directly into the arrays of the loader */
+  void OBJLoader::parseChunk(Chunk& chunk)
+  {
+    size_t curV = chunk.ofsV, curVN = chunk.ofsVN, curVT = chunk.ofsVT;
+    std::string line;
+    const char* ptr = chunk.begin;
+    while (getLine(ptr,chunk.end,line))
+    {
       const char* token = trimEnd(line.c_str() + strspn(line.c_str(), " \t"));
       if (token[0] == 0) continue;
 
       /*! parse position */
       if (token[0] == 'v' && isSep(token[1])) { 
-        v.push_back(getVec3f(token += 2)); continue;
+        v[curV++] = getVec3f(token += 2); continue;
       }
 
       /* parse normal */
       if (token[0] == 'v' && token[1] == 'n' && isSep(token[2])) { 
-        vn.push_back(getVec3f(token += 3)); 
+        vn[curVN++] = getVec3f(token += 3);
         continue; 
       }
 
       /* parse texcoord */
-      if (token[0] == 'v' && token[1] == 't' && isSep(token[2])) { vt.push_back(getVec2f(token += 3)); continue; }
+      if (token[0] == 'v' && token[1] == 't' && isSep(token[2])) { vt[curVT++] = getVec2f(token += 3); continue; }
 
       /*! parse face */
       if (token[0] == 'f' && isSep(token[1]))
       {
         parseSep(token += 1);
 
-        std::vector<Vertex> face;
+        unsigned int num = 0;
         while (token[0]) {
-	  Vertex vtx = getUInt3(token);
-          face.push_back(vtx);
+          chunk.faceVertices.push_back(getUInt3(token,curV,curVT,curVN));
           parseSepOpt(token);
+          num++;
         }
-        curGroup.push_back(face);
+        chunk.faceSizes.push_back(num);
         continue;
       }
 
@@ -230,7 +403,8 @@ namespace embree
         else continue;
 
         unsigned int N = getInt(token);
-        avector<Vec3fa> hair;
+        Command cmd(Command::HAIR,chunk.faceSizes.size(),curV,curVN,curVT);
+        avector<Vec3fa>& hair = cmd.hair;
         for (unsigned int i=0; i<3*N+1; i++) {
           hair.push_back(getVec3fa(token));
         }
@@ -243,7 +417,8 @@ namespace embree
           hair[3*i+0].w = r;
           if (i != N) hair[3*i+1].w = r;
         }
-        curGroupHair.push_back(hair);
+        chunk.commands.push_back(std::move(cmd));
+        continue;
       }
       
       /*! parse edge crease */
@@ -252,41 +427,35 @@ namespace embree
 	parseSep(token += 2);
 	float w = getFloat(token);
 	parseSepOpt(token);
-	unsigned int a = fix_v(getInt(token));
+	unsigned int a = fix(getInt(token),curV);
 	parseSepOpt(token);
-	unsigned int b = fix_v(getInt(token));
+	unsigned int b = fix(getInt(token),curV);
 	parseSepOpt(token);
-	ec.push_back(Crease(w, a, b));
+        Command cmd(Command::CREASE,chunk.faceSizes.size(),curV,curVN,curVT);
+	cmd.crease = Crease(w, a, b);
+        chunk.commands.push_back(std::move(cmd));
 	continue;
       }
 
       /*! use material */
       if (!strncmp(token, "usemtl", 6) && isSep(token[6]))
       {
-        if (!combineIntoSingleObject) flushFaceGroup();
-        std::string name(parseSep(token += 6));
-        if (material.find(name) == material.end()) {
-          curMaterial = defaultMaterial;
-          curMaterialName = "default";
-        }
-        else {
-          curMaterial = material[name];
-          curMaterialName = name;
-        }
+        Command cmd(Command::USEMTL,chunk.faceSizes.size(),curV,curVN,curVT);
+        cmd.name = parseSep(token += 6);
+        chunk.commands.push_back(std::move(cmd));
         continue;
       }
 
       /* load material library */
       if (!strncmp(token, "mtllib", 6) && isSep(token[6])) {
-        loadMTL(path + std::string(parseSep(token += 6)));
+        Command cmd(Command::MTLLIB,chunk.faceSizes.size(),curV,curVN,curVT);
+        cmd.name = parseSep(token += 6);
+        chunk.commands.push_back(std::move(cmd));
         continue;
       }
 
       // ignore unknown stuff
     }
-    flushFaceGroup();
-
-    cin.close();
   }
 
   struct ExtObjMaterial
@@ -467,17 +636,15 @@ namespace embree
     cin.close();
   }
 
-  /*! handles relative indices and starts indexing from 0 */
-  unsigned int OBJLoader::fix_v (int index) { return (index > 0 ? index - 1 : (index == 0 ? 0 : (int) v .size() + index)); }
-  unsigned int OBJLoader::fix_vt(int index) { return (index > 0 ? index - 1 : (index == 0 ? 0 : (int) vt.size() + index)); }
-  unsigned int OBJLoader::fix_vn(int index) { return (index > 0 ? index - 1 : (index == 0 ? 0 : (int) vn.size() + index)); }
+  /*! handles relative indices and starts indexing from 0, size is the number of elements specified so far */
+  unsigned int OBJLoader::fix(int index, size_t size) { return (index > 0 ? index - 1 : (index == 0 ? 0 : (int) size + index)); }
 
   /*! Parse differently formated triplets like: n0, n0/n1/n2, n0//n2, n0/n1.          */
   /*! All indices are converted to C-style (from 0). Missing entries are assigned -1. */
-  Vertex OBJLoader::getUInt3(const char*& token)
+  Vertex OBJLoader::getUInt3(const char*& token, size_t numV, size_t numVT, size_t numVN)
   {
     Vertex v(-1);
-    v.v = fix_v(atoi(token));
+    v.v = fix(atoi(token),numV);
     token += strcspn(token, "/ \t\r");
     if (token[0] != '/') return(v);
     token++;
@@ -485,19 +652,19 @@ namespace embree
     // it is i//n
     if (token[0] == '/') {
       token++;
-      v.vn = fix_vn(atoi(token));
+      v.vn = fix(atoi(token),numVN);
       token += strcspn(token, " \t\r");
       return(v);
     }
 
     // it is i/t/n or i/t
-    v.vt = fix_vt(atoi(token));
+    v.vt = fix(atoi(token),numVT);
     token += strcspn(token, "/ \t\r");
     if (token[0] != '/') return(v);
     token++;
 
     // it is i/t/n
-    v.vn = fix_vn(atoi(token));
+    v.vn = fix(atoi(token),numVN);
     token += strcspn(token, " \t\r");
     return(v);
   }
@@ -534,30 +701,36 @@ namespace embree
   /*! end current facegroup and append to mesh */
   void OBJLoader::flushTriGroup()
   {
-    if (curGroup.empty()) return;
+    if (curGroupBegin == curGroupEnd) return;
+    const size_t numFaces = curGroupEnd-curGroupBegin;
+    const size_t numFaceVertices = faceBegin[curGroupEnd]-faceBegin[curGroupBegin];
 
     if (subdivMode)
     {
       Ref<SceneGraph::SubdivMeshNode> mesh = new SceneGraph::SubdivMeshNode(curMaterial,1);
       group->add(mesh.cast<SceneGraph::Node>());
 
-      for (size_t i=0; i<v.size();  i++) mesh->positions[0].push_back(v[i]);
-      for (size_t i=0; i<vn.size(); i++) mesh->normals[0].push_back(vn[i]);
-      for (size_t i=0; i<vt.size(); i++) mesh->texcoords.push_back(vt[i]);
+      for (size_t i=0; i<curNumV;  i++) mesh->positions[0].push_back(v[i]);
+      for (size_t i=0; i<curNumVN; i++) mesh->normals[0].push_back(vn[i]);
+      for (size_t i=0; i<curNumVT; i++) mesh->texcoords.push_back(vt[i]);
       
       for (size_t i=0; i<ec.size(); ++i) {
-        assert(((size_t)ec[i].a < v.size()) && ((size_t)ec[i].b < v.size()));
+        assert(((size_t)ec[i].a < curNumV) && ((size_t)ec[i].b < curNumV));
         mesh->edge_creases.push_back(Vec2i(ec[i].a, ec[i].b));
         mesh->edge_crease_weights.push_back(ec[i].w);
       }
-      
-      for (size_t j=0; j<curGroup.size(); j++)
+
+      mesh->verticesPerFace.resize(numFaces);
+      mesh->position_indices.resize(numFaceVertices);
+      parallel_for(curGroupBegin, curGroupEnd, size_t(4096), [&](const range<size_t>& r)
       {
-        const std::vector<Vertex>& face = curGroup[j];
-        mesh->verticesPerFace.push_back(int(face.size()));
-        for (size_t i=0; i<face.size(); i++)
-          mesh->position_indices.push_back(face[i].v);
-      }
+        for (size_t f=r.begin(); f<r.end(); f++)
+        {
+          mesh->verticesPerFace[f-curGroupBegin] = unsigned(faceBegin[f+1]-faceBegin[f]);
+          for (size_t i=faceBegin[f]; i<faceBegin[f+1]; i++)
+            mesh->position_indices[i-faceBegin[curGroupBegin]] = faceVertices[i].v;
+        }
+      });
       if (mesh->normals[0].size() == 0)
         mesh->normals.clear();
       mesh->verify();
@@ -566,26 +739,123 @@ namespace embree
     {
       Ref<SceneGraph::TriangleMeshNode> mesh = new SceneGraph::TriangleMeshNode(curMaterial,1);
       group->add(mesh.cast<SceneGraph::Node>());
-      // merge three indices into one
-      std::map<Vertex, uint32_t> vertexMap;
-      for (size_t j=0; j<curGroup.size(); j++)
+
+      /* faces get triangulated with a triangle fan */
+      auto numTriangles = [&] (size_t f) -> size_t {
+        const size_t n = faceBegin[f+1]-faceBegin[f];
+        return n >= 3 ? n-2 : 0;
+      };
+
+      /* when normals and texture coordinates use the same indices as
+       * the positions (or are not present), the vertices can get
+       * merged in parallel, otherwise we merge all three indices */
+      const Vertex& first = faceVertices[faceBegin[curGroupBegin]];
+      const bool hasVN = numFaceVertices && first.vn != unsigned(-1);
+      const bool hasVT = numFaceVertices && first.vt != unsigned(-1);
+      const bool positionIndexed = numFaceVertices && parallel_reduce(curGroupBegin, curGroupEnd, size_t(4096), true, [&](const range<size_t>& r) -> bool
       {
-        /* iterate over all faces */
-        const std::vector<Vertex>& face = curGroup[j];
-        
-        /* triangulate the face with a triangle fan */
-        Vertex i0 = face[0], i1 = Vertex(-1), i2 = face[1];
-        for (size_t k=2; k < face.size(); k++) 
+        for (size_t f=r.begin(); f<r.end(); f++)
+        {
+          if (numTriangles(f) == 0) continue;
+          for (size_t i=faceBegin[f]; i<faceBegin[f+1]; i++)
+          {
+            const Vertex& x = faceVertices[i];
+            if (x.v >= v.size()) return false;
+            if (hasVN ? x.vn != x.v || x.vn >= vn.size() : x.vn != unsigned(-1)) return false;
+            if (hasVT ? x.vt != x.v || x.vt >= vt.size() : x.vt != unsigned(-1)) return false;
+          }
+        }
+        return true;
+      }, [](bool a, bool b) { return a && b; });
+
+      if (positionIndexed)
+      {
+        /* groups typically reference a small range of all positions
+         * read so far, thus the work below is limited to that range */
+        typedef std::pair<size_t,size_t> Range;
+        const Range vrange = parallel_reduce(curGroupBegin, curGroupEnd, size_t(4096), Range(v.size(),0), [&](const range<size_t>& r) -> Range
+        {
+          Range vr(v.size(),0);
+          for (size_t f=r.begin(); f<r.end(); f++)
+            if (numTriangles(f))
+              for (size_t i=faceBegin[f]; i<faceBegin[f+1]; i++) {
+                vr.first  = min(vr.first, size_t(faceVertices[i].v));
+                vr.second = max(vr.second,size_t(faceVertices[i].v)+1);
+              }
+          return vr;
+        }, [](const Range& a, const Range& b) { return Range(min(a.first,b.first),max(a.second,b.second)); });
+        const size_t vbegin = min(vrange.first,vrange.second);
+        const size_t vcount = vrange.second-vbegin;
+
+        /* mark all used positions */
+        std::vector<std::atomic<unsigned int>> used(vcount);
+        parallel_for(curGroupBegin, curGroupEnd, size_t(4096), [&](const range<size_t>& r) {
+            for (size_t f=r.begin(); f<r.end(); f++)
+              if (numTriangles(f))
+                for (size_t i=faceBegin[f]; i<faceBegin[f+1]; i++)
+                  used[faceVertices[i].v-vbegin].store(1,std::memory_order_relaxed);
+          });
+
+        /* compact the used positions, normals, and texture coordinates */
+        std::vector<unsigned int> remap(vcount);
+        const size_t numVertices = parallel_prefix_sum(used,remap,vcount,0u,std::plus<unsigned int>());
+        mesh->positions[0].resize(numVertices);
+        if (hasVN) mesh->normals[0].resize(numVertices);
+        if (hasVT) mesh->texcoords.resize(numVertices);
+        parallel_for(size_t(0), vcount, size_t(4096), [&](const range<size_t>& r) {
+            for (size_t i=r.begin(); i<r.end(); i++)
+            {
+              if (!used[i]) continue;
+              mesh->positions[0][remap[i]] = v[vbegin+i];
+              if (hasVN) mesh->normals[0][remap[i]] = vn[vbegin+i];
+              if (hasVT) mesh->texcoords[remap[i]] = vt[vbegin+i];
+            }
+          });
+
+        /* triangulate all faces, the first pass counts the triangles of each task */
+        ParallelPrefixSumState<size_t> pstate;
+        const size_t numTris = parallel_prefix_sum(pstate, curGroupBegin, curGroupEnd, size_t(4096), size_t(0), [&](const range<size_t>& r, const size_t base) -> size_t {
+            size_t n = 0;
+            for (size_t f=r.begin(); f<r.end(); f++) n += numTriangles(f);
+            return n;
+          }, std::plus<size_t>());
+
+        mesh->triangles.resize(numTris);
+        parallel_prefix_sum(pstate, curGroupBegin, curGroupEnd, size_t(4096), size_t(0), [&](const range<size_t>& r, const size_t base) -> size_t {
+            size_t t = base;
+            for (size_t f=r.begin(); f<r.end(); f++)
+            {
+              const Vertex* face = &faceVertices[faceBegin[f]];
+              const unsigned int v0 = remap[face[0].v-vbegin];
+              for (size_t k=2; k < faceBegin[f+1]-faceBegin[f]; k++)
+                mesh->triangles[t++] = SceneGraph::TriangleMeshNode::Triangle(v0,remap[face[k-1].v-vbegin],remap[face[k].v-vbegin]);
+            }
+            return t-base;
+          }, std::plus<size_t>());
+      }
+      else
+      {
+        /* merge three indices into one */
+        std::map<Vertex, uint32_t> vertexMap;
+        for (size_t f=curGroupBegin; f<curGroupEnd; f++)
         {
-          i1 = i2; i2 = face[k];
-          uint32_t v0,v1,v2;
-          v0 = getVertex(vertexMap, mesh, i0);
-          v1 = getVertex(vertexMap, mesh, i1);
-          v2 = getVertex(vertexMap, mesh, i2);
-          assert(v0 < mesh->numVertices());
-          assert(v1 < mesh->numVertices());
-          assert(v2 < mesh->numVertices());
-          mesh->triangles.push_back(SceneGraph::TriangleMeshNode::Triangle(v0,v1,v2));
+          if (numTriangles(f) == 0) continue;
+
+          /* triangulate the face with a triangle fan */
+          const Vertex* face = &faceVertices[faceBegin[f]];
+          Vertex i0 = face[0], i1 = Vertex(-1), i2 = face[1];
+          for (size_t k=2; k < faceBegin[f+1]-faceBegin[f]; k++) 
+          {
+            i1 = i2; i2 = face[k];
+            uint32_t v0,v1,v2;
+            v0 = getVertex(vertexMap, mesh, i0);
+            v1 = getVertex(vertexMap, mesh, i1);
+            v2 = getVertex(vertexMap, mesh, i2);
+            assert(v0 < mesh->numVertices());
+            assert(v1 < mesh->numVertices());
+            assert(v2 < mesh->numVertices());
+            mesh->triangles.push_back(SceneGraph::TriangleMeshNode::Triangle(v0,v1,v2));
+          }
         }
       }
       /* there may be vertices without normals or texture coordinates, thus we have to make these arrays the same size here */
@@ -597,7 +867,7 @@ namespace embree
       mesh->verify();
     }
     
-    curGroup.clear();
+    curGroupBegin = curGroupEnd;
     ec.clear();
   }
 
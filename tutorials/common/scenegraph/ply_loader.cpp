@@ -15,6 +15,9 @@
 // ======================================================================== //
 
 #include "ply_loader.h"
+#include "../../../common/sys/mapped_file.h"
+#include "../../../common/algorithms/parallel_for.h"
+#include "../../../common/algorithms/parallel_prefix_sum.h"
 #include <list>
 
 namespace embree
@@ -29,6 +32,14 @@ namespace embree
       Type(Tag ty, Tag index, Tag data) : ty(ty), index(index), data(data) {}
     };
 
+    /*! list property of all data items of an element, the lists are stored consecutively */
+    struct List {
+      std::vector<size_t> begin;               /// start of the list of each data item, plus end of the last list
+      std::vector<size_t> items;               /// list entries of all data items
+      size_t size(size_t i) const { return begin[i+1]-begin[i]; }
+      const size_t* operator[] (size_t i) const { return items.data()+begin[i]; }
+    };
+
     /*! an element stored in the PLY file, such as vertex, face, etc. */
     struct Element {
       std::string name;
@@ -36,7 +47,7 @@ namespace embree
       std::vector<std::string> properties;     /// list of all properties of the element (e.g. x, y, z) (not strictly necessary)
       std::map<std::string,Type> type;         /// mapping of property name to type
       std::map<std::string,std::vector<float> > data;                /// data array properties (all represented as floats)
-      std::map<std::string,std::vector<std::vector<size_t> > > list; /// list properties (integer lists supported only)
+      std::map<std::string,List> list;         /// list properties (integer lists supported only)
     };
 
     /*! mesh structure that reflects the PLY file format */
@@ -106,28 +117,31 @@ namespace embree
     /* PLY parser class */
     struct PlyParser
     {
-      std::fstream fs;
+      MappedFile file;
+      const char* ptr;   /// current position in the file
+      const char* end;   /// end of the file
       Mesh mesh;
       Ref<SceneGraph::Node> scene;
 
       /* storage format of data in file */
       enum Format { ASCII, BINARY_BIG_ENDIAN, BINARY_LITTLE_ENDIAN } format;
 
+      /* start of each line of the data of ASCII files */
+      std::vector<const char*> lines;
+      size_t numLinesParsed;
+
       /* constructor parses the input stream */
-      PlyParser(const FileName& fileName) : format(ASCII)
+      PlyParser(const FileName& fileName) : file(fileName), ptr(file.data()), end(file.data()+file.size()), format(ASCII), numLinesParsed(0)
       {
-        /* open file */
-        fs.open (fileName.c_str(), std::fstream::in | std::fstream::binary);
-        if (!fs.is_open()) throw std::runtime_error("cannot open file : " + fileName.str());
-
         /* check for file signature */
-        std::string signature; getline(fs,signature);
+        std::string signature = getHeaderLine();
         if (signature != "ply") throw std::runtime_error("invalid PLY file signature: " + signature);
         
         /* read header */
         std::list<std::string> header;
         while (true) {
-          std::string line; getline(fs,line);
+          if (ptr >= end) throw std::runtime_error("unexpected end of PLY header");
+          std::string line = getHeaderLine();
           if (line == "end_header") break;
           if (line.find_first_of('#') == 0) continue;
           if (line == "") continue;
@@ -137,6 +151,10 @@ namespace embree
         /* parse header */
         parseHeader(header);
 
+        /* ASCII files store one data item per line */
+        if (format == ASCII)
+          findLines();
+
         /* now parse all elements */
         for (std::vector<std::string>::iterator i = mesh.order.begin(); i!=mesh.order.end(); i++)
           parseElementData(mesh.elements[*i]);
@@ -145,6 +163,54 @@ namespace embree
         scene = import();
       }
 
+      /* reads a line of the header */
+      std::string getHeaderLine()
+      {
+        const char* eol = (const char*) memchr(ptr,'\n',end-ptr);
+        if (eol == nullptr) eol = end;
+        std::string line(ptr,eol);
+        ptr = eol < end ? eol+1 : end;
+        if (!line.empty() && line[line.size()-1] == '\r') line.resize(line.size()-1);
+        return line;
+      }
+
+      /* calls func for the first non whitespace character of each non-empty line starting in [b,e) */
+      template<typename Func>
+      void forEachLine(const char* begin, const char* b, const char* e, const Func& func)
+      {
+        for (const char* p=b; p<e; p++)
+        {
+          if (p != begin && p[-1] != '\n') continue;
+          const char* q = p;
+          while (q < end && *q != '\n' && isspace((unsigned char)*q)) q++;
+          if (q < end && *q != '\n') func(q);
+        }
+      }
+
+      /* finds the start of all non-empty lines after the header in parallel */
+      void findLines()
+      {
+        const char* begin = ptr;
+        const size_t bytes = end-begin;
+        const size_t chunkBytes = 1024*1024;
+        const size_t numChunks = max(size_t(1),bytes/chunkBytes);
+
+        std::vector<size_t> counts(numChunks+1);
+        parallel_for(numChunks, [&](const size_t i) {
+            size_t n = 0;
+            forEachLine(begin,begin+i*bytes/numChunks,begin+(i+1)*bytes/numChunks,[&] (const char*) { n++; });
+            counts[i] = n;
+          });
+        for (size_t i=0, sum=0; i<=numChunks; i++) {
+          const size_t n = counts[i]; counts[i] = sum; sum += n;
+        }
+        lines.resize(counts[numChunks]);
+        parallel_for(numChunks, [&](const size_t i) {
+            size_t n = counts[i];
+            forEachLine(begin,begin+i*bytes/numChunks,begin+(i+1)*bytes/numChunks,[&] (const char* p) { lines[n++] = p; });
+          });
+      }
+
       /* parse the PLY header */
       void parseHeader(std::list<std::string>& header) 
       {
@@ -221,82 +287,168 @@ namespace embree
         } else return Type(typeTagOfString(ty));
       }
 
+      /* a property of an element with the array to store it into */
+      struct Property
+      {
+        Type ty;
+        std::vector<float>* data;
+        List* list;
+      };
+
+      /* reads the properties of a data item of an element */
+      struct Reader
+      {
+        Reader (Format format, const char* ptr, const char* end)
+          : format(format), ptr(ptr), end(end) {}
+
+        /* reads a number of the data item */
+        double read(Type::Tag ty)
+        {
+          if (format == ASCII)
+          {
+            while (ptr < end && (*ptr == ' ' || *ptr == '\t')) ptr++;
+            const char* b = ptr;
+            while (ptr < end && !isspace((unsigned char)*ptr)) ptr++;
+            if (b == ptr) throw std::runtime_error("unexpected end of line in PLY file");
+            token.assign(b,ptr);
+            return atof(token.c_str());
+          }
+
+          const size_t bytes = sizeOfType(ty);
+          if (ptr+bytes > end) throw std::runtime_error("unexpected end of PLY file");
+          unsigned char data[8];
+          if (format == BINARY_LITTLE_ENDIAN) for (size_t i=0; i<bytes; i++) data[i] = ptr[i];
+          else                                for (size_t i=0; i<bytes; i++) data[i] = ptr[bytes-i-1];
+          ptr += bytes;
+
+          switch (ty) {
+          case Type::PTY_CHAR   : return *(signed char*   )data;
+          case Type::PTY_UCHAR  : return *(unsigned char* )data;
+          case Type::PTY_SHORT  : return *(signed short*  )data;
+          case Type::PTY_USHORT : return *(unsigned short*)data;
+          case Type::PTY_INT    : return *(signed int*    )data;
+          case Type::PTY_UINT   : return *(unsigned int*  )data;
+          case Type::PTY_FLOAT  : return *(float*         )data;
+          case Type::PTY_DOUBLE : return *(double*        )data;
+          default : throw std::runtime_error("invalid type");
+          }
+        }
+
+        /* skips count many numbers of binary files */
+        void skip(Type::Tag ty, size_t count)
+        {
+          const size_t bytes = count*sizeOfType(ty);
+          if (ptr+bytes > end) throw std::runtime_error("unexpected end of PLY file");
+          ptr += bytes;
+        }
+
+        Format format;
+        const char* ptr;
+        const char* end;
+        std::string token;
+      };
+
       /* parses data of a PLY element */
       void parseElementData(Element& elt) 
       {
         /* allocate data for all properties */
-        for (std::vector<std::string>::iterator i=elt.properties.begin(); i!=elt.properties.end(); i++) {
-          if (elt.type[*i].ty == Type::PTY_LIST) elt.list[*i] = std::vector<std::vector<size_t> >();
-          else elt.data[*i] = std::vector<float>();
-        }
-        
-        /* parse all elements */
-        for (size_t e=0; e<elt.size; e++)
+        std::vector<Property> props;
+        bool hasLists = false;
+        for (std::vector<std::string>::iterator i=elt.properties.begin(); i!=elt.properties.end(); i++)
         {
-          /* load all properties of the element */
-          for (std::vector<std::string>::iterator i=elt.properties.begin(); i!=elt.properties.end(); i++) {
-            Type ty = elt.type[*i];
-            if (ty.ty == Type::PTY_LIST) loadPropertyList(elt.list[*i],ty.index,ty.data);
-            else loadPropertyData(elt.data[*i],ty.ty);
+          Property prop; prop.ty = elt.type[*i]; prop.data = nullptr; prop.list = nullptr;
+          if (prop.ty.ty == Type::PTY_LIST) {
+            prop.list = &elt.list[*i];
+            prop.list->begin.resize(elt.size+1);
+            hasLists = true;
+          } else {
+            prop.data = &elt.data[*i];
+            prop.data->resize(elt.size);
           }
+          props.push_back(prop);
         }
-      }
 
-      /* load bytes from file and take care of little and big endian encoding */
-      void readBytes(void* dst, int num) {
-        if (format == BINARY_LITTLE_ENDIAN) fs.read((char*)dst,num);
-        else if (format == BINARY_BIG_ENDIAN) for (int i=0; i<num; i++) fs.read((char*)dst+num-i-1,1);
-        else throw std::runtime_error("internal error on PLY loader");
-      }
-      
-      int            read_ascii_int  () { int i;   fs >> i; return i; }
-      float          read_ascii_float() { float f; fs >> f; return f; }
-      signed char    read_char  () { if (format == ASCII) return read_ascii_int();   signed char r = 0;    readBytes(&r,1); return r; }
-      unsigned char  read_uchar () { if (format == ASCII) return read_ascii_int();   unsigned char r = 0;  readBytes(&r,1); return r; }
-      signed short   read_short () { if (format == ASCII) return read_ascii_int();   signed short r = 0;   readBytes(&r,2); return r; }
-      unsigned short read_ushort() { if (format == ASCII) return read_ascii_int();   unsigned short r = 0; readBytes(&r,2); return r; }
-      signed int     read_int   () { if (format == ASCII) return read_ascii_int();   signed int r = 0;     readBytes(&r,4); return r; }
-      unsigned int   read_uint  () { if (format == ASCII) return read_ascii_int();   unsigned int r = 0;   readBytes(&r,4); return r; }
-      float          read_float () { if (format == ASCII) return read_ascii_float(); float r = 0;          readBytes(&r,4); return r; }
-      double         read_double() { if (format == ASCII) return read_ascii_float(); double r = 0;         readBytes(&r,8); return r; }
-
-      /* load an integer type */
-      size_t loadInteger(Type::Tag ty)
-      {
-        switch (ty) {
-        case Type::PTY_CHAR   : return read_char(); break;
-        case Type::PTY_UCHAR  : return read_uchar(); break;
-        case Type::PTY_SHORT  : return read_short(); break;
-        case Type::PTY_USHORT : return read_ushort(); break;
-        case Type::PTY_INT    : return read_int(); break;
-        case Type::PTY_UINT   : return read_uint(); break;
-        default : throw std::runtime_error("invalid type"); return 0;
+        /* find the start of each data item */
+        std::vector<const char*> items(elt.size+1);
+        if (format == ASCII)
+        {
+          if (numLinesParsed+elt.size > lines.size()) throw std::runtime_error("unexpected end of PLY file");
+          for (size_t e=0; e<elt.size; e++) items[e] = lines[numLinesParsed+e];
+          numLinesParsed += elt.size;
+          items[elt.size] = numLinesParsed < lines.size() ? lines[numLinesParsed] : end;
         }
-      }
-        
-      /* load a list */
-      void loadPropertyList(std::vector<std::vector<size_t> >& vec,Type::Tag index_ty,Type::Tag data_ty)
-      {
-        std::vector<size_t> lst;
-        size_t num = loadInteger(index_ty);
-        for (size_t i=0; i<num; i++) lst.push_back(loadInteger(data_ty));
-        vec.push_back(lst);
-      }
+        else if (!hasLists)
+        {
+          size_t bytes = 0;
+          for (size_t i=0; i<props.size(); i++) bytes += sizeOfType(props[i].ty.ty);
+          if (elt.size*bytes > size_t(end-ptr)) throw std::runtime_error("unexpected end of PLY file");
+          for (size_t e=0; e<=elt.size; e++) items[e] = ptr+e*bytes;
+        }
+        else
+        {
+          /* data items have different sizes, thus only read the sizes of all lists */
+          Reader reader(format,ptr,end);
+          for (size_t e=0; e<elt.size; e++)
+          {
+            items[e] = reader.ptr;
+            for (size_t i=0; i<props.size(); i++) {
+              if (props[i].ty.ty == Type::PTY_LIST) reader.skip(props[i].ty.data,size_t(reader.read(props[i].ty.index)));
+              else reader.skip(props[i].ty.ty,1);
+            }
+          }
+          items[elt.size] = reader.ptr;
+        }
+        if (format != ASCII) ptr = items[elt.size];
 
-      /* load a data element */
-      void loadPropertyData(std::vector<float>& vec, Type::Tag ty) 
-      {
-        switch (ty) {
-        case Type::PTY_CHAR   : vec.push_back(float(read_char()));   break;
-        case Type::PTY_UCHAR  : vec.push_back(float(read_uchar()));  break;
-        case Type::PTY_SHORT  : vec.push_back(float(read_short()));  break;
-        case Type::PTY_USHORT : vec.push_back(float(read_ushort())); break;
-        case Type::PTY_INT    : vec.push_back(float(read_int()));    break;
-        case Type::PTY_UINT   : vec.push_back(float(read_uint()));   break;
-        case Type::PTY_FLOAT  : vec.push_back(float(read_float()));  break;
-        case Type::PTY_DOUBLE : vec.push_back(float(read_double())); break;
-        default : throw std::runtime_error("invalid type");
+        /* parses the data items in parallel, the first pass only counts the entries of the lists */
+        auto parseItems = [&] (bool countOnly)
+        {
+          parallel_for(size_t(0), elt.size, size_t(4096), [&](const range<size_t>& r)
+          {
+            Reader reader(format,nullptr,nullptr);
+            for (size_t e=r.begin(); e<r.end(); e++)
+            {
+              reader.ptr = items[e];
+              reader.end = format == ASCII ? (const char*) memchr(items[e],'\n',end-items[e]) : items[e+1];
+              if (reader.end == nullptr) reader.end = end;
+
+              for (size_t i=0; i<props.size(); i++)
+              {
+                const Property& prop = props[i];
+                if (prop.list == nullptr) {
+                  const float f = float(reader.read(prop.ty.ty));
+                  if (!countOnly) (*prop.data)[e] = f;
+                  continue;
+                }
+                
+                const size_t num = size_t(reader.read(prop.ty.index));
+                if (countOnly) {
+                  prop.list->begin[e] = num;
+                  if (format != ASCII) reader.skip(prop.ty.data,num);
+                  else for (size_t j=0; j<num; j++) reader.read(prop.ty.data);
+                  continue;
+                }
+                size_t* dst = prop.list->items.data()+prop.list->begin[e];
+                for (size_t j=0; j<num; j++) dst[j] = size_t(reader.read(prop.ty.data));
+              }
+            }
+          });
+        };
+
+        if (hasLists)
+        {
+          parseItems(true);
+          for (size_t i=0; i<props.size(); i++)
+          {
+            if (props[i].list == nullptr) continue;
+            std::vector<size_t>& begin = props[i].list->begin;
+            const std::vector<size_t> counts(begin.begin(),begin.begin()+elt.size);
+            const size_t num = parallel_prefix_sum(counts,begin,elt.size,size_t(0),std::plus<size_t>());
+            begin[elt.size] = num;
+            props[i].list->items.resize(num);
+          }
         }
+        parseItems(false);
       }
 
       Ref<SceneGraph::Node> import()
@@ -311,28 +463,40 @@ namespace embree
         const std::vector<float>& posz = vertices.data.at("z");
         
         mesh_o->positions[0].resize(vertices.size);
-        for (size_t i=0; i<vertices.size; i++) {
-          mesh_o->positions[0][i].x = posx[i];
-          mesh_o->positions[0][i].y = posy[i];
-          mesh_o->positions[0][i].z = posz[i];
-        }
+        parallel_for(size_t(0), vertices.size, size_t(4096), [&](const range<size_t>& r) {
+            for (size_t i=r.begin(); i<r.end(); i++) {
+              mesh_o->positions[0][i].x = posx[i];
+              mesh_o->positions[0][i].y = posy[i];
+              mesh_o->positions[0][i].z = posz[i];
+            }
+          });
 
         /* convert all faces */
         const Element& faces = mesh.elements.at("face");
-        const std::vector<std::vector<size_t> >& polygons = faces.list.at("vertex_indices");
-        
-        for (size_t j=0; j<polygons.size(); j++)
-        {
-          const std::vector<size_t>& face = polygons[j];
-          if (face.size() < 3) continue;
-          
-          /* triangulate the face with a triangle fan */
-          size_t i0 = face[0], i1 = 0, i2 = face[1];
-          for (size_t k=2; k<face.size(); k++) {
-            i1 = i2; i2 = face[k];
-            mesh_o->triangles.push_back(SceneGraph::TriangleMeshNode::Triangle((unsigned int)i0, (unsigned int)i1, (unsigned int)i2));
-          }
-        }
+        const List& polygons = faces.list.at("vertex_indices");
+        auto numTriangles = [&] (size_t j) -> size_t {
+          return polygons.size(j) >= 3 ? polygons.size(j)-2 : 0;
+        };
+
+        /* count triangles of each task in the first pass, triangulate the faces with a triangle fan in the second pass */
+        ParallelPrefixSumState<size_t> pstate;
+        const size_t numTris = parallel_prefix_sum(pstate, size_t(0), faces.size, size_t(4096), size_t(0), [&](const range<size_t>& r, const size_t base) -> size_t {
+            size_t n = 0;
+            for (size_t j=r.begin(); j<r.end(); j++) n += numTriangles(j);
+            return n;
+          }, std::plus<size_t>());
+
+        mesh_o->triangles.resize(numTris);
+        parallel_prefix_sum(pstate, size_t(0), faces.size, size_t(4096), size_t(0), [&](const range<size_t>& r, const size_t base) -> size_t {
+            size_t t = base;
+            for (size_t j=r.begin(); j<r.end(); j++)
+            {
+              const size_t* face = polygons[j];
+              for (size_t k=2; k<polygons.size(j); k++)
+                mesh_o->triangles[t++] = SceneGraph::TriangleMeshNode::Triangle((unsigned int)face[0], (unsigned int)face[k-1], (unsigned int)face[k]);
+            }
+            return t-base;
+          }, std::plus<size_t>());
         return mesh_o.dynamicCast<SceneGraph::Node>();
       }
     };
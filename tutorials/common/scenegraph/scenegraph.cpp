@@ -881,6 +881,46 @@ namespace embree
     else return std::make_pair(0,-1);
   }
   
+  /*! applies a conversion to all geometries of the scene graph, groups
+      and transforms get updated in place; each node reachable through
+      multiple paths gets converted only once, thus shared geometries stay
+      shared and are not duplicated */
+  template<typename Convert>
+  struct SceneGraphConverter
+  {
+    SceneGraphConverter (const Convert& convert)
+      : convert(convert) {}
+
+    Ref<SceneGraph::Node> operator() (const Ref<SceneGraph::Node>& node)
+    {
+      auto i = converted.find(node);
+      if (i != converted.end()) return i->second;
+
+      Ref<SceneGraph::Node> result = node;
+      if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
+        xfmNode->child = (*this)(xfmNode->child);
+      } 
+      else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
+      {
+        for (size_t i=0; i<groupNode->children.size(); i++) 
+          groupNode->children[i] = (*this)(groupNode->children[i]);
+      }
+      else if (node) {
+        result = convert(node);
+      }
+      return converted[node] = result;
+    }
+
+  private:
+    const Convert& convert;
+    std::map<Ref<SceneGraph::Node>,Ref<SceneGraph::Node>> converted;
+  };
+
+  template<typename Convert>
+  Ref<SceneGraph::Node> convert_geometries(Ref<SceneGraph::Node> node, const Convert& convert) {
+    return SceneGraphConverter<Convert>(convert)(node);
+  }
+
   Ref<SceneGraph::Node> SceneGraph::convert_triangles_to_quads ( Ref<SceneGraph::TriangleMeshNode> tmesh )
   {
     Ref<SceneGraph::QuadMeshNode> qmesh = new SceneGraph::QuadMeshNode(tmesh->material);
@@ -922,19 +962,12 @@ namespace embree
 
   Ref<SceneGraph::Node> SceneGraph::convert_triangles_to_quads(Ref<SceneGraph::Node> node, float prop)
   {
-    if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
-      xfmNode->child = convert_triangles_to_quads(xfmNode->child,prop);
-    } 
-    else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
-    {
-      for (size_t i=0; i<groupNode->children.size(); i++) 
-        groupNode->children[i] = convert_triangles_to_quads(groupNode->children[i],prop);
-    }
-    else if (Ref<SceneGraph::TriangleMeshNode> tmesh = node.dynamicCast<SceneGraph::TriangleMeshNode>()) {
-      if (random<float>() <= prop) return convert_triangles_to_quads(tmesh);
-      else                         return node;
-    }
-    return node;
+    return convert_geometries(node, [&] (Ref<SceneGraph::Node> node) -> Ref<SceneGraph::Node> {
+        if (Ref<SceneGraph::TriangleMeshNode> tmesh = node.dynamicCast<SceneGraph::TriangleMeshNode>()) {
+          if (random<float>() <= prop) return convert_triangles_to_quads(tmesh);
+        }
+        return node;
+      });
   }
 
   Ref<SceneGraph::Node> SceneGraph::convert_quads_to_grids ( Ref<SceneGraph::QuadMeshNode> qmesh , const unsigned int resX, const unsigned int resY )
@@ -972,18 +1005,11 @@ namespace embree
 
   Ref<SceneGraph::Node> SceneGraph::convert_quads_to_grids(Ref<SceneGraph::Node> node, const unsigned int resX, const unsigned int resY )
   {
-    if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
-      xfmNode->child = convert_quads_to_grids(xfmNode->child, resX, resY);
-    } 
-    else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
-    {
-      for (size_t i=0; i<groupNode->children.size(); i++) 
-        groupNode->children[i] = convert_quads_to_grids(groupNode->children[i], resX, resY);
-    }
-    else if (Ref<SceneGraph::QuadMeshNode> qmesh = node.dynamicCast<SceneGraph::QuadMeshNode>()) {
-      return convert_quads_to_grids(qmesh, resX, resY);
-    }
-    return node;
+    return convert_geometries(node, [&] (Ref<SceneGraph::Node> node) -> Ref<SceneGraph::Node> {
+        if (Ref<SceneGraph::QuadMeshNode> qmesh = node.dynamicCast<SceneGraph::QuadMeshNode>())
+          return convert_quads_to_grids(qmesh, resX, resY);
+        return node;
+      });
   }
 
   Ref<SceneGraph::Node> SceneGraph::convert_grids_to_quads ( Ref<SceneGraph::GridMeshNode> gmesh )
@@ -1017,18 +1043,11 @@ namespace embree
 
   Ref<SceneGraph::Node> SceneGraph::convert_grids_to_quads(Ref<SceneGraph::Node> node)
   {
-    if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
-      xfmNode->child = convert_grids_to_quads(xfmNode->child);
-    } 
-    else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
-    {
-      for (size_t i=0; i<groupNode->children.size(); i++) 
-        groupNode->children[i] = convert_grids_to_quads(groupNode->children[i]);
-    }
-    else if (Ref<SceneGraph::GridMeshNode> gmesh = node.dynamicCast<SceneGraph::GridMeshNode>()) {
-      return convert_grids_to_quads(gmesh);
-    }
-    return node;
+    return convert_geometries(node, [&] (Ref<SceneGraph::Node> node) -> Ref<SceneGraph::Node> {
+        if (Ref<SceneGraph::GridMeshNode> gmesh = node.dynamicCast<SceneGraph::GridMeshNode>())
+          return convert_grids_to_quads(gmesh);
+        return node;
+      });
   }
   
   bool extend_grid(RTCGeometry geom, std::vector<bool>& visited, std::deque<unsigned int>& left, std::deque<unsigned int>& top, std::deque<unsigned int>& right)
@@ -1139,210 +1158,182 @@ namespace embree
     positions[height*(width+1)+width] = vertices[indices[edgex]];
   }
 
-  Ref<SceneGraph::Node> SceneGraph::my_merge_quads_to_grids(Ref<SceneGraph::Node> node)
+  static Ref<SceneGraph::Node> merge_quads_to_grids(Ref<SceneGraph::QuadMeshNode> qmesh)
   {
-    if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
-      xfmNode->child = my_merge_quads_to_grids(xfmNode->child);
-    }
-    else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
-    {
-      for (size_t i=0; i<groupNode->children.size(); i++) 
-        groupNode->children[i] = my_merge_quads_to_grids(groupNode->children[i]);
-    }
-    else if (Ref<SceneGraph::QuadMeshNode> qmesh = node.dynamicCast<SceneGraph::QuadMeshNode>()) 
-    {
-      Ref<SceneGraph::GridMeshNode> gmesh = new SceneGraph::GridMeshNode(qmesh->material,qmesh->numTimeSteps());
+    Ref<SceneGraph::GridMeshNode> gmesh = new SceneGraph::GridMeshNode(qmesh->material,qmesh->numTimeSteps());
+    
+    std::vector<bool> visited;
+    visited.resize(qmesh->numPrimitives());
+    for (size_t i=0; i<visited.size(); i++) visited[i] = false;
+    std::vector<unsigned int> faces(qmesh->numPrimitives());
+    for (size_t i=0; i<faces.size(); i++) faces[i] = 4;
+
+    /* create temporary subdiv mesh to get access to mesh topology */
+    RTCGeometry geom = rtcNewGeometry(g_device,RTC_GEOMETRY_TYPE_SUBDIVISION);
+    rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_FACE,   0, RTC_FORMAT_UINT,   faces.data(), 0, sizeof(unsigned int), qmesh->numPrimitives());
+    rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX,  0, RTC_FORMAT_UINT,   qmesh->quads.data(), 0, sizeof(unsigned int), 4*qmesh->numPrimitives());
+    rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, qmesh->positions[0].data(), 0, sizeof(Vec3fa), qmesh->numVertices());
+    rtcCommitGeometry(geom);
+
+    /* iterate over mesh and collect all grids */
+    for (unsigned int i=0; i<qmesh->numPrimitives(); i++)
+    {
+      /* skip face if already added to some grid */
+      if (visited[i]) continue;
+      visited[i] = true;
+
+      /* initialize grid with start quad */
+      unsigned int edge = rtcGetGeometryFirstHalfEdge(geom,i);
+      std::deque<unsigned int> left, right, top, bottom;
+      left.push_back(edge);   edge = rtcGetGeometryNextHalfEdge(geom,edge);
+      bottom.push_back(edge); edge = rtcGetGeometryNextHalfEdge(geom,edge);
+      right.push_back(edge);  edge = rtcGetGeometryNextHalfEdge(geom,edge);
+      top.push_back(edge);    edge = rtcGetGeometryNextHalfEdge(geom,edge);
+      assert(edge == rtcGetGeometryFirstHalfEdge(geom,i));
       
-      std::vector<bool> visited;
-      visited.resize(qmesh->numPrimitives());
-      for (size_t i=0; i<visited.size(); i++) visited[i] = false;
-      std::vector<unsigned int> faces(qmesh->numPrimitives());
-      for (size_t i=0; i<faces.size(); i++) faces[i] = 4;
-
-      /* create temporary subdiv mesh to get access to mesh topology */
-      RTCGeometry geom = rtcNewGeometry(g_device,RTC_GEOMETRY_TYPE_SUBDIVISION);
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_FACE,   0, RTC_FORMAT_UINT,   faces.data(), 0, sizeof(unsigned int), qmesh->numPrimitives());
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_INDEX,  0, RTC_FORMAT_UINT,   qmesh->quads.data(), 0, sizeof(unsigned int), 4*qmesh->numPrimitives());
-      rtcSetSharedGeometryBuffer(geom, RTC_BUFFER_TYPE_VERTEX, 0, RTC_FORMAT_FLOAT3, qmesh->positions[0].data(), 0, sizeof(Vec3fa), qmesh->numVertices());
-      rtcCommitGeometry(geom);
-
-      /* iterate over mesh and collect all grids */
-      for (unsigned int i=0; i<qmesh->numPrimitives(); i++)
+      /* extend grid unless no longer possible */
+      unsigned int width = 1;
+      unsigned int height = 1;
+      while (true)
       {
-        /* skip face if already added to some grid */
-        if (visited[i]) continue;
-        visited[i] = true;
-
-        /* initialize grid with start quad */
-        unsigned int edge = rtcGetGeometryFirstHalfEdge(geom,i);
-        std::deque<unsigned int> left, right, top, bottom;
-        left.push_back(edge);   edge = rtcGetGeometryNextHalfEdge(geom,edge);
-        bottom.push_back(edge); edge = rtcGetGeometryNextHalfEdge(geom,edge);
-        right.push_back(edge);  edge = rtcGetGeometryNextHalfEdge(geom,edge);
-        top.push_back(edge);    edge = rtcGetGeometryNextHalfEdge(geom,edge);
-        assert(edge == rtcGetGeometryFirstHalfEdge(geom,i));
-        
-        /* extend grid unless no longer possible */
-        unsigned int width = 1;
-        unsigned int height = 1;
-        while (true)
-        {
-          const bool extended_top    = extend_grid(geom,visited,left,top,right);
-          const bool extended_right  = extend_grid(geom,visited,top,right,bottom);
-          const bool extended_bottom = extend_grid(geom,visited,right,bottom,left);
-          const bool extended_left   = extend_grid(geom,visited,bottom,left,top);
-          width  += extended_left + extended_right;
-          height += extended_top  + extended_bottom;
-          if (!extended_top && !extended_right && !extended_bottom && !extended_left) break;
-          if (width+2  > SceneGraph::GridMeshNode::GRID_RES_MAX) break;
-          if (height+2 > SceneGraph::GridMeshNode::GRID_RES_MAX) break;
-        }
-        
-        /* add new grid to grid mesh */
-        unsigned int startVertex = (unsigned int) gmesh->positions[0].size();
-        gmesh->grids.push_back(SceneGraph::GridMeshNode::Grid(startVertex,width+1,width+1,height+1));
+        const bool extended_top    = extend_grid(geom,visited,left,top,right);
+        const bool extended_right  = extend_grid(geom,visited,top,right,bottom);
+        const bool extended_bottom = extend_grid(geom,visited,right,bottom,left);
+        const bool extended_left   = extend_grid(geom,visited,bottom,left,top);
+        width  += extended_left + extended_right;
+        height += extended_top  + extended_bottom;
+        if (!extended_top && !extended_right && !extended_bottom && !extended_left) break;
+        if (width+2  > SceneGraph::GridMeshNode::GRID_RES_MAX) break;
+        if (height+2 > SceneGraph::GridMeshNode::GRID_RES_MAX) break;
+      }
+      
+      /* add new grid to grid mesh */
+      unsigned int startVertex = (unsigned int) gmesh->positions[0].size();
+      gmesh->grids.push_back(SceneGraph::GridMeshNode::Grid(startVertex,width+1,width+1,height+1));
 
-        /* gather all vertices of grid */
-        for (size_t t=0; t<qmesh->numTimeSteps(); t++)
-        {
-          avector<Vec3fa> positions;
-          positions.resize((width+1)*(height+1));
-          gather_grid(geom,positions,width,height,(unsigned int*)qmesh->quads.data(), qmesh->positions[t], left.front());
-          for (size_t i=0; i<positions.size(); i++)
-            gmesh->positions[t].push_back(positions[i]);
-        }
+      /* gather all vertices of grid */
+      for (size_t t=0; t<qmesh->numTimeSteps(); t++)
+      {
+        avector<Vec3fa> positions;
+        positions.resize((width+1)*(height+1));
+        gather_grid(geom,positions,width,height,(unsigned int*)qmesh->quads.data(), qmesh->positions[t], left.front());
+        for (size_t i=0; i<positions.size(); i++)
+          gmesh->positions[t].push_back(positions[i]);
       }
+    }
 
-      rtcReleaseGeometry(geom);
+    rtcReleaseGeometry(geom);
 
-      return gmesh.dynamicCast<SceneGraph::Node>();
-    }
-    return node;
+    return gmesh.dynamicCast<SceneGraph::Node>();
+  }
+
+  Ref<SceneGraph::Node> SceneGraph::my_merge_quads_to_grids(Ref<SceneGraph::Node> node)
+  {
+    return convert_geometries(node, [&] (Ref<SceneGraph::Node> node) -> Ref<SceneGraph::Node> {
+        if (Ref<SceneGraph::QuadMeshNode> qmesh = node.dynamicCast<SceneGraph::QuadMeshNode>())
+          return merge_quads_to_grids(qmesh);
+        return node;
+      });
   }
       
-  Ref<SceneGraph::Node> SceneGraph::convert_quads_to_subdivs(Ref<SceneGraph::Node> node)
+  static Ref<SceneGraph::Node> convert_quads_to_subdivs(Ref<SceneGraph::QuadMeshNode> tmesh)
   {
-    if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
-      xfmNode->child = convert_quads_to_subdivs(xfmNode->child);
-    } 
-    else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
-    {
-      for (size_t i=0; i<groupNode->children.size(); i++) 
-        groupNode->children[i] = convert_quads_to_subdivs(groupNode->children[i]);
-    }
-    else if (Ref<SceneGraph::QuadMeshNode> tmesh = node.dynamicCast<SceneGraph::QuadMeshNode>()) 
-    {
-      Ref<SceneGraph::SubdivMeshNode> smesh = new SceneGraph::SubdivMeshNode(tmesh->material);
-
-      for (auto& p : tmesh->positions)
-        smesh->positions.push_back(p);
+    Ref<SceneGraph::SubdivMeshNode> smesh = new SceneGraph::SubdivMeshNode(tmesh->material);
 
-      for (size_t i=0; i<tmesh->quads.size(); i++) {
-        smesh->position_indices.push_back(tmesh->quads[i].v0);
-        smesh->position_indices.push_back(tmesh->quads[i].v1);
-        smesh->position_indices.push_back(tmesh->quads[i].v2);
-        if (tmesh->quads[i].v2 != tmesh->quads[i].v3)
-          smesh->position_indices.push_back(tmesh->quads[i].v3);
-      }
-      
-      smesh->normals = tmesh->normals;
-      if (smesh->normals.size())
-        smesh->normal_indices = smesh->position_indices;
-      
-      smesh->texcoords = tmesh->texcoords;
-      if (smesh->texcoords.size())
-        smesh->texcoord_indices = smesh->position_indices;
-      
-      for (size_t i=0; i<tmesh->quads.size(); i++) 
-        smesh->verticesPerFace.push_back(3 + (int)(tmesh->quads[i].v2 != tmesh->quads[i].v3));
+    for (auto& p : tmesh->positions)
+      smesh->positions.push_back(p);
 
-      return smesh.dynamicCast<SceneGraph::Node>();
+    for (size_t i=0; i<tmesh->quads.size(); i++) {
+      smesh->position_indices.push_back(tmesh->quads[i].v0);
+      smesh->position_indices.push_back(tmesh->quads[i].v1);
+      smesh->position_indices.push_back(tmesh->quads[i].v2);
+      if (tmesh->quads[i].v2 != tmesh->quads[i].v3)
+        smesh->position_indices.push_back(tmesh->quads[i].v3);
     }
-    return node;
+    
+    smesh->normals = tmesh->normals;
+    if (smesh->normals.size())
+      smesh->normal_indices = smesh->position_indices;
+    
+    smesh->texcoords = tmesh->texcoords;
+    if (smesh->texcoords.size())
+      smesh->texcoord_indices = smesh->position_indices;
+    
+    for (size_t i=0; i<tmesh->quads.size(); i++) 
+      smesh->verticesPerFace.push_back(3 + (int)(tmesh->quads[i].v2 != tmesh->quads[i].v3));
+
+    return smesh.dynamicCast<SceneGraph::Node>();
   }
 
-  Ref<SceneGraph::Node> SceneGraph::convert_bezier_to_lines(Ref<SceneGraph::Node> node)
+  Ref<SceneGraph::Node> SceneGraph::convert_quads_to_subdivs(Ref<SceneGraph::Node> node)
   {
-    if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
-      xfmNode->child = convert_bezier_to_lines(xfmNode->child);
-    }
-    else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
-    {
-      for (size_t i=0; i<groupNode->children.size(); i++) 
-        groupNode->children[i] = convert_bezier_to_lines(groupNode->children[i]);
-    }
-    else if (Ref<SceneGraph::HairSetNode> hmesh = node.dynamicCast<SceneGraph::HairSetNode>()) 
-    {
-      Ref<SceneGraph::HairSetNode> lmesh = new SceneGraph::HairSetNode(RTC_GEOMETRY_TYPE_FLAT_LINEAR_CURVE, hmesh->material);
+    return convert_geometries(node, [&] (Ref<SceneGraph::Node> node) -> Ref<SceneGraph::Node> {
+        if (Ref<SceneGraph::QuadMeshNode> qmesh = node.dynamicCast<SceneGraph::QuadMeshNode>())
+          return embree::convert_quads_to_subdivs(qmesh);
+        return node;
+      });
+  }
 
-      for (auto& p : hmesh->positions)
-        lmesh->positions.push_back(p);
+  static Ref<SceneGraph::Node> convert_bezier_to_lines(Ref<SceneGraph::HairSetNode> hmesh)
+  {
+    Ref<SceneGraph::HairSetNode> lmesh = new SceneGraph::HairSetNode(RTC_GEOMETRY_TYPE_FLAT_LINEAR_CURVE, hmesh->material);
 
-      for (auto hair : hmesh->hairs) {
-        lmesh->hairs.push_back(SceneGraph::HairSetNode::Hair(hair.vertex+0,hair.id));
-        lmesh->hairs.push_back(SceneGraph::HairSetNode::Hair(hair.vertex+1,hair.id));
-        lmesh->hairs.push_back(SceneGraph::HairSetNode::Hair(hair.vertex+2,hair.id));
-      }
-      return lmesh.dynamicCast<SceneGraph::Node>();
+    for (auto& p : hmesh->positions)
+      lmesh->positions.push_back(p);
+
+    for (auto hair : hmesh->hairs) {
+      lmesh->hairs.push_back(SceneGraph::HairSetNode::Hair(hair.vertex+0,hair.id));
+      lmesh->hairs.push_back(SceneGraph::HairSetNode::Hair(hair.vertex+1,hair.id));
+      lmesh->hairs.push_back(SceneGraph::HairSetNode::Hair(hair.vertex+2,hair.id));
     }
-    return node;
+    return lmesh.dynamicCast<SceneGraph::Node>();
   }
 
-  Ref<SceneGraph::Node> SceneGraph::convert_flat_to_round_curves(Ref<SceneGraph::Node> node)
+  Ref<SceneGraph::Node> SceneGraph::convert_bezier_to_lines(Ref<SceneGraph::Node> node)
   {
-    if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
-      xfmNode->child = convert_flat_to_round_curves(xfmNode->child);
-    }
-    else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
-    {
-      for (size_t i=0; i<groupNode->children.size(); i++) 
-        groupNode->children[i] = convert_flat_to_round_curves(groupNode->children[i]);
-    }
-    else if (Ref<SceneGraph::HairSetNode> hmesh = node.dynamicCast<SceneGraph::HairSetNode>()) 
-    {
-      if (hmesh->type == RTC_GEOMETRY_TYPE_FLAT_LINEAR_CURVE)
-        ; // FIXME: not supported yet
-      else if (hmesh->type == RTC_GEOMETRY_TYPE_FLAT_BEZIER_CURVE)
-        hmesh->type = RTC_GEOMETRY_TYPE_ROUND_BEZIER_CURVE;
-      else if (hmesh->type == RTC_GEOMETRY_TYPE_FLAT_BSPLINE_CURVE)
-        hmesh->type = RTC_GEOMETRY_TYPE_ROUND_BSPLINE_CURVE;
+    return convert_geometries(node, [&] (Ref<SceneGraph::Node> node) -> Ref<SceneGraph::Node> {
+        if (Ref<SceneGraph::HairSetNode> hmesh = node.dynamicCast<SceneGraph::HairSetNode>())
+          return embree::convert_bezier_to_lines(hmesh);
+        return node;
+      });
+  }
 
-      return hmesh.dynamicCast<SceneGraph::Node>();
-    }
-    return node;
+  Ref<SceneGraph::Node> SceneGraph::convert_flat_to_round_curves(Ref<SceneGraph::Node> node)
+  {
+    return convert_geometries(node, [&] (Ref<SceneGraph::Node> node) -> Ref<SceneGraph::Node> {
+        if (Ref<SceneGraph::HairSetNode> hmesh = node.dynamicCast<SceneGraph::HairSetNode>()) 
+        {
+          if (hmesh->type == RTC_GEOMETRY_TYPE_FLAT_LINEAR_CURVE)
+            ; // FIXME: not supported yet
+          else if (hmesh->type == RTC_GEOMETRY_TYPE_FLAT_BEZIER_CURVE)
+            hmesh->type = RTC_GEOMETRY_TYPE_ROUND_BEZIER_CURVE;
+          else if (hmesh->type == RTC_GEOMETRY_TYPE_FLAT_BSPLINE_CURVE)
+            hmesh->type = RTC_GEOMETRY_TYPE_ROUND_BSPLINE_CURVE;
+        }
+        return node;
+      });
   }
 
   Ref<SceneGraph::Node> SceneGraph::convert_bezier_to_bspline(Ref<SceneGraph::Node> node)
   {
-    if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
-      convert_bezier_to_bspline(xfmNode->child);
-    }
-    else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
-    {
-      for (size_t i=0; i<groupNode->children.size(); i++) 
-        convert_bezier_to_bspline(groupNode->children[i]);
-    }
-    else if (Ref<SceneGraph::HairSetNode> hmesh = node.dynamicCast<SceneGraph::HairSetNode>()) {
-      hmesh->convert_bezier_to_bspline();
-      //hmesh->compact_vertices();
-    }
-    return node;
+    /* the conversion is done in place, thus shared curves must not get converted twice */
+    return convert_geometries(node, [&] (Ref<SceneGraph::Node> node) -> Ref<SceneGraph::Node> {
+        if (Ref<SceneGraph::HairSetNode> hmesh = node.dynamicCast<SceneGraph::HairSetNode>()) {
+          hmesh->convert_bezier_to_bspline();
+          //hmesh->compact_vertices();
+        }
+        return node;
+      });
   }
 
   Ref<SceneGraph::Node> SceneGraph::convert_bspline_to_bezier(Ref<SceneGraph::Node> node)
   {
-    if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
-      convert_bspline_to_bezier(xfmNode->child);
-    }
-    else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
-    {
-      for (size_t i=0; i<groupNode->children.size(); i++) 
-        convert_bspline_to_bezier(groupNode->children[i]);
-    }
-    else if (Ref<SceneGraph::HairSetNode> hmesh = node.dynamicCast<SceneGraph::HairSetNode>()) {
-      hmesh->convert_bspline_to_bezier();
-    }
-    return node;
+    /* the conversion is done in place, thus shared curves must not get converted twice */
+    return convert_geometries(node, [&] (Ref<SceneGraph::Node> node) -> Ref<SceneGraph::Node> {
+        if (Ref<SceneGraph::HairSetNode> hmesh = node.dynamicCast<SceneGraph::HairSetNode>())
+          hmesh->convert_bspline_to_bezier();
+        return node;
+      });
   }
 
   Ref<SceneGraph::Node> SceneGraph::remove_mblur(Ref<SceneGraph::Node> node, bool mblur)
@@ -1390,6 +1381,10 @@ namespace embree
     Ref<SceneGraph::Node> node;
     std::map<Ref<SceneGraph::Node>,Ref<SceneGraph::Node>> object_mapping;
     std::map<std::string,int> unique_id;
+    std::map<Ref<SceneGraph::Node>,size_t> num_paths;
+    std::map<Ref<SceneGraph::Node>,size_t> num_instances;
+    std::map<Ref<SceneGraph::Node>,size_t> num_primitives;
+    std::set<Ref<SceneGraph::Node>> prototypes;
     
     SceneGraphFlattener (Ref<SceneGraph::Node> in, SceneGraph::InstancingMode instancing)
     {
@@ -1399,8 +1394,9 @@ namespace embree
       std::vector<Ref<SceneGraph::Node>> geometries;      
       if (instancing != SceneGraph::INSTANCING_NONE) 
       {
-        if (instancing == SceneGraph::INSTANCING_FLATTENED) convertFlattenedInstances(geometries,in);
-        else                                                convertInstances(geometries,in,one);
+        if      (instancing == SceneGraph::INSTANCING_FLATTENED  ) convertFlattenedInstances(geometries,in);
+        else if (instancing == SceneGraph::INSTANCING_MULTI_LEVEL) convertMultiLevelInstances(geometries,in);
+        else                                                       convertInstances(geometries,in,one);
         convertLightsAndCameras(geometries,in,one);
       }
       else
@@ -1505,6 +1501,112 @@ namespace embree
         for (const auto& child : groupNode->children) convertFlattenedInstances(group,child);
       }
     }
+
+    /*! sorts the nodes of the graph below node such that each node comes after all its children */
+    void sortTopologically(std::vector<Ref<SceneGraph::Node>>& order, const Ref<SceneGraph::Node>& node)
+    {
+      if (num_paths.find(node) != num_paths.end()) return;
+      num_paths[node] = 0;
+      
+      if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
+        sortTopologically(order,xfmNode->child);
+      } 
+      else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) {
+        for (const auto& child : groupNode->children) sortTopologically(order,child);
+      }
+      order.push_back(node);
+    }
+
+    /*! decides for a node reached through multiple paths if it gets
+        flattened into a single prototype, and returns the number of
+        instances required per occurrence of the node */
+    size_t countInstances(const Ref<SceneGraph::Node>& node)
+    {
+      /* number of primitives an instance is roughly worth in memory and traversal cost */
+      static const size_t primitivesPerInstance = 8;
+
+      size_t numInstances = 0;
+      size_t numPrimitives = 0;
+      if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
+        numInstances  = num_instances [xfmNode->child];
+        numPrimitives = num_primitives[xfmNode->child];
+      } 
+      else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) 
+      {
+        for (const auto& child : groupNode->children) {
+          numInstances  += num_instances [child];
+          numPrimitives += num_primitives[child];
+        }
+      }
+      else if (!node->hasLightOrCamera) {
+        num_primitives[node] = node->numPrimitives();
+        return num_instances[node] = 1;
+      }
+      num_primitives[node] = numPrimitives;
+
+      /* flattening duplicates the shared subtrees below the node, but
+         saves all but one instance for each occurrence of the node */
+      const size_t numPaths = num_paths[node];
+      if (numPaths > 1 && numInstances > 1 && numPrimitives <= primitivesPerInstance*numPaths*(numInstances-1))
+      {
+        prototypes.insert(node);
+        numInstances = 1;
+      }
+      return num_instances[node] = numInstances;
+    }
+
+    void emitMultiLevelInstances(std::vector<Ref<SceneGraph::Node>>& group, std::vector<Ref<SceneGraph::Node>>& unshared, const Ref<SceneGraph::Node>& node, const SceneGraph::Transformations& spaces)
+    {
+      if (prototypes.find(node) != prototypes.end()) {
+        group.push_back(new SceneGraph::TransformNode(spaces,lookupGeometries(node)));
+      }
+      else if (Ref<SceneGraph::TransformNode> xfmNode = node.dynamicCast<SceneGraph::TransformNode>()) {
+        emitMultiLevelInstances(group,unshared,xfmNode->child, spaces*xfmNode->spaces);
+      } 
+      else if (Ref<SceneGraph::GroupNode> groupNode = node.dynamicCast<SceneGraph::GroupNode>()) {
+        for (const auto& child : groupNode->children) emitMultiLevelInstances(group,unshared,child,spaces);
+      }
+      else if (node->hasLightOrCamera) {
+        return;
+      }
+      else if (num_paths[node] > 1) {
+        group.push_back(new SceneGraph::TransformNode(spaces,lookupGeometries(node)));
+      }
+      else {
+        convertGeometries(unshared,node,spaces);
+      }
+    }
+
+    /*! maps an instancing graph of arbitrary depth onto the single
+        instance level of the library; shared subtrees are either
+        flattened into a prototype or resolved into instances of the
+        shared subtrees below them, depending on which is cheaper */
+    void convertMultiLevelInstances(std::vector<Ref<SceneGraph::Node>>& group, const Ref<SceneGraph::Node>& root)
+    {
+      /* count number of paths from the root to each node */
+      std::vector<Ref<SceneGraph::Node>> order;
+      sortTopologically(order,root);
+      num_paths[root] = 1;
+      for (auto i=order.rbegin(); i!=order.rend(); i++)
+      {
+        if (Ref<SceneGraph::TransformNode> xfmNode = i->dynamicCast<SceneGraph::TransformNode>()) {
+          num_paths[xfmNode->child] += num_paths[*i];
+        } 
+        else if (Ref<SceneGraph::GroupNode> groupNode = i->dynamicCast<SceneGraph::GroupNode>()) {
+          for (const auto& child : groupNode->children) num_paths[child] += num_paths[*i];
+        }
+      }
+
+      /* decide bottom up which shared subtrees get flattened */
+      for (const auto& node : order)
+        countInstances(node);
+
+      /* geometries reached through a single path get merged into one instance */
+      std::vector<Ref<SceneGraph::Node>> unshared;
+      emitMultiLevelInstances(group,unshared,root,one);
+      if (unshared.size())
+        group.push_back(new SceneGraph::TransformNode(SceneGraph::Transformations(one),new SceneGraph::GroupNode(unshared)));
+    }
   };
 
   Ref<SceneGraph::Node> SceneGraph::flatten(Ref<Node> node, InstancingMode mode) {
@@ -444,58 +444,50 @@ namespace embree
         return n;
       }
 
+      /* converts the whole group at once, such that meshes shared by multiple children get converted only once */
       void triangles_to_quads(float prop = inf)
       {
-        for (size_t i=0; i<children.size(); i++)
-          children[i] = convert_triangles_to_quads(children[i],prop);
+        convert_triangles_to_quads(this,prop);
       }
 
       void quads_to_grids(unsigned int resX, unsigned int resY)
       {
-        for (size_t i=0; i<children.size(); i++)
-          children[i] = convert_quads_to_grids(children[i],resX, resY);
+        convert_quads_to_grids(this,resX, resY);
       }
 
       void grids_to_quads()
       {
-        for (size_t i=0; i<children.size(); i++)
-          children[i] = convert_grids_to_quads(children[i]);
+        convert_grids_to_quads(this);
       }
 
       void quads_to_subdivs()
       {
-        for (size_t i=0; i<children.size(); i++)
-          children[i] = convert_quads_to_subdivs(children[i]);
+        convert_quads_to_subdivs(this);
       }
       
       void bezier_to_lines()
       {
-        for (size_t i=0; i<children.size(); i++)
-          children[i] = convert_bezier_to_lines(children[i]);
+        convert_bezier_to_lines(this);
       }
 
       void flat_to_round_curves()
       {
-        for (size_t i=0; i<children.size(); i++)
-          children[i] = convert_flat_to_round_curves(children[i]);
+        convert_flat_to_round_curves(this);
       }
 
       void bezier_to_bspline()
       {
-        for (size_t i=0; i<children.size(); i++)
-          children[i] = convert_bezier_to_bspline(children[i]);
+        convert_bezier_to_bspline(this);
       }
 
       void bspline_to_bezier()
       {
-        for (size_t i=0; i<children.size(); i++)
-          children[i] = convert_bspline_to_bezier(children[i]);
+        convert_bspline_to_bezier(this);
       }
 
       void merge_quads_to_grids()
       {
-        for (size_t i=0; i<children.size(); i++)
-          children[i] = my_merge_quads_to_grids(children[i]);
+        my_merge_quads_to_grids(this);
       }
 
       void remove_mblur(bool mblur)
@@ -1033,7 +1025,7 @@ namespace embree
     };
 
     
-    enum InstancingMode { INSTANCING_NONE, INSTANCING_GEOMETRY, INSTANCING_GROUP, INSTANCING_FLATTENED };
+    enum InstancingMode { INSTANCING_NONE, INSTANCING_GEOMETRY, INSTANCING_GROUP, INSTANCING_FLATTENED, INSTANCING_MULTI_LEVEL };
     Ref<Node> flatten(Ref<Node> node, InstancingMode mode);
     Ref<GroupNode> flatten(Ref<GroupNode> node, InstancingMode mode);
 
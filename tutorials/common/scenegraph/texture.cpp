@@ -32,10 +32,10 @@ namespace embree
   }
 
   Texture::Texture () 
-    : width(-1), height(-1), format(INVALID), bytesPerTexel(0), width_mask(0), height_mask(0), data(nullptr) {}
+    : width(-1), height(-1), format(INVALID), bytesPerTexel(0), width_mask(0), height_mask(0), data(nullptr), texture2D(nullptr) {}
   
   Texture::Texture(Ref<Image> img, const std::string fileName)
-    : width(unsigned(img->width)), height(unsigned(img->height)), format(RGBA8), bytesPerTexel(4), width_mask(0), height_mask(0), data(nullptr), fileName(fileName)
+    : width(unsigned(img->width)), height(unsigned(img->height)), format(RGBA8), bytesPerTexel(4), width_mask(0), height_mask(0), data(nullptr), fileName(fileName), texture2D(nullptr)
   {
     width_mask  = isPowerOf2(width) ? width-1 : 0;
     height_mask = isPowerOf2(height) ? height-1 : 0;
@@ -45,7 +45,7 @@ namespace embree
   }
 
   Texture::Texture (unsigned width, unsigned height, const Format format, const char* in)
-    : width(width), height(height), format(format), bytesPerTexel(getFormatBytesPerTexel(format)), width_mask(0), height_mask(0), data(nullptr)
+    : width(width), height(height), format(format), bytesPerTexel(getFormatBytesPerTexel(format)), width_mask(0), height_mask(0), data(nullptr), texture2D(nullptr)
   {
     width_mask  = isPowerOf2(width) ? width-1 : 0;
     height_mask = isPowerOf2(height) ? height-1 : 0;
@@ -60,8 +60,60 @@ namespace embree
     }   
   }
 
+  Texture::Texture (unsigned width, unsigned height, const Format format, std::shared_ptr<MappedFile> file, size_t ofs)
+    : width(width), height(height), format(format), bytesPerTexel(getFormatBytesPerTexel(format)), width_mask(0), height_mask(0), data(nullptr), mappedFile(file), texture2D(nullptr)
+  {
+    width_mask  = isPowerOf2(width) ? width-1 : 0;
+    height_mask = isPowerOf2(height) ? height-1 : 0;
+
+    /* texels are read-only, thus we can point directly into the mapping */
+    data = (void*) (mappedFile->data()+ofs);
+  }
+
+  Texture::Texture (Ref<ImageReader> reader, const std::string fileName)
+    : width(unsigned(reader->width)), height(unsigned(reader->height)), format(RGBA8), bytesPerTexel(4), width_mask(0), height_mask(0), data(nullptr), fileName(fileName), texture2D(nullptr), reader(reader)
+  {
+    width_mask  = isPowerOf2(width) ? width-1 : 0;
+    height_mask = isPowerOf2(height) ? height-1 : 0;
+
+    Vec2i size((int)width,(int)height);
+    texture2D = (Texture2D*) Texture2D_createCached(size,TEXTURE_RGBA8,0,&Texture::loadTexels,this);
+  }
+
+  void Texture::loadTexels(void* loader, const Vec2i& begin, const Vec2i& size, void* texels)
+  {
+    Texture* self = (Texture*) loader;
+    try {
+      self->reader->readRGBA8(begin.x,begin.y,size.x,size.y,(unsigned char*)texels);
+    } catch (const std::exception& e) {
+      std::cerr << "cannot read texels of " << self->fileName << ": " << e.what() << std::endl;
+      memset(texels,0,size_t(size.x)*size_t(size.y)*self->bytesPerTexel);
+    }
+  }
+
   Texture::~Texture () {
-    alignedFree(data);
+    Texture2D_destroy(texture2D);
+    if (!mappedFile) alignedFree(data);
+  }
+
+  /*! creates the mip-map levels used for filtered lookups, the original
+      texels get released afterwards as unfiltered lookups then also read
+      the finest level */
+  void Texture::createTexture2D()
+  {
+    if (texture2D || !data || width == 0 || height == 0) return;
+    
+    Vec2i size((int)width,(int)height);
+    switch (format) {
+    case RGBA8  : texture2D = (Texture2D*) Texture2D_create(size,data,TEXTURE_RGBA8,0); break;
+    case RGB8   : texture2D = (Texture2D*) Texture2D_create(size,data,TEXTURE_RGB8,0); break;
+    case FLOAT32: texture2D = (Texture2D*) Texture2D_create(size,data,TEXTURE_R32F,0); break;
+    default     : return;
+    }
+
+    if (!mappedFile) alignedFree(data);
+    data = nullptr;
+    mappedFile.reset();
   }
 
   const char* Texture::format_to_string(const Format format)
@@ -92,13 +144,18 @@ namespace embree
     }
   }
 
-  /*! read png texture from disk */
+  /*! read png texture from disk, only its size gets read if the texture cache is enabled and the format supports random access */
   std::shared_ptr<Texture> Texture::load(const FileName& fileName)
   {
     if (texture_cache.find(fileName.str()) != texture_cache.end())
       return texture_cache[fileName.str()];
     
-    std::shared_ptr<Texture> tex(new Texture(loadImage(fileName),fileName));
+    Ref<ImageReader> reader;
+    if (TextureCache_getBudget()) reader = openImage(fileName);
+
+    std::shared_ptr<Texture> tex;
+    if (reader) tex.reset(new Texture(reader,fileName));
+    else        tex.reset(new Texture(loadImage(fileName),fileName));
     return texture_cache[fileName.str()] = tex;
   }
 }
@@ -38,6 +38,9 @@ struct Texture {
 
 #include "../default.h"
 #include "../image/image.h"
+#include "../texture/texture2d.h"
+#include "../texture/texture_cache.h"
+#include "../../../common/sys/mapped_file.h"
 
 namespace embree
 {
@@ -54,6 +57,8 @@ namespace embree
     Texture (); 
     Texture (Ref<Image> image, const std::string fileName); 
     Texture (unsigned width, unsigned height, const Format format, const char* in = nullptr);
+    Texture (unsigned width, unsigned height, const Format format, std::shared_ptr<MappedFile> file, size_t ofs);
+    Texture (Ref<ImageReader> reader, const std::string fileName); //!< texels get loaded on demand into the texture cache
     ~Texture ();
 
   private:
@@ -67,6 +72,11 @@ namespace embree
 
     static std::shared_ptr<Texture> load(const FileName& fileName);
     static void clearTextureCache();
+
+    void createTexture2D(); //!< only called by renderers that do filtered lookups
+
+  private:
+    static void loadTexels(void* loader, const Vec2i& begin, const Vec2i& size, void* texels);
     
   public:
     unsigned width;
@@ -75,8 +85,11 @@ namespace embree
     unsigned bytesPerTexel;
     unsigned width_mask;
     unsigned height_mask;
-    void* data;
+    void* data;                             //!< nullptr if the texels get loaded on demand or only live in texture2D
     std::string fileName;
+    std::shared_ptr<MappedFile> mappedFile; //!< keeps texels alive that are used directly from a mapped file
+    Texture2D* texture2D;                   //!< tiled and mip-mapped copy of the texels for filtered lookups
+    Ref<ImageReader> reader;                //!< reads the texels of textures that get loaded on demand
   };
 }
 #endif
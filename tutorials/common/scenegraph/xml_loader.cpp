@@ -17,6 +17,7 @@
 #include "xml_loader.h"
 #include "xml_parser.h"
 #include "obj_loader.h"
+#include "../../../common/sys/mapped_file.h"
 
 namespace embree
 {
@@ -271,6 +272,7 @@ namespace embree
   private:
     template<typename T> T load(const Ref<XML>& xml) { assert(false); return T(zero); }
     template<typename T> T load(const Ref<XML>& xml, const T& opt) { assert(false); return T(zero); }
+    const char* mapBinary(const Ref<XML>& xml, size_t bytesPerItem, size_t& size);
     template<typename Vector> Vector loadBinary(const Ref<XML>& xml);
 
     std::vector<float> loadFloatArray(const Ref<XML>& xml);
@@ -287,9 +289,8 @@ namespace embree
 
   private:
     FileName path;         //!< path to XML file
-    FILE* binFile;         //!< .bin file for reading binary data
+    std::shared_ptr<MappedFile> binFile; //!< .bin file for reading binary data, mapped into memory
     FileName binFileName;  //!< name of the .bin file
-    size_t binFileSize;
 
   private:
     SharedState& state;
@@ -410,28 +411,35 @@ namespace embree
     }
   }
 
-  template<typename Vector>
-  Vector XMLLoader::loadBinary(const Ref<XML>& xml)
+  const char* XMLLoader::mapBinary(const Ref<XML>& xml, size_t bytesPerItem, size_t& size)
   {
     if (!binFile) 
       THROW_RUNTIME_ERROR("cannot open file "+binFileName.str()+" for reading");
 
     size_t ofs = atol(xml->parm("ofs").c_str());
-    fseek(binFile,long(ofs),SEEK_SET);
 
     /* read size of array */
-    size_t size = atol(xml->parm("size").c_str());
+    size = atol(xml->parm("size").c_str());
     if (size == 0) size = atol(xml->parm("num").c_str()); // version for BGF format
 
     /* perform security check that we stay in the file */
-    if (ofs + size*sizeof(typename Vector::value_type) > binFileSize)
+    if (ofs > binFile->size() || size > (binFile->size()-ofs)/bytesPerItem)
       THROW_RUNTIME_ERROR("error reading from binary file: "+binFileName.str());
 
-    /* read data from file */
-    Vector data(size);
-    if (size != fread(data.data(), sizeof(typename Vector::value_type), data.size(), binFile)) 
-      THROW_RUNTIME_ERROR("error reading from binary file: "+binFileName.str());
+    return binFile->data()+ofs;
+  }
 
+  template<typename Vector>
+  Vector XMLLoader::loadBinary(const Ref<XML>& xml)
+  {
+    /* copy data directly from the page cache; the arrays cannot stay in
+     * the read-only mapping, as the scene graph owns and modifies its
+     * arrays, and positions are stored as float3 but used as Vec3fa;
+     * thus only embedded textures are shared with the mapping */
+    size_t size = 0;
+    const char* ptr = mapBinary(xml,sizeof(typename Vector::value_type),size);
+    Vector data(size);
+    if (size) memcpy((void*)data.data(),ptr,size*sizeof(typename Vector::value_type));
     return data;
   }
 
@@ -493,9 +501,13 @@ namespace embree
     if (!xml) return avector<Vec3fa>();
 
     if (xml->parm("ofs") != "") {
-      std::vector<Vec3f> temp = loadBinary<std::vector<Vec3f>>(xml);
-      avector<Vec3fa> data; data.resize(temp.size());
-      for (size_t i=0; i<temp.size(); i++) data[i] = Vec3fa(temp[i]);
+      size_t size = 0;
+      const char* ptr = mapBinary(xml,sizeof(Vec3f),size);
+      avector<Vec3fa> data; data.resize(size);
+      for (size_t i=0; i<size; i++) {
+        Vec3f v; memcpy(&v,ptr+i*sizeof(Vec3f),sizeof(Vec3f));
+        data[i] = Vec3fa(v);
+      }
       return data;
     } 
     else 
@@ -534,9 +546,13 @@ namespace embree
     if (xml->parm("ofs") == "") 
       THROW_RUNTIME_ERROR(xml->loc.str()+": invalid AffineSpace3fa array");
 
-    std::vector<AffineSpace3f> temp = loadBinary<std::vector<AffineSpace3f>>(xml);
-    avector<AffineSpace3fa> data; data.resize(temp.size());
-    for (size_t i=0; i<temp.size(); i++) data[i] = AffineSpace3fa(temp[i]);
+    size_t size = 0;
+    const char* ptr = mapBinary(xml,sizeof(AffineSpace3f),size);
+    avector<AffineSpace3fa> data; data.resize(size);
+    for (size_t i=0; i<size; i++) {
+      AffineSpace3f space; memcpy(&space,ptr+i*sizeof(AffineSpace3f),sizeof(AffineSpace3f));
+      data[i] = AffineSpace3fa(space);
+    }
     return data;
   }
 
@@ -719,12 +735,17 @@ namespace embree
       const unsigned height = stoi(xml->parm("height"));
       const Texture::Format format = Texture::string_to_format(xml->parm("format"));
       const unsigned bytesPerTexel = Texture::getFormatBytesPerTexel(format);
-      if (ftell(binFile) + width*height*bytesPerTexel > (unsigned)binFileSize)
-        THROW_RUNTIME_ERROR("error reading from binary file: "+binFileName.str());
-      
-      texture = std::make_shared<Texture>(width,height,format);
-      if (width*height != fread(texture->data, bytesPerTexel, width*height, binFile)) 
+      if (!binFile) 
+        THROW_RUNTIME_ERROR("cannot open file "+binFileName.str()+" for reading");
+      const size_t ofs = atol(xml->parm("ofs").c_str());
+      if (ofs > binFile->size() || size_t(width)*size_t(height) > (binFile->size()-ofs)/bytesPerTexel)
         THROW_RUNTIME_ERROR("error reading from binary file: "+binFileName.str());
+
+      /* aligned texels are used directly from the mapped file */
+      if (ofs % 16 == 0)
+        texture = std::make_shared<Texture>(width,height,format,binFile,ofs);
+      else
+        texture = std::make_shared<Texture>(width,height,format,binFile->data()+ofs);
     }
     
     if (id != "") state.textureMap[id] = texture;
@@ -1412,20 +1433,23 @@ namespace embree
     return loader.root;
   }
 
+  static bool fileExists(const FileName& fileName)
+  {
+    FILE* file = fopen(fileName.c_str(),"rb");
+    if (file) fclose(file);
+    return file != nullptr;
+  }
+
   XMLLoader::XMLLoader(const FileName& fileName, const AffineSpace3fa& space, SharedState& state)
-    : binFile(nullptr), binFileSize(0), state(state), currentNodeID(0)
+    : state(state), currentNodeID(0)
   {
     path = fileName.path();
     binFileName = fileName.setExt(".bin");
-    binFile = fopen(binFileName.c_str(),"rb");
-    if (!binFile) {
+    if (!fileExists(binFileName))
       binFileName = fileName.addExt(".bin");
-      binFile = fopen(binFileName.c_str(),"rb");
-    }
-    if (binFile) {
-      fseek(binFile, 0L, SEEK_END);
-      binFileSize = ftell(binFile);
-      fseek(binFile, 0L, SEEK_SET);
+    if (fileExists(binFileName)) {
+      binFile = std::make_shared<MappedFile>(binFileName);
+      binFile->adviseSequential();
     }
 
     Ref<XML> xml = parseXML(fileName);
@@ -1454,7 +1478,6 @@ namespace embree
   }
 
   XMLLoader::~XMLLoader() {
-    if (binFile) fclose(binFile);
   }
 
   /*! read from disk */
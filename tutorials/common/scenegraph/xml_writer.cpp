@@ -29,6 +29,7 @@ namespace embree
     void open(std::string str);
     void open(std::string str, size_t id);
     void close(std::string str);
+    void pad();
     
     void store(const char* name, const char* str);
     void store(const char* name, const float& v);
@@ -114,6 +115,14 @@ namespace embree
     tab(); xml << "</" << str << ">" << std::endl;
   }
 
+  void XMLWriter::pad()
+  {
+    /* pad all arrays to 16 bytes, such that the loader can use them directly from the mapped .bin file */
+    const char zeros[16] = { 0 };
+    const size_t ofs = size_t(bin.tellg());
+    if (ofs % 16) bin.write(zeros,16-ofs%16);
+  }
+
   void XMLWriter::store(const char* name, const char* str) {
     tab(); xml << "<" << name << ">\"" << str << "\"</" << name << ">" << std::endl;
   }
@@ -132,6 +141,7 @@ namespace embree
     std::streampos offset = bin.tellg();
     tab(); xml << "<" << name << " ofs=\"" << offset << "\" size=\"" << vec.size() << "\"/>" << std::endl;
     if (vec.size()) bin.write((char*)vec.data(),vec.size()*sizeof(T));
+    pad();
   }
 
   void XMLWriter::store(const char* name, const avector<Vec3fa>& vec)
@@ -139,6 +149,7 @@ namespace embree
     std::streampos offset = bin.tellg();
     tab(); xml << "<" << name << " ofs=\"" << offset << "\" size=\"" << vec.size() << "\"/>" << std::endl;
     for (size_t i=0; i<vec.size(); i++) bin.write((char*)&vec[i],sizeof(Vec3f));
+    pad();
   }
 
   void XMLWriter::store4f(const char* name, const avector<Vec3fa>& vec)
@@ -146,6 +157,7 @@ namespace embree
     std::streampos offset = bin.tellg();
     tab(); xml << "<" << name << " ofs=\"" << offset << "\" size=\"" << vec.size() << "\"/>" << std::endl;
     for (size_t i=0; i<vec.size(); i++) bin.write((char*)&vec[i],sizeof(Vec3fa));
+    pad();
   }
 
   void XMLWriter::store_parm(const char* name, const float& v) {
@@ -162,9 +174,10 @@ namespace embree
 
     if (textureMap.find(tex) != textureMap.end()) {
       tab(); xml << "<texture3d name=\"" << name << "\" id=\"" << textureMap[tex] << "\"/>" << std::endl;
-    } else if (embedTextures) {
+    } else if (embedTextures && tex->data) {
       std::streampos offset = bin.tellg();
       bin.write((char*)tex->data,tex->width*tex->height*tex->bytesPerTexel);
+      pad();
       const size_t id = textureMap[tex] = currentNodeID++;
       tab(); xml << "<texture3d name=\"" << name << "\" id=\"" << id << "\" ofs=\"" << offset 
                  << "\" width=\"" << tex->width << "\" height=\"" << tex->height 
@@ -588,6 +601,7 @@ namespace embree
       bin.write((char*)&nodes[i]->spaces[0].l.vz,sizeof(Vec3f));
       bin.write((char*)&nodes[i]->spaces[0].p,sizeof(Vec3f));
     }
+    pad();
     store(nodes[0]->child);
     close("MultiTransform");
   }
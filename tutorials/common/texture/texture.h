@@ -39,6 +39,7 @@ typedef enum {
 /*! flags that can be passed to ospNewTexture2D(); can be OR'ed together */
 typedef enum {
   TEXTURE_SHARED_BUFFER = (1<<0),
-  TEXTURE_FILTER_NEAREST = (1<<1) /*!< use nearest-neighbor interpolation rather than the default bilinear interpolation */
+  TEXTURE_FILTER_NEAREST = (1<<1), /*!< use nearest-neighbor interpolation rather than the default bilinear interpolation */
+  TEXTURE_NO_MIPMAPS = (1<<2) /*!< store only the finest level, filtered lookups fall back to the get function */
 } TextureCreationFlags;
 
@@ -15,6 +15,11 @@
 // ======================================================================== //
 
 #include "texture2d.h"
+#include "texture_cache.h"
+#include "../../../common/algorithms/parallel_for.h"
+
+#include <atomic>
+#include <vector>
 
 namespace embree {
 
@@ -22,12 +27,33 @@ namespace embree {
 // Low-level texel accessors
 //////////////////////////////////////////////////////////////////////////////
 
-// TODO blocking
+// returns the index of a texel in a tiled layout with tilesX tiles per row
+inline uint32_t tiledIndex(const int tilesX, const Vec2i i)
+{
+  const uint32_t tile = (i.y/TEXTURE2D_TILE_SIZE)*tilesX + i.x/TEXTURE2D_TILE_SIZE;
+  return tile*TEXTURE2D_TILE_SIZE*TEXTURE2D_TILE_SIZE + (i.y%TEXTURE2D_TILE_SIZE)*TEXTURE2D_TILE_SIZE + i.x%TEXTURE2D_TILE_SIZE;
+}
+
+// returns the index of a texel in the tiled layout of a level
+inline uint32_t texelIndex(const Texture2DLevel *level, const Vec2i i) {
+  return tiledIndex(level->tilesX, i);
+}
+
+// returns a pointer to a texel, the texels of cached textures are read from their page
+inline const char *texelPtr(const Texture2DLevel *level, const Vec2i i, const size_t bytes)
+{
+  if (likely(level->data != nullptr))
+    return (const char *)level->data + texelIndex(level, i)*bytes;
+
+  const Vec2i page(i.x/TEXTURE_CACHE_PAGE_SIZE, i.y/TEXTURE_CACHE_PAGE_SIZE);
+  const Vec2i j(i.x%TEXTURE_CACHE_PAGE_SIZE, i.y%TEXTURE_CACHE_PAGE_SIZE);
+  return TextureCache_getPage(level->texture, level->index, page) + tiledIndex(level->pageTilesX, j)*bytes;
+}
 
-inline Vec4f getTexel_RGBA8(const Texture2D *self, const Vec2i i)
+inline Vec4f getTexel_RGBA8(const Texture2DLevel *level, const Vec2i i)
 {
-  assert(self);
-  const uint32_t c = ((const uint32_t *)self->data)[i.y*self->size.x + i.x];
+  assert(level);
+  const uint32_t c = *(const uint32_t *)texelPtr(level, i, 4);
   const uint32_t r = c         & 0xff;
   const uint32_t g = (c >>  8) & 0xff;
   const uint32_t b = (c >> 16) & 0xff;
@@ -35,66 +61,117 @@ inline Vec4f getTexel_RGBA8(const Texture2D *self, const Vec2i i)
   return Vec4f((float)r, (float)g, (float)b, (float)a)*(1.f/255.f);
 }
 
-inline Vec4f getTexel_RGB8(const Texture2D *self, const Vec2i i)
+inline Vec4f getTexel_RGB8(const Texture2DLevel *level, const Vec2i i)
 {
-  assert(self);
-  const uint8_t *texel = (const uint8_t *)self->data;
-  const uint32_t texelOfs = 3*(i.y*self->size.x + i.x);
-  const uint32_t r = texel[texelOfs];
-  const uint32_t g = texel[texelOfs+1];
-  const uint32_t b = texel[texelOfs+2];
+  assert(level);
+  const uint8_t *texel = (const uint8_t *)texelPtr(level, i, 3);
+  const uint32_t r = texel[0];
+  const uint32_t g = texel[1];
+  const uint32_t b = texel[2];
   return Vec4f(Vec3fa((float)r, (float)g, (float)b)*(1.f/255.f), 1.f);
 }
 
-inline Vec4f getTexel_R8(const Texture2D *self, const Vec2i i)
+inline Vec4f getTexel_R8(const Texture2DLevel *level, const Vec2i i)
 {
-  assert(self);
-  const uint8_t c = ((const uint8_t *)self->data)[i.y*self->size.x + i.x];
+  assert(level);
+  const uint8_t c = *(const uint8_t *)texelPtr(level, i, 1);
   return Vec4f(c*(1.f/255.f), 0.0f, 0.0f, 1.f);
 }
 
-inline Vec4f getTexel_SRGBA(const Texture2D *self, const Vec2i i)
+inline Vec4f getTexel_SRGBA(const Texture2DLevel *level, const Vec2i i)
 {
-  return srgba_to_linear(getTexel_RGBA8(self, i));
+  return srgba_to_linear(getTexel_RGBA8(level, i));
 }
 
-inline Vec4f getTexel_SRGB(const Texture2D *self, const Vec2i i)
+inline Vec4f getTexel_SRGB(const Texture2DLevel *level, const Vec2i i)
 {
-  return srgba_to_linear(getTexel_RGB8(self, i));
+  return srgba_to_linear(getTexel_RGB8(level, i));
 }
 
-inline Vec4f getTexel_RGBA32F(const Texture2D *self, const Vec2i i)
+inline Vec4f getTexel_RGBA32F(const Texture2DLevel *level, const Vec2i i)
 {
-  assert(self);
-  return ((const Vec4f *)self->data)[i.y*self->size.x + i.x];
+  assert(level);
+  return *(const Vec4f *)texelPtr(level, i, sizeof(Vec4f));
 }
 
-inline Vec4f getTexel_RGB32F(const Texture2D *self, const Vec2i i)
+inline Vec4f getTexel_RGB32F(const Texture2DLevel *level, const Vec2i i)
 {
-  assert(self);
-  Vec3fa v = ((const Vec3fa*)self->data)[i.y*self->size.x + i.x];
+  assert(level);
+  Vec3fa v = *(const Vec3fa *)texelPtr(level, i, sizeof(Vec3fa));
   return Vec4f(v, 1.f);
 }
 
-inline Vec4f getTexel_R32F(const Texture2D *self, const Vec2i i)
+inline Vec4f getTexel_R32F(const Texture2DLevel *level, const Vec2i i)
 {
-  assert(self);
-  float v = ((const float*)self->data)[i.y*self->size.x + i.x];
+  assert(level);
+  float v = *(const float *)texelPtr(level, i, sizeof(float));
   return Vec4f(v, 0.f, 0.f, 1.f);
 }
 
 
+// Low-level texel writers, used to store the input and the mip-map levels
+//////////////////////////////////////////////////////////////////////////////
+
+inline uint32_t to_unorm8(const float f)
+{
+  return (uint32_t)(255.f*clamp(f, 0.f, 1.f) + 0.5f);
+}
+
+inline void setTexel_RGBA8(const Texture2DLevel *level, const Vec2i i, const Vec4f c)
+{
+  ((uint32_t *)level->data)[texelIndex(level, i)] = to_unorm8(c.x) | (to_unorm8(c.y) << 8) | (to_unorm8(c.z) << 16) | (to_unorm8(c.w) << 24);
+}
+
+inline void setTexel_RGB8(const Texture2DLevel *level, const Vec2i i, const Vec4f c)
+{
+  uint8_t *texel = (uint8_t *)level->data + 3*texelIndex(level, i);
+  texel[0] = to_unorm8(c.x);
+  texel[1] = to_unorm8(c.y);
+  texel[2] = to_unorm8(c.z);
+}
+
+inline void setTexel_R8(const Texture2DLevel *level, const Vec2i i, const Vec4f c)
+{
+  ((uint8_t *)level->data)[texelIndex(level, i)] = to_unorm8(c.x);
+}
+
+inline void setTexel_SRGBA(const Texture2DLevel *level, const Vec2i i, const Vec4f c)
+{
+  setTexel_RGBA8(level, i, linear_to_srgba(c));
+}
+
+inline void setTexel_SRGB(const Texture2DLevel *level, const Vec2i i, const Vec4f c)
+{
+  setTexel_RGB8(level, i, linear_to_srgba(c));
+}
+
+inline void setTexel_RGBA32F(const Texture2DLevel *level, const Vec2i i, const Vec4f c)
+{
+  ((Vec4f *)level->data)[texelIndex(level, i)] = c;
+}
+
+inline void setTexel_RGB32F(const Texture2DLevel *level, const Vec2i i, const Vec4f c)
+{
+  ((Vec3fa *)level->data)[texelIndex(level, i)] = Vec3fa(c.x, c.y, c.z);
+}
+
+inline void setTexel_R32F(const Texture2DLevel *level, const Vec2i i, const Vec4f c)
+{
+  ((float *)level->data)[texelIndex(level, i)] = c.x;
+}
+
+
 // Texture coordinate utilities
 //////////////////////////////////////////////////////////////////////////////
 
-inline Vec2i nearest_coords(const Texture2D *self, const Vec2f p)
+inline Vec2i nearest_coords(const Texture2DLevel *level, const Vec2f p)
 {
   // repeat: get remainder within [0..1] parameter space
   Vec2f tc = frac(p);
   tc = max(tc, Vec2f(0.0f)); // filter out inf/NaN
 
   // scale by texture size
-  tc = tc * self->sizef;
+  tc = tc * level->sizef;
 
   // nearest
   return Vec2i(tc);
@@ -106,25 +183,25 @@ struct BilinCoords {
   Vec2f frac;
 };
 
-inline BilinCoords bilinear_coords(const Texture2D *self, const Vec2f p)
+inline BilinCoords bilinear_coords(const Texture2DLevel *level, const Vec2f p)
 {
   BilinCoords coords;
 
   // repeat: get remainder within [0..1] parameter space
   // lower sample shifted by half a texel
-  Vec2f tc = frac(p - self->halfTexel);
+  Vec2f tc = frac(p - level->halfTexel);
   tc = max(tc, Vec2f(0.0f)); // filter out inf/NaN
 
   // scale by texture size
-  tc = tc * self->sizef;
+  tc = tc * level->sizef;
   coords.frac = frac(tc);
 
   coords.st0 = Vec2i(tc);
   coords.st1 = coords.st0 + 1;
   // handle border cases
-  if (coords.st1.x >= self->size.x)
+  if (coords.st1.x >= level->size.x)
     coords.st1.x = 0;
-  if (coords.st1.y >= self->size.y)
+  if (coords.st1.y >= level->size.y)
     coords.st1.y = 0;
 
   return coords;
@@ -143,29 +220,75 @@ inline Vec4f bilerp(const Vec2f frac, const Vec4f c00, const Vec4f c01, const Ve
 
 #define __define_tex_get(FMT)                                                \
                                                                              \
+static Vec4f Texture2D_nearest_level_##FMT(const Texture2D *self,            \
+    const Vec2f &p, const int level)                                         \
+{                                                                            \
+  const Texture2DLevel *l = &self->levels[level];                            \
+  return getTexel_##FMT(l, nearest_coords(l, p));                            \
+}                                                                            \
+                                                                             \
+static Vec4f Texture2D_bilinear_level_##FMT(const Texture2D *self,           \
+    const Vec2f &p, const int level)                                         \
+{                                                                            \
+  const Texture2DLevel *l = &self->levels[level];                            \
+  BilinCoords cs = bilinear_coords(l, p);                                    \
+                                                                             \
+  const Vec4f c00 = getTexel_##FMT(l, Vec2i(cs.st0.x, cs.st0.y));            \
+  const Vec4f c01 = getTexel_##FMT(l, Vec2i(cs.st1.x, cs.st0.y));            \
+  const Vec4f c10 = getTexel_##FMT(l, Vec2i(cs.st0.x, cs.st1.y));            \
+  const Vec4f c11 = getTexel_##FMT(l, Vec2i(cs.st1.x, cs.st1.y));            \
+                                                                             \
+  return bilerp(cs.frac, c00, c01, c10, c11);                                \
+}                                                                            \
+                                                                             \
 static Vec4f Texture2D_nearest_##FMT(const Texture2D *self,  \
     const Vec2f &p)                                                          \
 {                                                                            \
-  return getTexel_##FMT(self, nearest_coords(self, p));                      \
+  return Texture2D_nearest_level_##FMT(self, p, 0);                          \
 }                                                                            \
                                                                              \
 static Vec4f Texture2D_bilinear_##FMT(const Texture2D *self, \
     const Vec2f &p)                                                          \
 {                                                                            \
-  BilinCoords cs = bilinear_coords(self, p);                                 \
-                                                                             \
-  const Vec4f c00 = getTexel_##FMT(self, Vec2i(cs.st0.x, cs.st0.y));    \
-  const Vec4f c01 = getTexel_##FMT(self, Vec2i(cs.st1.x, cs.st0.y));    \
-  const Vec4f c10 = getTexel_##FMT(self, Vec2i(cs.st0.x, cs.st1.y));    \
-  const Vec4f c11 = getTexel_##FMT(self, Vec2i(cs.st1.x, cs.st1.y));    \
+  return Texture2D_bilinear_level_##FMT(self, p, 0);                         \
+}                                                                            \
                                                                              \
-  return bilerp(cs.frac, c00, c01, c10, c11);                                \
+/* averages 2x2 texels of the finer level, texels outside get clamped */    \
+static void Texture2D_downsample_##FMT(const Texture2DLevel *dst,            \
+    const Texture2DLevel *src)                                               \
+{                                                                            \
+  parallel_for(0, dst->size.y, 16, [&](const range<int> &r) {                \
+    for (int y = r.begin(); y < r.end(); y++)                                \
+      for (int x = 0; x < dst->size.x; x++) {                                \
+        const int x0 = min(2*x, src->size.x-1), x1 = min(2*x+1, src->size.x-1);\
+        const int y0 = min(2*y, src->size.y-1), y1 = min(2*y+1, src->size.y-1);\
+        const Vec4f c = getTexel_##FMT(src, Vec2i(x0, y0))                   \
+                      + getTexel_##FMT(src, Vec2i(x1, y0))                   \
+                      + getTexel_##FMT(src, Vec2i(x0, y1))                   \
+                      + getTexel_##FMT(src, Vec2i(x1, y1));                  \
+        setTexel_##FMT(dst, Vec2i(x, y), 0.25f*c);                           \
+      }                                                                      \
+  });                                                                        \
 }
 
 #define __define_tex_get_case(FMT) \
   case TEXTURE_##FMT: return filter_nearest ?  &Texture2D_nearest_##FMT : \
                                                    &Texture2D_bilinear_##FMT;
 
+#define __define_tex_get_level_case(FMT) \
+  case TEXTURE_##FMT: return filter_nearest ?  &Texture2D_nearest_level_##FMT : \
+                                                   &Texture2D_bilinear_level_##FMT;
+
+#define __define_tex_downsample_case(FMT) \
+  case TEXTURE_##FMT: Texture2D_downsample_##FMT(dst, src); break;
+
+/* a single texel is a level with one tile */
+#define __define_tex_decode_case(FMT) \
+  case TEXTURE_##FMT: { Texture2DLevel texel; texel.tilesX = 1; texel.data = (void*)ptr; return getTexel_##FMT(&texel, Vec2i(0)); }
+
+#define __define_tex_encode_case(FMT) \
+  case TEXTURE_##FMT: setTexel_##FMT(dst, i, c); break;
+
 #define __foreach_fetcher(FCT) \
   FCT(RGBA8)                   \
   FCT(SRGBA)                   \
@@ -187,30 +310,274 @@ static Texture2D_get Texture2D_get_addr(const uint32_t type,
   return 0;
 };
 
+static Texture2D_getLevel Texture2D_getLevel_addr(const uint32_t type,
+    const bool filter_nearest)
+{
+  switch (type) {
+    __foreach_fetcher(__define_tex_get_level_case)
+  }
+  return 0;
+};
+
+static void Texture2D_downsample(const uint32_t type,
+    const Texture2DLevel *dst, const Texture2DLevel *src)
+{
+  switch (type) {
+    __foreach_fetcher(__define_tex_downsample_case)
+  }
+};
+
 #undef __define_tex_get
-#undef __define_tex_get_addr
-#undef __foreach_fetcher
+#undef __define_tex_get_case
+#undef __define_tex_get_level_case
+static Vec4f Texture2D_decode(const uint32_t type, const char *ptr)
+{
+  switch (type) {
+    __foreach_fetcher(__define_tex_decode_case)
+  }
+  return Vec4f(0.0f);
+};
 
+static void Texture2D_encode(const uint32_t type,
+    const Texture2DLevel *dst, const Vec2i i, const Vec4f c)
+{
+  switch (type) {
+    __foreach_fetcher(__define_tex_encode_case)
+  }
+};
 
-// Exports (called from C++)
-//////////////////////////////////////////////////////////////////////////////
+#undef __define_tex_downsample_case
+#undef __define_tex_decode_case
+#undef __define_tex_encode_case
+#undef __foreach_fetcher
 
-extern "C" void *Texture2D_create(Vec2i &size, void *data,
-    uint32_t type, uint32_t flags)
+static size_t bytesPerTexel(const uint32_t type)
 {
-  Texture2D *self = (Texture2D*) alignedMalloc(sizeof(Texture2D),16);
-  self->size      = size;
+  switch (type) {
+  case TEXTURE_RGBA8  : return 4;
+  case TEXTURE_SRGBA  : return 4;
+  case TEXTURE_RGBA32F: return sizeof(Vec4f);
+  case TEXTURE_RGB8   : return 3;
+  case TEXTURE_SRGB   : return 3;
+  case TEXTURE_RGB32F : return sizeof(Vec3fa);
+  case TEXTURE_R8     : return 1;
+  case TEXTURE_R32F   : return 4;
+  }
+  return 0;
+}
 
+static void initLevel(Texture2DLevel *level, const Vec2i size, const Texture2D *texture, const int index, const uint32_t type)
+{
+  level->size = size;
   // Due to float rounding frac(x) can be exactly 1.0f (e.g. for very small
   // negative x), although it should be strictly smaller than 1.0f. We handle
   // this case by having sizef slightly smaller than size, such that
   // frac(x)*sizef is always < size.
+  level->sizef = Vec2f(nextafter((float)size.x, -1.0f), nextafter((float)size.y, -1.0f));
+  level->halfTexel = Vec2f(0.5f/size.x, 0.5f/size.y);
+  level->tilesX = (size.x+TEXTURE2D_TILE_SIZE-1)/TEXTURE2D_TILE_SIZE;
+  level->data = nullptr;
+  level->texture = texture;
+  level->index = index;
+
+  // pages of small levels only cover the level
+  const int tilesY = (size.y+TEXTURE2D_TILE_SIZE-1)/TEXTURE2D_TILE_SIZE;
+  const int pageTilesY = min(tilesY, TEXTURE_CACHE_PAGE_SIZE/TEXTURE2D_TILE_SIZE);
+  level->pageTilesX = min(level->tilesX, TEXTURE_CACHE_PAGE_SIZE/TEXTURE2D_TILE_SIZE);
+  level->pageBytes = level->pageTilesX*pageTilesY*TEXTURE2D_TILE_SIZE*TEXTURE2D_TILE_SIZE*bytesPerTexel(type);
+}
+
+static size_t levelBytes(const Texture2DLevel *level, const uint32_t type)
+{
+  const size_t tilesY = (level->size.y+TEXTURE2D_TILE_SIZE-1)/TEXTURE2D_TILE_SIZE;
+  const size_t bytes = level->tilesX*tilesY*TEXTURE2D_TILE_SIZE*TEXTURE2D_TILE_SIZE*bytesPerTexel(type);
+  return (bytes+63) & ~size_t(63); // keep levels cache line aligned
+}
+
+
+// Filtered lookups
+//////////////////////////////////////////////////////////////////////////////
+
+inline Vec4f Texture2D_trilinear(const Texture2D *self, const Vec2f &p, const float lod)
+{
+  const float l = clamp(lod, 0.0f, float(self->numLevels-1));
+  const int l0 = (int)l;
+  const float f = l - l0;
+  const Vec4f c0 = self->getLevel(self, p, l0);
+  if (f == 0.0f) return c0;
+  const Vec4f c1 = self->getLevel(self, p, l0+1);
+  return lerpr(f, c0, c1);
+}
+
+Vec4f Texture2D_getFiltered(const Texture2D *self,
+                            const Vec2f &p,
+                            const Vec2f &dpdx,
+                            const Vec2f &dpdy)
+{
+  // footprint in texels of the finest level
+  const Vec2f sizef = Vec2f((float)self->size.x, (float)self->size.y);
+  const Vec2f dx = dpdx*sizef;
+  const Vec2f dy = dpdy*sizef;
+  const float lx = length(dx);
+  const float ly = length(dy);
+  const float major = max(lx, ly);
+  const float minor = min(lx, ly);
+  if (!(major > 1.0f) || self->numLevels == 1)
+    return self->get(self, p);
+
+  // take multiple trilinear probes along the major axis of an elongated footprint
+  const int probes = minor > 0.0f ? min((int)ceil(major/minor), TEXTURE2D_MAX_ANISOTROPY) : TEXTURE2D_MAX_ANISOTROPY;
+  const float lod = log2(max(major/probes, 1.0f));
+  if (probes == 1)
+    return Texture2D_trilinear(self, p, lod);
+
+  const Vec2f axis = lx > ly ? dpdx : dpdy;
+  Vec4f c = Vec4f(0.0f);
+  for (int i = 0; i < probes; i++)
+    c = c + Texture2D_trilinear(self, p + ((i+0.5f)/probes - 0.5f)*axis, lod);
+  return c*(1.0f/probes);
+}
+
+
+// Exports (called from C++)
+//////////////////////////////////////////////////////////////////////////////
+
+// sets up the levels of the texture, each level halves the size of the
+// previous one, down to a single texel
+static void initTexture2D(Texture2D *self, const Vec2i &size, const uint32_t type, const uint32_t flags)
+{
+  self->size      = size;
   self->sizef = Vec2f(nextafter((float)size.x, -1.0f), nextafter((float)size.y, -1.0f));
   self->halfTexel = Vec2f(0.5f/size.x, 0.5f/size.y);
-  self->data = data;
   self->get = Texture2D_get_addr(type, flags & TEXTURE_FILTER_NEAREST);
+  self->getLevel = Texture2D_getLevel_addr(type, flags & TEXTURE_FILTER_NEAREST);
+  self->data = nullptr;
+  self->type = type;
+  self->cacheID = 0;
+  self->loadTexels = nullptr;
+  self->loader = nullptr;
+
+  self->numLevels = 0;
+  Vec2i levelSize = size;
+  while (self->numLevels < TEXTURE2D_MAX_LEVELS)
+  {
+    Texture2DLevel *level = &self->levels[self->numLevels];
+    initLevel(level, levelSize, self, self->numLevels, type);
+    self->numLevels++;
+    if ((flags & TEXTURE_NO_MIPMAPS) || (levelSize.x == 1 && levelSize.y == 1)) break;
+    levelSize = Vec2i(max(levelSize.x/2, 1), max(levelSize.y/2, 1));
+  }
+}
+
+/*! creates a texture from the texels in data, which are stored row by
+    row; the texels get copied into a tiled layout, and the smaller
+    mip-map levels get calculated unless TEXTURE_NO_MIPMAPS is set */
+extern "C" void *Texture2D_create(Vec2i &size, void *data,
+    uint32_t type, uint32_t flags)
+{
+  Texture2D *self = (Texture2D*) alignedMalloc(sizeof(Texture2D),16);
+  initTexture2D(self, size, type, flags);
+
+  size_t bytes = 0;
+  for (int l = 0; l < self->numLevels; l++)
+    bytes += levelBytes(&self->levels[l], type);
+
+  self->data = alignedMalloc(bytes, 64);
+  char *ptr = (char*) self->data;
+  for (int l = 0; l < self->numLevels; l++) {
+    self->levels[l].data = ptr;
+    ptr += levelBytes(&self->levels[l], type);
+  }
+
+  // copy the finest level into the tiled layout
+  const size_t texelBytes = bytesPerTexel(type);
+  const Texture2DLevel *level0 = &self->levels[0];
+  parallel_for(0, size.y, 16, [&](const range<int> &r) {
+    for (int y = r.begin(); y < r.end(); y++)
+      for (int x = 0; x < size.x; x++)
+        memcpy((char*)level0->data + texelIndex(level0, Vec2i(x, y))*texelBytes, (char*)data + (size_t(y)*size.x + x)*texelBytes, texelBytes);
+  });
+
+  for (int l = 1; l < self->numLevels; l++)
+    Texture2D_downsample(type, &self->levels[l], &self->levels[l-1]);
 
   return self;
 }
 
+extern "C" void *Texture2D_createCached(Vec2i &size, uint32_t type, uint32_t flags,
+                                        Texture2D_loadTexels loadTexels, void *loader)
+{
+  static std::atomic<unsigned int> nextCacheID(1);
+
+  Texture2D *self = (Texture2D*) alignedMalloc(sizeof(Texture2D),16);
+  initTexture2D(self, size, type, flags);
+  self->cacheID = nextCacheID++;
+  self->loadTexels = loadTexels;
+  self->loader = loader;
+  return self;
+}
+
+extern "C" void Texture2D_destroy(void *super)
+{
+  Texture2D *self = (Texture2D*) super;
+  if (!self) return;
+  if (self->loadTexels) TextureCache_release(self);
+  alignedFree(self->data);
+  alignedFree(self);
+}
+
+void Texture2D_loadPage(const Texture2D *self, const int level, const Vec2i &page, char *texels)
+{
+  // the page is described as a small level, thus the texel writers can fill it
+  const Texture2DLevel *src = &self->levels[level];
+  const Vec2i begin = page*TEXTURE_CACHE_PAGE_SIZE;
+  Texture2DLevel dst = *src;
+  dst.size = min(src->size-begin, Vec2i(TEXTURE_CACHE_PAGE_SIZE));
+  dst.tilesX = src->pageTilesX;
+  dst.data = texels;
+
+  // the finest level is copied from the loader
+  const size_t texelBytes = bytesPerTexel(self->type);
+  if (level == 0)
+  {
+    std::vector<char> rows(dst.size.x*dst.size.y*texelBytes);
+    self->loadTexels(self->loader, begin, dst.size, rows.data());
+    for (int y = 0; y < dst.size.y; y++)
+      for (int x = 0; x < dst.size.x; x++)
+        memcpy(texels + texelIndex(&dst, Vec2i(x, y))*texelBytes, rows.data() + (size_t(y)*dst.size.x + x)*texelBytes, texelBytes);
+    return;
+  }
+
+  // coarser levels average blocks of 2^level x 2^level texels of the
+  // finest level row by row; building them from the next finer level
+  // would pull the entire finer levels through the cache
+  const int scale = 1 << level;
+  const Vec2i size0 = self->levels[0].size;
+  const Vec2i begin0 = begin*scale;
+  const int width0 = min(dst.size.x*scale, size0.x-begin0.x);
+  std::vector<char> row(width0*texelBytes);
+  std::vector<Vec4f> sum(dst.size.x);
+  std::vector<int> count(dst.size.x);
+  for (int y = 0; y < dst.size.y; y++)
+  {
+    for (int x = 0; x < dst.size.x; x++) {
+      sum[x] = Vec4f(0.0f);
+      count[x] = 0;
+    }
+    const int y0 = begin0.y + y*scale;
+    const int y1 = min(y0+scale, size0.y);
+    for (int sy = y0; sy < y1; sy++)
+    {
+      self->loadTexels(self->loader, Vec2i(begin0.x, sy), Vec2i(width0, 1), row.data());
+      for (int sx = 0; sx < width0; sx++) {
+        const int x = min(sx/scale, dst.size.x-1);
+        sum[x] = sum[x] + Texture2D_decode(self->type, row.data() + sx*texelBytes);
+        count[x]++;
+      }
+    }
+    for (int x = 0; x < dst.size.x; x++)
+      Texture2D_encode(self->type, &dst, Vec2i(x, y), sum[x]*(1.0f/max(count[x], 1)));
+  }
+}
+
 } // namespace embree
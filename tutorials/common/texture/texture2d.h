@@ -26,12 +26,48 @@ struct Texture2D;
 typedef Vec4f (*Texture2D_get)(const Texture2D *self,
                                        const Vec2f &p);
 
+typedef Vec4f (*Texture2D_getLevel)(const Texture2D *self,
+                                    const Vec2f &p,
+                                    const int level);
+
+/*! reads the texels [begin,begin+size) of the finest level of a cached
+    texture row by row into texels, has to be thread safe */
+typedef void (*Texture2D_loadTexels)(void *loader,
+                                     const Vec2i &begin,
+                                     const Vec2i &size,
+                                     void *texels);
+
+/*! texels are stored in square tiles of TEXTURE2D_TILE_SIZE^2 texels,
+    thus nearby lookups touch few cache lines */
+#define TEXTURE2D_TILE_SIZE 4
+#define TEXTURE2D_MAX_LEVELS 16
+#define TEXTURE2D_MAX_ANISOTROPY 8
+
+struct Texture2DLevel {
+  Vec2i         size;
+  Vec2f         sizef;     // size, as floats; slightly smaller than 'size' to avoid range checks
+  Vec2f         halfTexel; // 0.5/size, needed for bilinear filtering and clamp-to-edge
+  int           tilesX;    // number of tiles per row
+  void         *data;      // texels in tiled layout, nullptr if the texels are in the texture cache
+  const Texture2D *texture; // texture the level belongs to
+  int           index;     // mip-map level
+  int           pageTilesX; // number of tiles per row of a page in the texture cache
+  size_t        pageBytes; // size of a page in the texture cache
+};
+
 struct Texture2D {
   Vec2i         size;
   Vec2f         sizef;     // size, as floats; slightly smaller than 'size' to avoid range checks
   Vec2f         halfTexel; // 0.5/size, needed for bilinear filtering and clamp-to-edge
-  Texture2D_get get;
-  void         *data;
+  Texture2D_get get;       // lookup in the finest level
+  Texture2D_getLevel getLevel; // lookup in a given mip-map level
+  void         *data;      // texels of all levels, nullptr for cached textures
+  int           numLevels;
+  Texture2DLevel levels[TEXTURE2D_MAX_LEVELS];
+  uint32_t      type;      // texel format
+  unsigned int  cacheID;   // identifies the pages of cached textures in the texture cache
+  Texture2D_loadTexels loadTexels; // reads texels of cached textures on demand
+  void         *loader;    // passed to loadTexels
 };
 
 // XXX won't work with MIPmapping: clean implementation with clamping on integer coords needed then 
@@ -40,6 +76,27 @@ inline Vec2f clamp2edge(const Texture2D *self, const Vec2f p)
   return clamp(p, self->halfTexel, 1.0f - self->halfTexel);
 }
 
+extern "C" void *Texture2D_create(Vec2i &size, void *data,
+                                  uint32_t type, uint32_t flags);
+
+/*! creates a texture whose texels get loaded on demand through
+    loadTexels into the pages of the texture cache */
+extern "C" void *Texture2D_createCached(Vec2i &size, uint32_t type, uint32_t flags,
+                                        Texture2D_loadTexels loadTexels, void *loader);
+
+extern "C" void Texture2D_destroy(void *self);
+
+/*! fills a page of a cached texture, called by the texture cache on a miss */
+void Texture2D_loadPage(const Texture2D *self, const int level, const Vec2i &page, char *texels);
+
+/*! returns the filtered value of the texture over the footprint
+  spanned by the texture coordinate differentials dpdx and dpdy,
+  using trilinear filtering along the major axis of the footprint */
+Vec4f Texture2D_getFiltered(const Texture2D *self,
+                            const Vec2f &p,
+                            const Vec2f &dpdx,
+                            const Vec2f &dpdy);
+
 /*! helper function that returns the sampled value for the first
   channel of the given texture
 
@@ -87,6 +144,20 @@ inline Vec4f get4f(const Texture2D *self,
   return self->get(self, where);
 }
 
+/*! helper function that returns the filtered value of the four
+  channels of the given texture over the footprint given by the
+  texture coordinate differentials
+
+  \note self may NOT be nullptr!
+*/
+inline Vec4f get4f(const Texture2D *self,
+                   const Vec2f where,
+                   const Vec2f dwdx,
+                   const Vec2f dwdy)
+{
+  return Texture2D_getFiltered(self, where, dwdx, dwdy);
+}
+
 /*! helper function: get1f() with a default value if the texture is nullptr */
 inline float get1f(const Texture2D *self,
                    const Vec2f where,
@@ -0,0 +1,244 @@
+// ======================================================================== //
+// Copyright 2009-2018 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "texture_cache.h"
+#include "texture2d.h"
+#include "../../../common/sys/mutex.h"
+#include "../../../common/sys/intrinsics.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <list>
+#include <unordered_map>
+
+namespace embree {
+
+struct TexturePage
+{
+  uint64_t key;
+  int refs;                  //!< number of threads that pinned the page, guarded by the cache mutex
+  bool released;             //!< texture got destroyed while the page was pinned
+  bool failed;               //!< loading the texels failed, only valid once ready is set
+  std::atomic<bool> ready;   //!< texels got loaded
+  size_t bytes;
+  char *texels;
+  std::list<TexturePage*>::iterator lru;
+};
+
+/*! pages are identified by the texture, the level, and the page coordinates */
+inline uint64_t pageKey(const Texture2D *texture, const int level, const Vec2i &page) {
+  return (uint64_t(texture->cacheID) << 40) | (uint64_t(level) << 36) | (uint64_t(page.y) << 18) | uint64_t(page.x);
+}
+
+inline unsigned int pageCacheID(const uint64_t key) {
+  return unsigned(key >> 40);
+}
+
+class TextureCache
+{
+public:
+
+  TextureCache ()
+    : budget(0), resident(0) {}
+
+  /*! returns the pinned page, loads the page on a miss; the page
+      previously pinned by the caller gets unpinned */
+  TexturePage *acquire(const Texture2D *texture, const int level, const Vec2i &page, const uint64_t key, TexturePage *unpin)
+  {
+    mutex.lock();
+    if (unpin) unpinLocked(unpin);
+
+    auto i = pages.find(key);
+    if (i != pages.end())
+    {
+      TexturePage *p = i->second;
+      p->refs++;
+      lru.splice(lru.begin(), lru, p->lru);
+      mutex.unlock();
+
+      while (!p->ready.load(std::memory_order_acquire))
+        pause_cpu();
+
+      if (unlikely(p->failed)) {
+        this->unpin(p);
+        throw std::runtime_error("loading texture page failed");
+      }
+      return p;
+    }
+
+    TexturePage *p = new TexturePage;
+    p->key = key;
+    p->refs = 1;
+    p->released = false;
+    p->failed = false;
+    p->ready = false;
+    p->bytes = texture->levels[level].pageBytes;
+    p->texels = (char*) alignedMalloc(p->bytes, 64);
+    lru.push_front(p);
+    p->lru = lru.begin();
+    pages[key] = p;
+    resident += p->bytes;
+    evictLocked();
+    mutex.unlock();
+
+    /* load the texels outside of the lock, other threads wait for the page to get ready */
+    try {
+      Texture2D_loadPage(texture, level, page, p->texels);
+    }
+    catch (...)
+    {
+      /* remove the page from the cache such that later accesses retry
+         the load, and wake up the threads waiting for it */
+      Lock<MutexSys> lock(mutex);
+      p->failed = true;
+      if (!p->released) {
+        pages.erase(p->key);
+        lru.erase(p->lru);
+        resident -= p->bytes;
+        p->released = true;
+      }
+      p->ready.store(true, std::memory_order_release);
+      unpinLocked(p);
+      throw;
+    }
+    p->ready.store(true, std::memory_order_release);
+    return p;
+  }
+
+  void unpin(TexturePage *p)
+  {
+    Lock<MutexSys> lock(mutex);
+    unpinLocked(p);
+  }
+
+  void release(const Texture2D *texture)
+  {
+    Lock<MutexSys> lock(mutex);
+    for (auto i = pages.begin(); i != pages.end(); )
+    {
+      TexturePage *p = i->second;
+      if (pageCacheID(p->key) != texture->cacheID) { i++; continue; }
+      i = pages.erase(i);
+      lru.erase(p->lru);
+      resident -= p->bytes;
+      if (p->refs == 0) destroy(p);
+      else p->released = true;
+    }
+  }
+
+private:
+
+  /*! pages get unpinned when a thread stops using them, thus they count as recently used */
+  void unpinLocked(TexturePage *p)
+  {
+    if (--p->refs > 0) return;
+    if (p->released) destroy(p);
+    else lru.splice(lru.begin(), lru, p->lru);
+  }
+
+  /*! evicts least recently used pages that no thread has pinned until the budget is met */
+  void evictLocked()
+  {
+    for (auto i = lru.rbegin(); resident > budget && i != lru.rend(); )
+    {
+      TexturePage *p = *i;
+      if (p->refs > 0) { i++; continue; }
+      pages.erase(p->key);
+      resident -= p->bytes;
+      i = std::list<TexturePage*>::reverse_iterator(lru.erase(std::next(i).base()));
+      destroy(p);
+    }
+  }
+
+  void destroy(TexturePage *p)
+  {
+    alignedFree(p->texels);
+    delete p;
+  }
+
+public:
+  MutexSys mutex;
+  std::unordered_map<uint64_t,TexturePage*> pages;
+  std::list<TexturePage*> lru; //!< most recently used pages first
+  std::atomic<size_t> budget;
+  std::atomic<size_t> resident;
+};
+
+/* never destroyed, as textures may still get released during static destruction */
+static TextureCache &textureCache = *new TextureCache;
+
+/*! each thread keeps the pages it used last pinned in a small direct
+    mapped table, thus hits in this table need neither locking nor an
+    update of the LRU order */
+struct ThreadPages
+{
+  ThreadPages ()
+  {
+    for (size_t i=0; i<TEXTURE_CACHE_THREAD_PAGES; i++) {
+      keys[i] = 0;
+      pages[i] = nullptr;
+    }
+  }
+
+  ~ThreadPages ()
+  {
+    for (size_t i=0; i<TEXTURE_CACHE_THREAD_PAGES; i++)
+      if (pages[i]) textureCache.unpin(pages[i]);
+  }
+
+  uint64_t keys[TEXTURE_CACHE_THREAD_PAGES];
+  TexturePage *pages[TEXTURE_CACHE_THREAD_PAGES];
+};
+
+static thread_local ThreadPages threadPages;
+
+void TextureCache_setBudget(size_t bytes) {
+  textureCache.budget = bytes;
+}
+
+size_t TextureCache_getBudget() {
+  return textureCache.budget;
+}
+
+size_t TextureCache_getResidentBytes() {
+  return textureCache.resident;
+}
+
+const char *TextureCache_getPage(const Texture2D *texture, const int level, const Vec2i &page)
+{
+  /* cache IDs start at 1, thus key 0 marks empty slots */
+  const uint64_t key = pageKey(texture, level, page);
+  const size_t slot = size_t((key*0x9E3779B97F4A7C15ull) >> 40) & (TEXTURE_CACHE_THREAD_PAGES-1);
+  ThreadPages &local = threadPages;
+  if (likely(local.keys[slot] == key))
+    return local.pages[slot]->texels;
+
+  /* loading the page may fill the slot again with a page of a finer level */
+  TexturePage *unpin = local.pages[slot];
+  local.keys[slot] = 0;
+  local.pages[slot] = nullptr;
+  TexturePage *p = textureCache.acquire(texture, level, page, key, unpin);
+  if (local.pages[slot]) textureCache.unpin(local.pages[slot]);
+  local.keys[slot] = key;
+  local.pages[slot] = p;
+  return p->texels;
+}
+
+void TextureCache_release(const Texture2D *texture) {
+  textureCache.release(texture);
+}
+
+} // namespace embree
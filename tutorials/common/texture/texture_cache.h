@@ -0,0 +1,51 @@
+// ======================================================================== //
+// Copyright 2009-2018 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "../math/vec.h"
+
+namespace embree {
+
+struct Texture2D;
+
+/*! each mip-map level of a cached texture is split into pages of
+    TEXTURE_CACHE_PAGE_SIZE^2 texels, which are loaded on first access */
+#define TEXTURE_CACHE_PAGE_SIZE 64
+
+/*! number of pages each thread keeps pinned to find them without locking, has to be a power of two */
+#define TEXTURE_CACHE_THREAD_PAGES 64
+
+/*! sets the maximal number of bytes of resident pages, 0 disables
+    demand loading of textures; pages pinned by threads are never
+    evicted, thus the budget can be exceeded by up to
+    TEXTURE_CACHE_THREAD_PAGES pages per thread */
+void TextureCache_setBudget(size_t bytes);
+
+/*! returns the memory budget of the texture cache */
+size_t TextureCache_getBudget();
+
+/*! returns the number of bytes of the pages currently resident */
+size_t TextureCache_getResidentBytes();
+
+/*! returns the texels of a page of the given mip-map level, the page
+    gets loaded through Texture2D_loadPage if it is not resident */
+const char *TextureCache_getPage(const Texture2D *texture, const int level, const Vec2i &page);
+
+/*! removes all pages of the texture from the cache */
+void TextureCache_release(const Texture2D *texture);
+
+} // namespace embree
@@ -16,6 +16,7 @@
 
 #include "scene_device.h"
 #include "application.h"
+#include "../../../common/algorithms/parallel_for.h"
 
 #define FIXED_EDGE_TESSELLATION_VALUE 4
 
@@ -23,6 +24,7 @@ namespace embree
 {
   extern "C" {
     int g_instancing_mode = SceneGraph::INSTANCING_NONE;
+    bool g_lighttree = false; //!< spot and quad lights only get converted for the light tree, the other renderers ignore them
   }
 
   void deleteGeometry(ISPCGeometry* geom)
@@ -39,8 +41,58 @@ namespace embree
     }
   }
   
+  /* collects all nodes to convert in the order a sequential conversion
+     would visit them, separated into meshes, groups of meshes, and
+     instances of groups, such that each set only depends on the
+     previous sets and can get converted in parallel */
+  static void collectGeometries(TutorialScene* scene, Ref<SceneGraph::Node> in, std::set<Ref<SceneGraph::Node>>& visited,
+                                std::vector<Ref<SceneGraph::Node>>& meshes,
+                                std::vector<Ref<SceneGraph::Node>>& groups,
+                                std::vector<Ref<SceneGraph::Node>>& instances)
+  {
+    if (in->geometry || !visited.insert(in).second)
+      return;
+
+    if (Ref<SceneGraph::TransformNode> xfmNode = in.dynamicCast<SceneGraph::TransformNode>()) {
+      collectGeometries(scene,xfmNode->child,visited,meshes,groups,instances);
+      instances.push_back(in);
+    }
+    else if (Ref<SceneGraph::GroupNode> groupNode = in.dynamicCast<SceneGraph::GroupNode>()) {
+      for (size_t i=0; i<groupNode->size(); i++)
+        collectGeometries(scene,groupNode->child(i),visited,meshes,groups,instances);
+      groups.push_back(in);
+    }
+    else
+    {
+      /* material IDs get assigned here, thus they do not depend on the order meshes get converted in */
+      if      (Ref<SceneGraph::TriangleMeshNode> mesh = in.dynamicCast<SceneGraph::TriangleMeshNode>()) scene->materialID(mesh->material);
+      else if (Ref<SceneGraph::QuadMeshNode>     mesh = in.dynamicCast<SceneGraph::QuadMeshNode>    ()) scene->materialID(mesh->material);
+      else if (Ref<SceneGraph::SubdivMeshNode>   mesh = in.dynamicCast<SceneGraph::SubdivMeshNode>  ()) scene->materialID(mesh->material);
+      else if (Ref<SceneGraph::HairSetNode>      mesh = in.dynamicCast<SceneGraph::HairSetNode>     ()) scene->materialID(mesh->material);
+      else if (Ref<SceneGraph::GridMeshNode>     mesh = in.dynamicCast<SceneGraph::GridMeshNode>    ()) scene->materialID(mesh->material);
+      meshes.push_back(in);
+    }
+  }
+
+  static void convertGeometries(TutorialScene* scene, const std::vector<Ref<SceneGraph::Node>>& nodes)
+  {
+    parallel_for(size_t(0),nodes.size(),[&](const range<size_t>& r) {
+        for (size_t i=r.begin(); i<r.end(); i++)
+          ISPCScene::convertGeometry(scene,nodes[i]);
+      });
+  }
+  
   ISPCScene::ISPCScene(TutorialScene* in)
   {
+    std::set<Ref<SceneGraph::Node>> visited;
+    std::vector<Ref<SceneGraph::Node>> meshes, groups, instances;
+    for (size_t i=0; i<in->geometries.size(); i++)
+      collectGeometries(in,in->geometries[i],visited,meshes,groups,instances);
+
+    convertGeometries(in,meshes);
+    convertGeometries(in,groups);
+    convertGeometries(in,instances);
+      
     geometries = new ISPCGeometry*[in->geometries.size()];
     for (size_t i=0; i<in->geometries.size(); i++)
       geometries[i] = convertGeometry(in,in->geometries[i]);
@@ -111,8 +163,25 @@ namespace embree
       break;
     }
     case SceneGraph::LIGHT_SPOT:
-    case SceneGraph::LIGHT_TRIANGLE:
+    {
+      if (!g_lighttree) break;
+      Ref<SceneGraph::SpotLight> inSpot = in.dynamicCast<SceneGraph::SpotLight>();
+      const float cosAngleMin = cos(deg2rad(inSpot->angleMin));
+      const float cosAngleMax = cos(deg2rad(inSpot->angleMax));
+      const float cosAngleScale = cosAngleMin > cosAngleMax ? rcp(cosAngleMin - cosAngleMax) : 1E10f;
+      out = SpotLight_create();
+      SpotLight_set(out, inSpot->P, normalize(inSpot->D), inSpot->I, cosAngleMax, cosAngleScale, 0.f);
+      break;
+    }
     case SceneGraph::LIGHT_QUAD:
+    {
+      if (!g_lighttree) break;
+      Ref<SceneGraph::QuadLight> inQuad = in.dynamicCast<SceneGraph::QuadLight>();
+      out = QuadLight_create();
+      QuadLight_set(out, inQuad->v0, inQuad->v3 - inQuad->v0, inQuad->v1 - inQuad->v0, inQuad->L);
+      break;
+    }
+    case SceneGraph::LIGHT_TRIANGLE:
     {
       // FIXME: not implemented yet
       break;
@@ -472,24 +541,29 @@ namespace embree
     return geomID;
   }
   
+  void ConvertGeometry(RTCDevice device, ISPCGeometry* geometry, RTCBuildQuality quality, RTCScene scene_out, unsigned int geomID)
+  {
+    if (geometry->type == SUBDIV_MESH)
+      ConvertSubdivMesh(device,(ISPCSubdivMesh*) geometry, quality, scene_out, geomID);
+    else if (geometry->type == TRIANGLE_MESH)
+      ConvertTriangleMesh(device,(ISPCTriangleMesh*) geometry, quality, scene_out, geomID);
+    else if (geometry->type == QUAD_MESH)
+      ConvertQuadMesh(device,(ISPCQuadMesh*) geometry, quality, scene_out, geomID);
+    else if (geometry->type == CURVES)
+      ConvertCurveGeometry(device,(ISPCHairSet*) geometry, quality, scene_out, geomID);
+    else if (geometry->type == GRID_MESH)
+      ConvertGridMesh(device,(ISPCGridMesh*) geometry, quality, scene_out, geomID);
+    else
+      assert(false);
+  }
+  
   void ConvertGroup(RTCDevice device, ISPCGroup* group, RTCBuildQuality quality, RTCScene scene_out, unsigned int geomID)
   {
-    for (unsigned int i=0; i<group->numGeometries; i++)
-    {
-      ISPCGeometry* geometry = group->geometries[i];
-      if (geometry->type == SUBDIV_MESH)
-        ConvertSubdivMesh(device,(ISPCSubdivMesh*) geometry, quality, scene_out, i);
-      else if (geometry->type == TRIANGLE_MESH)
-        ConvertTriangleMesh(device,(ISPCTriangleMesh*) geometry, quality, scene_out, i);
-      else if (geometry->type == QUAD_MESH)
-        ConvertQuadMesh(device,(ISPCQuadMesh*) geometry, quality, scene_out, i);
-      else if (geometry->type == CURVES)
-        ConvertCurveGeometry(device,(ISPCHairSet*) geometry, quality, scene_out, i);
-      else if (geometry->type == GRID_MESH)
-        ConvertGridMesh(device,(ISPCGridMesh*) geometry, quality, scene_out, i);
-      else
-        assert(false);
-    }
+    /* geometries get created in parallel, attaching them by ID keeps the geometry IDs deterministic */
+    parallel_for(size_t(0),size_t(group->numGeometries),[&](const range<size_t>& r) {
+        for (size_t i=r.begin(); i<r.end(); i++)
+          ConvertGeometry(device,group->geometries[i],quality,scene_out,(unsigned int)i);
+      });
     group->geom.geometry = nullptr;
     group->geom.scene = scene_out;
     group->geom.geomID = geomID;
@@ -535,6 +609,7 @@ namespace embree
     /* use scene instancing feature */
     if (g_instancing_mode != SceneGraph::INSTANCING_NONE)
     {
+      /* create all instanced scenes first, as instances refer to them */
       for (unsigned int i=0; i<scene_in->numGeometries; i++)
       {
         ISPCGeometry* geometry = scene_in->geometries[i];
@@ -543,33 +618,26 @@ namespace embree
           ConvertGroup(g_device,(ISPCGroup*) geometry,quality,objscene,i);
           //rtcCommitScene(objscene);
         }
-        else if (geometry->type == INSTANCE) {
-          ConvertInstance(g_device,scene_in, (ISPCInstance*) geometry, scene_out, i);
-        }
-        else
+        else if (geometry->type != INSTANCE)
           assert(false);
       }
+
+      parallel_for(size_t(0),size_t(scene_in->numGeometries),[&](const range<size_t>& r) {
+          for (size_t i=r.begin(); i<r.end(); i++) {
+            ISPCGeometry* geometry = scene_in->geometries[i];
+            if (geometry->type == INSTANCE)
+              ConvertInstance(g_device,scene_in, (ISPCInstance*) geometry, scene_out, (unsigned int)i);
+          }
+        });
     }
     
     /* no instancing */
     else
     {
-      for (unsigned int i=0; i<scene_in->numGeometries; i++)
-      {
-        ISPCGeometry* geometry = scene_in->geometries[i];
-        if (geometry->type == SUBDIV_MESH)
-          ConvertSubdivMesh(g_device,(ISPCSubdivMesh*) geometry, quality, scene_out, i);
-        else if (geometry->type == TRIANGLE_MESH)
-          ConvertTriangleMesh(g_device,(ISPCTriangleMesh*) geometry, quality, scene_out, i);
-        else if (geometry->type == QUAD_MESH)
-          ConvertQuadMesh(g_device,(ISPCQuadMesh*) geometry, quality, scene_out, i);
-        else if (geometry->type == CURVES)
-          ConvertCurveGeometry(g_device,(ISPCHairSet*) geometry, quality, scene_out, i);
-         else if (geometry->type == GRID_MESH)
-          ConvertGridMesh(g_device,(ISPCGridMesh*) geometry, quality, scene_out, i);
-        else
-          assert(false);
-      }
+      parallel_for(size_t(0),size_t(scene_in->numGeometries),[&](const range<size_t>& r) {
+          for (size_t i=r.begin(); i<r.end(); i++)
+            ConvertGeometry(g_device,scene_in->geometries[i],quality,scene_out,(unsigned int)i);
+        });
     }
 
     Application::instance->log(1,"creating Embree objects done");
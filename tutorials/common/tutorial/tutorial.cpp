@@ -323,6 +323,10 @@ namespace embree
         sceneFilename = path + cin->getFileName();
       }, "-i <filename>: parses scene from <filename>");
 
+    registerOption("texture-cache", [] (Ref<ParseStream> cin, const FileName& path) {
+        TextureCache_setBudget(size_t(cin->getInt())*1024*1024);
+      }, "--texture-cache <MB>: loads texture pages on first access and keeps at most <MB> megabytes of them in memory, only PFM and binary PPM textures are loaded on demand");
+
     registerOption("animlist", [this] (Ref<ParseStream> cin, const FileName& path) {
         FileName listFilename = path + cin->getFileName();
 
@@ -419,13 +423,15 @@ namespace embree
         else if (mode == "geometry") instancing_mode = SceneGraph::INSTANCING_GEOMETRY;
         else if (mode == "group"   ) instancing_mode = SceneGraph::INSTANCING_GROUP;
         else if (mode == "flattened") instancing_mode = SceneGraph::INSTANCING_FLATTENED;
+        else if (mode == "multi_level") instancing_mode = SceneGraph::INSTANCING_MULTI_LEVEL;
         else throw std::runtime_error("unknown instancing mode: "+mode);
         g_instancing_mode = instancing_mode;
       }, "--instancing: set instancing mode\n"
       "  none: no instancing\n"
       "  geometry: instance individual geometries as scenes\n"
       "  group: instance geometry groups as scenes\n"
-      "  flattened: assume flattened scene graph");
+      "  flattened: assume flattened scene graph\n"
+      "  multi_level: map nested instances onto instances of shared subtrees");
 
     registerOption("ambientlight", [this] (Ref<ParseStream> cin, const FileName& path) {
         const Vec3fa L = cin->getVec3fa();
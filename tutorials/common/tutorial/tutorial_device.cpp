@@ -867,6 +867,10 @@ float getTextureTexel1f(const Texture* texture, float s, float t)
 {
   if (!texture) return 0.0f;
 
+  /* texels of textures loaded on demand are only in the texture cache */
+  if (!texture->data && texture->texture2D)
+    return get1f(texture->texture2D,Vec2f(s,t));
+
   int iu = (int)floor(s * (float)(texture->width));
   iu = iu % texture->width; if (iu < 0) iu += texture->width;
   int iv = (int)floor(t * (float)(texture->height));
@@ -890,6 +894,10 @@ Vec3fa getTextureTexel3f(const Texture* texture, float s, float t)
 {
   if (!texture) return Vec3fa(0.0f,0.0f,0.0f);
 
+  /* texels of textures loaded on demand are only in the texture cache */
+  if (!texture->data && texture->texture2D)
+    return get3f(texture->texture2D,Vec2f(s,t));
+
   int iu = (int)floor(s * (float)(texture->width));
   iu = iu % texture->width; if (iu < 0) iu += texture->width;
   int iv = (int)floor(t * (float)(texture->height));
@@ -907,4 +915,19 @@ Vec3fa getTextureTexel3f(const Texture* texture, float s, float t)
   return Vec3fa(0.0f,0.0f,0.0f);
 }
 
+float getTextureTexel1f(const Texture* texture, float s, float t, const Vec2f& duvdx, const Vec2f& duvdy)
+{
+  if (!texture) return 0.0f;
+  if (!texture->texture2D) return getTextureTexel1f(texture,s,t);
+  return get4f(texture->texture2D,Vec2f(s,t),duvdx,duvdy).x;
+}
+
+Vec3fa getTextureTexel3f(const Texture* texture, float s, float t, const Vec2f& duvdx, const Vec2f& duvdy)
+{
+  if (!texture) return Vec3fa(0.0f,0.0f,0.0f);
+  if (!texture->texture2D) return getTextureTexel3f(texture,s,t);
+  const Vec4f c = get4f(texture->texture2D,Vec2f(s,t),duvdx,duvdy);
+  return Vec3fa(c.x,c.y,c.z);
+}
+
 } // namespace embree
@@ -145,6 +145,10 @@ Vec2f  getTextureCoordinatesSubdivMesh(void* mesh, const unsigned int primID, co
 float  getTextureTexel1f(const Texture* texture, float u, float v);
 Vec3fa  getTextureTexel3f(const Texture* texture, float u, float v);
 
+/* filtered texture lookups over the footprint given by the texture coordinate differentials */
+float  getTextureTexel1f(const Texture* texture, float u, float v, const Vec2f& duvdx, const Vec2f& duvdy);
+Vec3fa  getTextureTexel3f(const Texture* texture, float u, float v, const Vec2f& duvdx, const Vec2f& duvdy);
+
 enum ISPCInstancingMode { ISPC_INSTANCING_NONE, ISPC_INSTANCING_GEOMETRY, ISPC_INSTANCING_GROUP };
 
 /* ray statistics */
@@ -214,6 +214,11 @@ namespace embree
         g_scene = SceneGraph::flatten(g_scene,SceneGraph::INSTANCING_GEOMETRY);
       }
 
+      /* flatten scene */
+      else if (tag == "-flatten-multi-level") {
+        g_scene = SceneGraph::flatten(g_scene,SceneGraph::INSTANCING_MULTI_LEVEL);
+      }
+
       /* flatten scene */
       else if (tag == "-flatten") {
         g_scene = SceneGraph::flatten(g_scene,SceneGraph::INSTANCING_NONE);
@@ -0,0 +1,67 @@
+// ======================================================================== //
+// Copyright 2009-2018 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "../common/tutorial/tutorial.h"
+
+namespace embree
+{
+  extern "C" {
+    float g_curvature = 0.5f;
+    float g_thickness = 0.01f;
+    int g_num_hairs = 10000;
+    int g_num_rays = 1000000;
+    int g_num_reference_rays = 2000;
+    int g_iterations = 5;
+  }
+
+  struct Tutorial : public TutorialApplication
+  {
+    Tutorial()
+      : TutorialApplication("curve_bench",FEATURE_RTCORE)
+    {
+      interactive = false;
+
+      registerOption("curvature", [] (Ref<ParseStream> cin, const FileName& path) {
+          g_curvature = cin->getFloat();
+        }, "--curvature <float>: lateral displacement of inner control points relative to hair length (default 0.5)");
+
+      registerOption("thickness", [] (Ref<ParseStream> cin, const FileName& path) {
+          g_thickness = cin->getFloat();
+        }, "--thickness <float>: hair radius relative to hair length (default 0.01)");
+
+      registerOption("hairs", [] (Ref<ParseStream> cin, const FileName& path) {
+          g_num_hairs = cin->getInt();
+        }, "--hairs <int>: number of synthetic hair segments (default 10000)");
+
+      registerOption("rays", [] (Ref<ParseStream> cin, const FileName& path) {
+          g_num_rays = cin->getInt();
+        }, "--rays <int>: number of rays traced per iteration (default 1000000)");
+
+      registerOption("reference-rays", [] (Ref<ParseStream> cin, const FileName& path) {
+          g_num_reference_rays = cin->getInt();
+        }, "--reference-rays <int>: number of rays checked against the double precision reference (default 2000)");
+
+      registerOption("iterations", [] (Ref<ParseStream> cin, const FileName& path) {
+          g_iterations = cin->getInt();
+        }, "--iterations <int>: number of timed iterations per intersector and ray type (default 5)");
+    }
+  };
+
+}
+
+int main(int argc, char** argv) {
+  return embree::Tutorial().main(argc,argv);
+}
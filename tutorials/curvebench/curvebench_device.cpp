@@ -0,0 +1,630 @@
+// ======================================================================== //
+// Copyright 2009-2018 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "../common/tutorial/tutorial_device.h"
+#include "../common/math/random_sampler.h"
+
+namespace embree {
+
+  extern "C" float g_curvature;
+  extern "C" float g_thickness;
+  extern "C" int g_num_hairs;
+  extern "C" int g_num_rays;
+  extern "C" int g_num_reference_rays;
+  extern "C" int g_iterations;
+
+  /* scene data */
+  RTCScene g_scene = nullptr;
+
+  /* distance between hair roots in units of the hair length */
+  static const float hair_spacing = 4.0f;
+
+  /* distance of the ray origin to the targeted hair point */
+  static const float ray_distance = 2.0f;
+
+  /* number of samples used to bracket the roots of the reference solvers */
+  static const size_t num_reference_samples = 64;
+
+  typedef Vec3<double> Vec3d;
+
+  __forceinline Vec3d toVec3d(const Vec3fa& v) {
+    return Vec3d(v.x,v.y,v.z);
+  }
+
+  enum CurveBasis { BASIS_LINEAR, BASIS_BEZIER, BASIS_BSPLINE };
+  enum CurveShape { SHAPE_FLAT, SHAPE_ROUND, SHAPE_ORIENTED };
+
+  struct CurveType
+  {
+    const char* name;
+    RTCGeometryType type;
+    CurveBasis basis;
+    CurveShape shape;
+  };
+
+  static const CurveType curve_types[] =
+  {
+    { "FLAT_LINEAR_CURVE",             RTC_GEOMETRY_TYPE_FLAT_LINEAR_CURVE,             BASIS_LINEAR,  SHAPE_FLAT     },
+    { "FLAT_BEZIER_CURVE",             RTC_GEOMETRY_TYPE_FLAT_BEZIER_CURVE,             BASIS_BEZIER,  SHAPE_FLAT     },
+    { "ROUND_BEZIER_CURVE",            RTC_GEOMETRY_TYPE_ROUND_BEZIER_CURVE,            BASIS_BEZIER,  SHAPE_ROUND    },
+    { "NORMAL_ORIENTED_BEZIER_CURVE",  RTC_GEOMETRY_TYPE_NORMAL_ORIENTED_BEZIER_CURVE,  BASIS_BEZIER,  SHAPE_ORIENTED },
+    { "FLAT_BSPLINE_CURVE",            RTC_GEOMETRY_TYPE_FLAT_BSPLINE_CURVE,            BASIS_BSPLINE, SHAPE_FLAT     },
+    { "ROUND_BSPLINE_CURVE",           RTC_GEOMETRY_TYPE_ROUND_BSPLINE_CURVE,           BASIS_BSPLINE, SHAPE_ROUND    },
+    { "NORMAL_ORIENTED_BSPLINE_CURVE", RTC_GEOMETRY_TYPE_NORMAL_ORIENTED_BSPLINE_CURVE, BASIS_BSPLINE, SHAPE_ORIENTED },
+  };
+
+  /* cubic Bezier segment evaluated in double precision, used as ground truth */
+  struct ReferenceCurve
+  {
+    ReferenceCurve() {}
+
+    ReferenceCurve (CurveBasis basis, const Vec3fa* v, const Vec3fa* vn)
+    {
+      Vec3d q[4], m[4]; double w[4];
+      for (size_t i=0; i<4; i++) {
+        q[i] = toVec3d(v[i]); w[i] = v[i].w; m[i] = toVec3d(vn[i]);
+      }
+
+      if (basis == BASIS_BSPLINE)
+      {
+        /* convert B-spline control points to Bezier control points */
+        p[0] = (q[0]+4.0*q[1]+q[2])*(1.0/6.0); r[0] = (w[0]+4.0*w[1]+w[2])*(1.0/6.0); n[0] = (m[0]+4.0*m[1]+m[2])*(1.0/6.0);
+        p[1] = (4.0*q[1]+2.0*q[2])*(1.0/6.0);  r[1] = (4.0*w[1]+2.0*w[2])*(1.0/6.0);  n[1] = (4.0*m[1]+2.0*m[2])*(1.0/6.0);
+        p[2] = (2.0*q[1]+4.0*q[2])*(1.0/6.0);  r[2] = (2.0*w[1]+4.0*w[2])*(1.0/6.0);  n[2] = (2.0*m[1]+4.0*m[2])*(1.0/6.0);
+        p[3] = (q[1]+4.0*q[2]+q[3])*(1.0/6.0); r[3] = (w[1]+4.0*w[2]+w[3])*(1.0/6.0); n[3] = (m[1]+4.0*m[2]+m[3])*(1.0/6.0);
+      }
+      else if (basis == BASIS_LINEAR)
+      {
+        /* linear segments only use the first two control points */
+        for (size_t i=0; i<4; i++) {
+          const double f = double(i)/3.0;
+          p[i] = (1.0-f)*q[0] + f*q[1]; r[i] = (1.0-f)*w[0] + f*w[1]; n[i] = (1.0-f)*m[0] + f*m[1];
+        }
+      }
+      else
+      {
+        for (size_t i=0; i<4; i++) {
+          p[i] = q[i]; r[i] = w[i]; n[i] = m[i];
+        }
+      }
+    }
+
+    void eval(double u, Vec3d& P, Vec3d& dPdu, double& R) const
+    {
+      const double t = 1.0-u;
+      const double b0 = t*t*t, b1 = 3.0*u*t*t, b2 = 3.0*u*u*t, b3 = u*u*u;
+      const double d0 = -3.0*t*t, d1 = 3.0*t*t-6.0*u*t, d2 = 6.0*u*t-3.0*u*u, d3 = 3.0*u*u;
+      P = b0*p[0] + b1*p[1] + b2*p[2] + b3*p[3];
+      dPdu = d0*p[0] + d1*p[1] + d2*p[2] + d3*p[3];
+      R = b0*r[0] + b1*r[1] + b2*r[2] + b3*r[3];
+    }
+
+    Vec3d eval(double u) const {
+      Vec3d P, dPdu; double R; eval(u,P,dPdu,R); return P;
+    }
+
+    BBox<Vec3d> bounds() const
+    {
+      const double rmax = max(max(r[0],r[1]),max(r[2],r[3]));
+      BBox<Vec3d> b(p[0]);
+      for (size_t i=1; i<4; i++) b.extend(p[i]);
+      return BBox<Vec3d>(b.lower-Vec3d(rmax),b.upper+Vec3d(rmax));
+    }
+
+    double minRadius() const {
+      return min(min(r[0],r[1]),min(r[2],r[3]));
+    }
+
+    Vec3d p[4];
+    double r[4];
+    Vec3d n[4];
+  };
+
+  /* finds all roots of f in [0,1] by bracketing and bisection */
+  template<typename F>
+    void find_roots(const F& f, const size_t N, std::vector<double>& roots)
+  {
+    roots.clear();
+    double u0 = 0.0, f0 = f(u0);
+    if (f0 == 0.0) roots.push_back(u0);
+    for (size_t i=1; i<=N; i++)
+    {
+      double u1 = double(i)/double(N), f1 = f(u1);
+      if (f1 == 0.0) roots.push_back(u1);
+      else if ((f0 < 0.0) != (f1 < 0.0) && f0 != 0.0)
+      {
+        double a = u0, fa = f0, b = u1;
+        for (size_t j=0; j<52; j++) {
+          const double c = 0.5*(a+b), fc = f(c);
+          if ((fa < 0.0) == (fc < 0.0)) { a = c; fa = fc; } else b = c;
+        }
+        roots.push_back(0.5*(a+b));
+      }
+      u0 = u1; f0 = f1;
+    }
+  }
+
+  /* tests if point Q lies inside the swept circles of a round curve */
+  bool inside_round(const ReferenceCurve& curve, const Vec3d& Q, std::vector<double>& roots)
+  {
+    auto f = [&] (double u) {
+      Vec3d P, dPdu; double R; curve.eval(u,P,dPdu,R);
+      return dot(Q-P,dPdu);
+    };
+    find_roots(f,num_reference_samples,roots);
+    for (size_t i=0; i<roots.size(); i++) {
+      Vec3d P, dPdu; double R; curve.eval(roots[i],P,dPdu,R);
+      if (length(Q-P) <= R) return true;
+    }
+    return false;
+  }
+
+  /* clips the ray against the bounds of the curve */
+  bool clip_ray(const ReferenceCurve& curve, const Vec3d& org, const Vec3d& dir, double& t0, double& t1)
+  {
+    const BBox<Vec3d> b = curve.bounds();
+    t0 = 0.0; t1 = std::numeric_limits<double>::infinity();
+    for (size_t k=0; k<3; k++)
+    {
+      if (dir[k] == 0.0) {
+        if (org[k] < b.lower[k] || org[k] > b.upper[k]) return false;
+        continue;
+      }
+      double tl = (b.lower[k]-org[k])/dir[k];
+      double tu = (b.upper[k]-org[k])/dir[k];
+      if (tl > tu) std::swap(tl,tu);
+      t0 = max(t0,tl); t1 = min(t1,tu);
+    }
+    return t0 <= t1;
+  }
+
+  /* reference for round curves: first entry point into the volume swept by
+   * circles perpendicular to the curve tangent */
+  bool reference_round(const ReferenceCurve& curve, const Vec3d& org, const Vec3d& dir, double& t_hit)
+  {
+    double t0, t1;
+    if (!clip_ray(curve,org,dir,t0,t1)) return false;
+
+    std::vector<double> roots;
+    const double dt = 0.25*curve.minRadius();
+    double ta = t0;
+    for (double tb = t0; tb <= t1+dt; ta = tb, tb += dt)
+    {
+      if (!inside_round(curve,org+tb*dir,roots)) continue;
+      if (tb == t0) { t_hit = t0; return true; }
+      for (size_t j=0; j<52; j++) {
+        const double tc = 0.5*(ta+tb);
+        if (inside_round(curve,org+tc*dir,roots)) tb = tc; else ta = tc;
+      }
+      t_hit = tb;
+      return true;
+    }
+    return false;
+  }
+
+  /* builds an orthonormal frame with the ray direction as z axis */
+  void ray_frame(const Vec3d& dir, Vec3d& dx, Vec3d& dy)
+  {
+    const Vec3d a = abs(dir.x) < 0.5 ? Vec3d(1,0,0) : Vec3d(0,1,0);
+    dx = cross(a,dir); dx = dx/length(dx);
+    dy = cross(dir,dx);
+  }
+
+  /* reference for flat curves: ribbon that always faces the ray */
+  bool reference_flat(const ReferenceCurve& curve, const Vec3d& org, const Vec3d& dir, double& t_hit)
+  {
+    Vec3d dx, dy; ray_frame(dir,dx,dy);
+    auto f = [&] (double u) {
+      Vec3d P, dPdu; double R; curve.eval(u,P,dPdu,R);
+      const Vec3d d = P-org;
+      return dot(d,dx)*dot(dPdu,dx) + dot(d,dy)*dot(dPdu,dy);
+    };
+
+    std::vector<double> roots;
+    find_roots(f,4*num_reference_samples,roots);
+
+    bool hit = false;
+    for (size_t i=0; i<roots.size(); i++)
+    {
+      Vec3d P, dPdu; double R; curve.eval(roots[i],P,dPdu,R);
+      const Vec3d d = P-org;
+      if (sqr(dot(d,dx)) + sqr(dot(d,dy)) > sqr(R)) continue;
+      const double t = dot(d,dir);
+      if (t <= 0.0 || (hit && t >= t_hit)) continue;
+      t_hit = t; hit = true;
+    }
+    return hit;
+  }
+
+  /* reference for normal oriented curves: ruled surface between the left and
+   * right boundary curves */
+  bool reference_oriented(const ReferenceCurve& curve, const Vec3d& org, const Vec3d& dir, double& t_hit)
+  {
+    auto normalize = [] (const Vec3d& v) { return v/length(v); };
+    const Vec3d k0 = normalize(cross(curve.n[0],curve.p[1]-curve.p[0]));
+    const Vec3d k3 = normalize(cross(curve.n[3],curve.p[3]-curve.p[2]));
+    const Vec3d d[4] = { curve.r[0]*k0, curve.r[1]*k0, curve.r[2]*k3, curve.r[3]*k3 };
+
+    ReferenceCurve L = curve, R = curve;
+    for (size_t i=0; i<4; i++) {
+      L.p[i] = curve.p[i]-d[i];
+      R.p[i] = curve.p[i]+d[i];
+    }
+
+    auto f = [&] (double u) {
+      const Vec3d l = L.eval(u), w = R.eval(u)-l;
+      return dot(dir,cross(w,l-org));
+    };
+
+    std::vector<double> roots;
+    find_roots(f,4*num_reference_samples,roots);
+
+    bool hit = false;
+    for (size_t i=0; i<roots.size(); i++)
+    {
+      /* solve org + t*dir = l + v*w in the least squares sense */
+      const Vec3d l = L.eval(roots[i]), w = R.eval(roots[i])-l, a = l-org;
+      const double dd = dot(dir,dir), dw = dot(dir,w), ww = dot(w,w);
+      const double da = dot(dir,a), wa = dot(w,a);
+      const double det = dd*ww-dw*dw;
+      if (det == 0.0) continue;
+      const double t = (ww*da-dw*wa)/det;
+      const double v = (dw*da-dd*wa)/det;
+      if (v < 0.0 || v > 1.0) continue;
+      if (t <= 0.0 || (hit && t >= t_hit)) continue;
+      t_hit = t; hit = true;
+    }
+    return hit;
+  }
+
+  bool reference_intersect(const CurveType& type, const ReferenceCurve& curve, const Vec3d& org, const Vec3d& dir, double& t_hit)
+  {
+    switch (type.shape) {
+    case SHAPE_FLAT    : return reference_flat(curve,org,dir,t_hit);
+    case SHAPE_ROUND   : return reference_round(curve,org,dir,t_hit);
+    case SHAPE_ORIENTED: return reference_oriented(curve,org,dir,t_hit);
+    }
+    return false;
+  }
+
+  /* synthetic hair patch, one curve segment per hair */
+  struct HairSet
+  {
+    HairSet (const CurveType& type, size_t numHairs, float curvature, float thickness)
+      : numHairs(numHairs)
+    {
+      const size_t numVerticesPerHair = type.basis == BASIS_LINEAR ? 2 : 4;
+      const size_t width = (size_t) ceilf(sqrtf(float(numHairs)));
+      positions.resize(numHairs*numVerticesPerHair);
+      normals.resize(numHairs*numVerticesPerHair);
+      indices.resize(numHairs);
+      reference.resize(numHairs);
+
+      for (size_t i=0; i<numHairs; i++)
+      {
+        RandomSampler sampler;
+        RandomSampler_init(sampler,(int)i);
+        const float phi = float(2.0*M_PI)*RandomSampler_get1D(sampler);
+        const Vec3fa a(cosf(phi),0.0f,sinf(phi));
+        const Vec3fa b(-a.z,0.0f,a.x);
+        const Vec3fa root(float(i%width)*hair_spacing,0.0f,float(i/width)*hair_spacing);
+
+        Vec3fa v[4], n[4];
+        v[0] = root;
+        v[1] = root + Vec3fa(0.0f,1.0f/3.0f,0.0f) + curvature*a;
+        v[2] = root + Vec3fa(0.0f,2.0f/3.0f,0.0f) - 0.5f*curvature*a + 0.5f*curvature*b;
+        v[3] = root + Vec3fa(0.0f,1.0f,0.0f);
+        for (size_t j=0; j<4; j++) {
+          v[j].w = thickness*(1.0f-float(j)/6.0f);
+          n[j] = b;
+        }
+        if (type.basis == BASIS_LINEAR) {
+          v[1] = v[3]; n[1] = n[3];
+        }
+
+        for (size_t j=0; j<numVerticesPerHair; j++) {
+          positions[i*numVerticesPerHair+j] = v[j];
+          normals  [i*numVerticesPerHair+j] = n[j];
+        }
+        indices[i] = (unsigned int)(i*numVerticesPerHair);
+        reference[i] = ReferenceCurve(type.basis,v,n);
+      }
+    }
+
+    RTCScene createScene(const CurveType& type)
+    {
+      RTCScene scene = rtcNewScene(g_device);
+      RTCGeometry geom = rtcNewGeometry(g_device,type.type);
+      rtcSetGeometryTimeStepCount(geom,1);
+      rtcSetSharedGeometryBuffer(geom,RTC_BUFFER_TYPE_VERTEX,0,RTC_FORMAT_FLOAT4,positions.data(),0,sizeof(Vec3fa),positions.size());
+      rtcSetSharedGeometryBuffer(geom,RTC_BUFFER_TYPE_INDEX, 0,RTC_FORMAT_UINT,  indices.data(),  0,sizeof(unsigned int),indices.size());
+      if (type.shape == SHAPE_ORIENTED)
+        rtcSetSharedGeometryBuffer(geom,RTC_BUFFER_TYPE_NORMAL,0,RTC_FORMAT_FLOAT3,normals.data(),0,sizeof(Vec3fa),normals.size());
+      rtcCommitGeometry(geom);
+      rtcAttachGeometry(scene,geom);
+      rtcReleaseGeometry(geom);
+      rtcCommitScene(scene);
+      return scene;
+    }
+
+  public:
+    size_t numHairs;
+    avector<Vec3fa> positions;
+    avector<Vec3fa> normals;
+    std::vector<unsigned int> indices;
+    std::vector<ReferenceCurve> reference;
+  };
+
+  /* rays aimed at random points of random hairs, jittered so that some rays
+   * graze the silhouette or miss */
+  struct RaySet
+  {
+    RaySet (const HairSet& hairs, size_t numRays)
+      : org(numRays), dir(numRays), target(numRays)
+    {
+      for (size_t i=0; i<numRays; i++)
+      {
+        RandomSampler sampler;
+        RandomSampler_init(sampler,(int)i,0x1234);
+        const unsigned int h = RandomSampler_getUInt(sampler) % (unsigned int) hairs.numHairs;
+        const ReferenceCurve& curve = hairs.reference[h];
+        const double u = 0.05+0.9*RandomSampler_get1D(sampler);
+        Vec3d P, dPdu; double R; curve.eval(u,P,dPdu,R);
+
+        const Vec2f s = RandomSampler_get2D(sampler);
+        const float z = 1.0f-2.0f*s.x, rz = sqrtf(max(0.0f,1.0f-z*z)), phi = float(2.0*M_PI)*s.y;
+        const Vec3fa d(rz*cosf(phi),rz*sinf(phi),z);
+        Vec3fa dx, dy;
+        if (abs(d.x) < 0.5f) dx = normalize(cross(Vec3fa(1,0,0),d)); else dx = normalize(cross(Vec3fa(0,1,0),d));
+        dy = cross(d,dx);
+        const Vec2f j = RandomSampler_get2D(sampler);
+        const Vec3fa p = Vec3fa(float(P.x),float(P.y),float(P.z)) + float(3.0*R)*((j.x-0.5f)*dx + (j.y-0.5f)*dy);
+
+        org[i] = p - ray_distance*d;
+        dir[i] = d;
+        target[i] = h;
+      }
+    }
+
+    __forceinline void init(RTCRayHit& rayhit, size_t i) const
+    {
+      rayhit.ray.org_x = org[i].x; rayhit.ray.org_y = org[i].y; rayhit.ray.org_z = org[i].z;
+      rayhit.ray.dir_x = dir[i].x; rayhit.ray.dir_y = dir[i].y; rayhit.ray.dir_z = dir[i].z;
+      rayhit.ray.tnear = 0.0f;
+      rayhit.ray.tfar = inf;
+      rayhit.ray.time = 0.0f;
+      rayhit.ray.mask = -1;
+      rayhit.ray.flags = 0;
+      rayhit.hit.geomID = RTC_INVALID_GEOMETRY_ID;
+      rayhit.hit.primID = RTC_INVALID_GEOMETRY_ID;
+    }
+
+    template<int N>
+    __forceinline void init(RTCRayHitNt<N>& rayhit, int* valid, size_t i0, size_t i1) const
+    {
+      for (size_t k=0; k<N; k++)
+      {
+        const size_t i = min(i0+k,i1-1);
+        valid[k] = i0+k < i1 ? -1 : 0;
+        rayhit.ray.org_x[k] = org[i].x; rayhit.ray.org_y[k] = org[i].y; rayhit.ray.org_z[k] = org[i].z;
+        rayhit.ray.dir_x[k] = dir[i].x; rayhit.ray.dir_y[k] = dir[i].y; rayhit.ray.dir_z[k] = dir[i].z;
+        rayhit.ray.tnear[k] = 0.0f;
+        rayhit.ray.tfar[k] = inf;
+        rayhit.ray.time[k] = 0.0f;
+        rayhit.ray.mask[k] = -1;
+        rayhit.ray.flags[k] = 0;
+        rayhit.hit.geomID[k] = RTC_INVALID_GEOMETRY_ID;
+        rayhit.hit.primID[k] = RTC_INVALID_GEOMETRY_ID;
+      }
+    }
+
+  public:
+    avector<Vec3fa> org;
+    avector<Vec3fa> dir;
+    std::vector<unsigned int> target;
+  };
+
+  /* per ray result of the last benchmark iteration */
+  struct HitSet
+  {
+    HitSet (size_t numRays)
+      : t(numRays), primID(numRays) {}
+
+    std::vector<float> t;
+    std::vector<unsigned int> primID;
+  };
+
+  __forceinline void intersectN(const int* valid, RTCScene scene, RTCIntersectContext* context, RTCRayHitNt<4>* rayhit) {
+    rtcIntersect4(valid,scene,context,(RTCRayHit4*)rayhit);
+  }
+
+  __forceinline void intersectN(const int* valid, RTCScene scene, RTCIntersectContext* context, RTCRayHitNt<8>* rayhit) {
+    rtcIntersect8(valid,scene,context,(RTCRayHit8*)rayhit);
+  }
+
+  __forceinline void intersectN(const int* valid, RTCScene scene, RTCIntersectContext* context, RTCRayHitNt<16>* rayhit) {
+    rtcIntersect16(valid,scene,context,(RTCRayHit16*)rayhit);
+  }
+
+  void trace1(RTCScene scene, const RaySet& rays, HitSet& hits, size_t numRays)
+  {
+    parallel_for(size_t(0),numRays,size_t(4096),[&](const range<size_t>& r)
+    {
+      RTCIntersectContext context;
+      rtcInitIntersectContext(&context);
+      context.flags = g_iflags_incoherent;
+      for (size_t i=r.begin(); i<r.end(); i++)
+      {
+        RTCRayHit rayhit;
+        rays.init(rayhit,i);
+        rtcIntersect1(scene,&context,&rayhit);
+        hits.t[i] = rayhit.ray.tfar;
+        hits.primID[i] = rayhit.hit.geomID == RTC_INVALID_GEOMETRY_ID ? RTC_INVALID_GEOMETRY_ID : rayhit.hit.primID;
+      }
+    });
+  }
+
+  template<int N>
+  void traceN(RTCScene scene, const RaySet& rays, HitSet& hits, size_t numRays)
+  {
+    parallel_for(size_t(0),numRays,size_t(4096),[&](const range<size_t>& r)
+    {
+      RTCIntersectContext context;
+      rtcInitIntersectContext(&context);
+      context.flags = g_iflags_incoherent;
+      for (size_t i=r.begin(); i<r.end(); i+=N)
+      {
+        __aligned(64) RTCRayHitNt<N> rayhit;
+        __aligned(64) int valid[N];
+        rays.init(rayhit,valid,i,r.end());
+        intersectN(valid,scene,&context,&rayhit);
+        for (size_t k=0; k<N && i+k<r.end(); k++) {
+          hits.t[i+k] = rayhit.ray.tfar[k];
+          hits.primID[i+k] = rayhit.hit.geomID[k] == RTC_INVALID_GEOMETRY_ID ? RTC_INVALID_GEOMETRY_ID : rayhit.hit.primID[k];
+        }
+      }
+    });
+  }
+
+  /* reference hit distances for the first numReferenceRays rays, inf on miss */
+  std::vector<double> computeReference(const CurveType& type, const HairSet& hairs, const RaySet& rays, size_t numReferenceRays)
+  {
+    std::vector<double> t_ref(numReferenceRays);
+    parallel_for(size_t(0),numReferenceRays,size_t(64),[&](const range<size_t>& r)
+    {
+      for (size_t i=r.begin(); i<r.end(); i++)
+      {
+        double t = 0.0;
+        const ReferenceCurve& curve = hairs.reference[rays.target[i]];
+        if (reference_intersect(type,curve,toVec3d(rays.org[i]),toVec3d(rays.dir[i]),t)) t_ref[i] = t;
+        else t_ref[i] = std::numeric_limits<double>::infinity();
+      }
+    });
+    return t_ref;
+  }
+
+  typedef void (*TraceFunc)(RTCScene scene, const RaySet& rays, HitSet& hits, size_t numRays);
+
+  void Benchmark_Curve(const CurveType& type, const char* mode, TraceFunc trace, RTCScene scene,
+                       const HairSet& hairs, const RaySet& rays, const std::vector<double>& t_ref)
+  {
+    const size_t numRays = rays.org.size();
+    HitSet hits(numRays);
+
+    /* warmup */
+    trace(scene,rays,hits,numRays);
+
+    double time = 0.0;
+    for (int i=0; i<g_iterations; i++) {
+      double t0 = getSeconds();
+      trace(scene,rays,hits,numRays);
+      double t1 = getSeconds();
+      time += t1-t0;
+    }
+    time /= double(max(g_iterations,1));
+
+    size_t numHits = 0;
+    for (size_t i=0; i<numRays; i++)
+      numHits += hits.primID[i] != RTC_INVALID_GEOMETRY_ID;
+
+    /* compare against reference, relative to hair radius */
+    size_t numCompared = 0, numFalseHits = 0, numMissedHits = 0;
+    double sumError = 0.0, maxError = 0.0;
+    for (size_t i=0; i<t_ref.size(); i++)
+    {
+      const unsigned int h = rays.target[i];
+      const bool hit_ref = t_ref[i] != std::numeric_limits<double>::infinity();
+      const bool hit_other = hits.primID[i] != RTC_INVALID_GEOMETRY_ID && hits.primID[i] != h;
+      if (hit_other && (!hit_ref || hits.t[i] < t_ref[i])) continue; // occluded by other hair
+      const bool hit = hits.primID[i] == h;
+      if (hit && !hit_ref) { numFalseHits++; continue; }
+      if (!hit && hit_ref) { numMissedHits++; continue; }
+      if (!hit) continue;
+      const ReferenceCurve& curve = hairs.reference[h];
+      const double error = abs(double(hits.t[i])-t_ref[i])/curve.minRadius();
+      sumError += error;
+      maxError = max(maxError,error);
+      numCompared++;
+    }
+
+    std::cout << "BENCHMARK_" << type.name << "_" << mode << " "
+              << hairs.numHairs << " hairs, " << numRays << " rays, "
+              << time << " s, "
+              << 1.0 / time * numRays / 1000000.0 << " Mrays/s, "
+              << 100.0 * numHits / numRays << "% hits, "
+              << "error (in radii) avg " << (numCompared ? sumError/numCompared : 0.0) << " max " << maxError << ", "
+              << numFalseHits << " false hits, "
+              << numMissedHits << " missed hits" << std::endl;
+  }
+
+  /* called by the C++ code for initialization */
+  extern "C" void device_init (char* cfg)
+  {
+    const size_t numRays = max(g_num_rays,1);
+    const size_t numReferenceRays = min(size_t(max(g_num_reference_rays,0)),numRays);
+
+    std::cout << "curvature = " << g_curvature << ", thickness = " << g_thickness << std::endl;
+
+    /* packet widths the device does not trace natively get emulated with single rays, thus they are skipped */
+    const bool native4  = rtcGetDeviceProperty(g_device,RTC_DEVICE_PROPERTY_NATIVE_RAY4_SUPPORTED);
+    const bool native8  = rtcGetDeviceProperty(g_device,RTC_DEVICE_PROPERTY_NATIVE_RAY8_SUPPORTED);
+    const bool native16 = rtcGetDeviceProperty(g_device,RTC_DEVICE_PROPERTY_NATIVE_RAY16_SUPPORTED);
+
+    for (size_t i=0; i<sizeof(curve_types)/sizeof(CurveType); i++)
+    {
+      const CurveType& type = curve_types[i];
+      HairSet hairs(type,max(g_num_hairs,1),g_curvature,g_thickness);
+      RaySet rays(hairs,numRays);
+      RTCScene scene = hairs.createScene(type);
+      const std::vector<double> t_ref = computeReference(type,hairs,rays,numReferenceRays);
+
+      Benchmark_Curve(type,"INTERSECT1",trace1,scene,hairs,rays,t_ref);
+      if (native4)  Benchmark_Curve(type,"INTERSECT4",traceN<4>,scene,hairs,rays,t_ref);
+      if (native8)  Benchmark_Curve(type,"INTERSECT8",traceN<8>,scene,hairs,rays,t_ref);
+      if (native16) Benchmark_Curve(type,"INTERSECT16",traceN<16>,scene,hairs,rays,t_ref);
+
+      rtcReleaseScene(scene);
+    }
+  }
+
+  /* called by the C++ code to render */
+  extern "C" void device_render (int* pixels,
+                                 const unsigned int width,
+                                 const unsigned int height,
+                                 const float time,
+                                 const ISPCCamera& camera)
+  {
+  }
+
+  /* renders a single screen tile */
+  void renderTileStandard(int taskIndex,
+                          int threadIndex,
+                          int* pixels,
+                          const unsigned int width,
+                          const unsigned int height,
+                          const float time,
+                          const ISPCCamera& camera,
+                          const int numTilesX,
+                          const int numTilesY)
+  {
+  }
+
+  /* called by the C++ code for cleanup */
+  extern "C" void device_cleanup ()
+  {
+  }
+
+} // namespace embree
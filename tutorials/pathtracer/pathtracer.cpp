@@ -21,6 +21,9 @@ namespace embree
   extern "C" {
     int g_spp = 1;
     bool g_accumulate = 1;
+    bool g_wavefront = 0;
+    extern bool g_lighttree;
+    float g_adaptive = 0.0f;
   }
   
   struct Tutorial : public SceneLoadingTutorialApplication
@@ -35,6 +38,18 @@ namespace embree
       registerOption("accumulate", [] (Ref<ParseStream> cin, const FileName& path) {
           g_accumulate = cin->getInt();
         }, "--accumulate <bool>: accumulate samples (on by default)");
+
+      registerOption("wavefront", [] (Ref<ParseStream> cin, const FileName& path) {
+          g_wavefront = cin->getInt();
+        }, "--wavefront <bool>: traces all paths bounce by bounce using ray streams (C++ device only)");
+
+      registerOption("lighttree", [] (Ref<ParseStream> cin, const FileName& path) {
+          g_lighttree = cin->getInt();
+        }, "--lighttree <bool>: samples a single light per hit point from a light hierarchy (C++ device only)");
+
+      registerOption("adaptive", [] (Ref<ParseStream> cin, const FileName& path) {
+          g_adaptive = cin->getFloat();
+        }, "--adaptive <error>: renders more samples in noisy tiles and stops sampling tiles whose relative error is below <error> (C++ device only)");
     }
     
     void postParseCommandLine() 
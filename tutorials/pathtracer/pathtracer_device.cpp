@@ -20,6 +20,9 @@
 #include "../common/tutorial/tutorial_device.h"
 #include "../common/tutorial/scene_device.h"
 #include "../common/tutorial/optics.h"
+#include "../common/lights/light_tree.h"
+#include "../../common/algorithms/parallel_prefix_sum.h"
+#include "../../common/algorithms/parallel_sort.h"
 
 namespace embree {
 
@@ -496,11 +499,11 @@ Vec3fa MirrorMaterial__sample(ISPCMirrorMaterial* This, const BRDF& brdf, const
 void OBJMaterial__preprocess(ISPCOBJMaterial* material, BRDF& brdf, const Vec3fa& wo, const DifferentialGeometry& dg, const Medium& medium)
 {
     float d = material->d;
-    if (material->map_d) d *= getTextureTexel1f(material->map_d,dg.u,dg.v);
+    if (material->map_d) d *= getTextureTexel1f(material->map_d,dg.u,dg.v,dg.duvdx,dg.duvdy);
     brdf.Ka = Vec3fa(material->Ka);
     //if (material->map_Ka) { brdf.Ka *= material->map_Ka->get(dg.st); }
     brdf.Kd = d * Vec3fa(material->Kd);
-    if (material->map_Kd) brdf.Kd = brdf.Kd * getTextureTexel3f(material->map_Kd,dg.u,dg.v);
+    if (material->map_Kd) brdf.Kd = brdf.Kd * getTextureTexel3f(material->map_Kd,dg.u,dg.v,dg.duvdx,dg.duvdy);
     brdf.Ks = d * Vec3fa(material->Ks);
     //if (material->map_Ks) brdf.Ks *= material->map_Ks->get(dg.st);
     brdf.Ns = material->Ns;
@@ -864,6 +867,9 @@ extern "C" ISPCScene* g_ispc_scene;
 RTCScene g_scene = nullptr;
 extern "C" int g_spp;
 extern "C" bool g_accumulate;
+extern "C" bool g_wavefront;
+extern "C" bool g_lighttree;
+extern "C" float g_adaptive;
 
 /* occlusion filter function */
 void intersectionFilterReject(const RTCFilterFunctionNArguments* args);
@@ -997,6 +1003,16 @@ RTCScene convertScene(ISPCScene* scene_in)
     assignShaders(scene_in->geometries[i]);
   }
 
+  /* only the textures of OBJ materials get filtered lookups, thus only they need mip-map levels */
+  for (unsigned int i=0; i<scene_in->numMaterials; i++)
+  {
+    ISPCMaterial* material = scene_in->materials[i];
+    if (material->type != MATERIAL_OBJ) continue;
+    ISPCOBJMaterial* obj = (ISPCOBJMaterial*) material;
+    if (obj->map_d ) ((Texture*)obj->map_d )->createTexture2D();
+    if (obj->map_Kd) ((Texture*)obj->map_Kd)->createTexture2D();
+  }
+
   /* commit individual objects in case of instancing */
   if (g_instancing_mode != ISPC_INSTANCING_NONE)
   {
@@ -1103,6 +1119,64 @@ inline Vec3fa derivBSpline(const ISPCHairSet* mesh, const unsigned int primID, c
   return Vec3fa(n0*p00 + n1*p01 + n2*p02 + n3*p03);
 }
 
+/* change of the ray origin and direction from one pixel to the next, see Igehy, "Tracing Ray Differentials" */
+struct RayDifferential
+{
+  Vec3fa dOdx, dOdy;
+  Vec3fa dDdx, dDdy;
+};
+
+/* differentials of the primary ray through pixel (x,y) */
+inline RayDifferential cameraRayDifferential(const ISPCCamera& camera, float x, float y)
+{
+  const Vec3fa d = x*camera.xfm.l.vx + y*camera.xfm.l.vy + camera.xfm.l.vz;
+  const float dd = dot(d,d);
+  const float invLen3 = rsqrt(dd)/dd;
+  RayDifferential rd;
+  rd.dOdx = rd.dOdy = Vec3fa(0.0f);
+  rd.dDdx = (dd*camera.xfm.l.vx - dot(d,camera.xfm.l.vx)*d)*invLen3;
+  rd.dDdy = (dd*camera.xfm.l.vy - dot(d,camera.xfm.l.vy)*d)*invLen3;
+  return rd;
+}
+
+/* differentials of a secondary ray, the footprint of the previous hit is kept and does not grow further */
+inline RayDifferential secondaryRayDifferential(const DifferentialGeometry& dg)
+{
+  RayDifferential rd;
+  rd.dOdx = dg.dPdx; rd.dOdy = dg.dPdy;
+  rd.dDdx = rd.dDdy = Vec3fa(0.0f);
+  return rd;
+}
+
+/* transfers the ray differentials to the plane of the hit, D and N have to be in the same space as the differentials */
+inline void transferRayDifferential(const RayDifferential& rd, const Vec3fa& D, const Vec3fa& N, float t, DifferentialGeometry& dg)
+{
+  const float DN = dot(D,N);
+  if (abs(DN) < 1E-12f) return;
+  const Vec3fa dPdx = rd.dOdx + t*rd.dDdx;
+  const Vec3fa dPdy = rd.dOdy + t*rd.dDdy;
+  dg.dPdx = dPdx - (dot(dPdx,N)/DN)*D;
+  dg.dPdy = dPdy - (dot(dPdy,N)/DN)*D;
+}
+
+/* expresses the position differentials in the triangle (p0,p1,p2) to get the texture coordinate differentials */
+inline void textureDifferentials(DifferentialGeometry& dg,
+                                 const Vec3fa& p0, const Vec3fa& p1, const Vec3fa& p2,
+                                 const Vec2f& st0, const Vec2f& st1, const Vec2f& st2)
+{
+  const Vec3fa e1 = p1-p0, e2 = p2-p0;
+  const float a11 = dot(e1,e1), a12 = dot(e1,e2), a22 = dot(e2,e2);
+  const float det = a11*a22-a12*a12;
+  if (det <= 0.0f) return;
+  const float rcpDet = 1.0f/det;
+  const Vec2f dst1 = st1-st0, dst2 = st2-st0;
+
+  const float bx1 = dot(e1,dg.dPdx), bx2 = dot(e2,dg.dPdx);
+  dg.duvdx = ((a22*bx1-a12*bx2)*rcpDet)*dst1 + ((a11*bx2-a12*bx1)*rcpDet)*dst2;
+  const float by1 = dot(e1,dg.dPdy), by2 = dot(e2,dg.dPdy);
+  dg.duvdy = ((a22*by1-a12*by2)*rcpDet)*dst1 + ((a11*by2-a12*by1)*rcpDet)*dst2;
+}
+
 void postIntersectGeometry(const Ray& ray, DifferentialGeometry& dg, ISPCGeometry* geometry, int& materialID)
 {
   if (geometry->type == TRIANGLE_MESH)
@@ -1119,6 +1193,7 @@ void postIntersectGeometry(const Ray& ray, DifferentialGeometry& dg, ISPCGeometr
       const Vec2f st = w*st0 + u*st1 + v*st2;
       dg.u = st.x;
       dg.v = st.y;
+      textureDifferentials(dg,mesh->positions[0][tri->v0],mesh->positions[0][tri->v1],mesh->positions[0][tri->v2],st0,st1,st2);
     }
     if (mesh->normals)
     {
@@ -1168,11 +1243,13 @@ void postIntersectGeometry(const Ray& ray, DifferentialGeometry& dg, ISPCGeometr
         const Vec2f st = w*st0 + u*st1 + v*st3;
         dg.u = st.x;
         dg.v = st.y;
+        textureDifferentials(dg,mesh->positions[0][quad->v0],mesh->positions[0][quad->v1],mesh->positions[0][quad->v3],st0,st1,st3);
       } else {
         const float u = 1.0f-ray.u, v = 1.0f-ray.v; const float w = 1.0f-u-v;
         const Vec2f st = w*st2 + u*st3 + v*st1;
         dg.u = st.x;
         dg.v = st.y;
+        textureDifferentials(dg,mesh->positions[0][quad->v2],mesh->positions[0][quad->v3],mesh->positions[0][quad->v1],st2,st3,st1);
       }
     }
     if (mesh->normals)
@@ -1315,9 +1392,26 @@ AffineSpace3fa calculate_interpolated_space (ISPCInstance* instance, float gtime
 
 typedef ISPCInstance* ISPCInstancePtr;
 
-inline int postIntersect(const Ray& ray, DifferentialGeometry& dg)
+/* computes the differential geometry of the hit, the texture coordinate
+ * differentials are only computed when the ray differentials are given */
+inline int postIntersect(const Ray& ray, DifferentialGeometry& dg, const RayDifferential* rd = nullptr)
 {
   dg.eps = 32.0f*1.19209e-07f*max(max(abs(dg.P.x),abs(dg.P.y)),max(abs(dg.P.z),ray.tfar));
+  dg.dPdx = dg.dPdy = Vec3fa(0.0f);
+  dg.duvdx = dg.duvdy = Vec2f(0.0f);
+
+  /* the geometry normal of instanced hits is in object space, thus transfer the differentials there */
+  if (rd && g_instancing_mode == ISPC_INSTANCING_NONE)
+    transferRayDifferential(*rd,ray.dir,ray.Ng,ray.tfar,dg);
+  else if (rd)
+  {
+    ISPCInstance* instance = (ISPCInstancePtr) g_ispc_scene->geometries[dg.instID];
+    const AffineSpace3fa world2object = rcp(calculate_interpolated_space(instance,ray.time()));
+    RayDifferential rdo;
+    rdo.dOdx = xfmVector(world2object,rd->dOdx); rdo.dOdy = xfmVector(world2object,rd->dOdy);
+    rdo.dDdx = xfmVector(world2object,rd->dDdx); rdo.dDdy = xfmVector(world2object,rd->dDdy);
+    transferRayDifferential(rdo,xfmVector(world2object,ray.dir),ray.Ng,ray.tfar,dg);
+  }
 
   int materialID = 0;
   unsigned int instID = dg.instID; {
@@ -1345,6 +1439,8 @@ inline int postIntersect(const Ray& ray, DifferentialGeometry& dg)
       AffineSpace3fa space = calculate_interpolated_space(instance,ray.time());
       dg.Ng = xfmVector(space,dg.Ng);
       dg.Ns = xfmVector(space,dg.Ns);
+      dg.dPdx = xfmVector(space,dg.dPdx);
+      dg.dPdy = xfmVector(space,dg.dPdy);
     }
   }
 
@@ -1358,61 +1454,55 @@ void intersectionFilterReject(const RTCFilterFunctionNArguments* args)
   if (!valid) return;
 }
 
+/* returns the ray and the hit passed to a filter function, ray streams pass multiple rays */
+inline Ray getFilterRay(const RTCFilterFunctionNArguments* args, unsigned int rayID)
+{
+  RTCRayHit rayhit;
+  rayhit.ray = rtcGetRayFromRayN(args->ray,args->N,rayID);
+  rayhit.hit = rtcGetHitFromHitN(args->hit,args->N,rayID);
+  return *(Ray*)&rayhit;
+}
+
 void intersectionFilterOBJ(const RTCFilterFunctionNArguments* args)
 {
   int* valid_i = args->valid;
-  struct RTCRayHitN* _ray = (struct RTCRayHitN*)args->ray;
-  struct RTCHitN* hit = args->hit;
   const unsigned int N = args->N;
-  
-  assert(N == 1);
-  bool valid = *((int*) valid_i);
-  if (!valid) return;
-  
-  const unsigned int rayID = 0;
-  Ray *ray = (Ray*)_ray;
-
-  /* compute differential geometry */
-  //const float tfar          = RTCHitN_t(hit,N,rayID);
-  const float tfar          = ray->tfar;
-  DifferentialGeometry dg;
-  dg.instID = RTCHitN_instID(hit,N,rayID,0);
-  dg.geomID = RTCHitN_geomID(hit,N,rayID);
-  dg.primID = RTCHitN_primID(hit,N,rayID);
-  dg.u = RTCHitN_u(hit,N,rayID);
-  dg.v = RTCHitN_v(hit,N,rayID);
-  Vec3fa Ng = Vec3fa(RTCHitN_Ng_x(hit,N,rayID),
-                        RTCHitN_Ng_y(hit,N,rayID),
-                        RTCHitN_Ng_z(hit,N,rayID));
-  dg.P  = ray->org+tfar*ray->dir;
-  dg.Ng = Ng;
-  dg.Ns = Ng;
-  int materialID = postIntersect(*ray,dg);
-  dg.Ng = face_forward(ray->dir,normalize(dg.Ng));
-  if (length(dg.Ns) < 1E-6f) dg.Ns = dg.Ng;
-  else dg.Ns = face_forward(ray->dir,normalize(dg.Ns));
-  const Vec3fa wo = neg(ray->dir);
 
-  /* calculate BRDF */
-  BRDF brdf; brdf.Kt = Vec3fa(0,0,0);
-  int numMaterials = g_ispc_scene->numMaterials;
-  ISPCMaterial** material_array = &g_ispc_scene->materials[0];
-  Medium medium = make_Medium_Vacuum();
-  Material__preprocess(material_array,materialID,numMaterials,brdf,wo,dg,medium);
-  if (min(min(brdf.Kt.x,brdf.Kt.y),brdf.Kt.z) < 1.0f)
+  for (unsigned int rayID=0; rayID<N; rayID++)
   {
-    ray->tfar   = tfar;
-    // ray->instID = dg.instID;
-    // ray->geomID = dg.geomID;
-    // ray->primID = dg.primID;    
-    // ray->u      = dg.u;
-    // ray->v      = dg.v;
-    // ray->Ng     = Ng;
+    bool valid = valid_i[rayID];
+    if (!valid) continue;
+
+    Ray ray = getFilterRay(args,rayID);
+
+    /* compute differential geometry */
+    DifferentialGeometry dg;
+    dg.instID = ray.instID;
+    dg.geomID = ray.geomID;
+    dg.primID = ray.primID;
+    dg.u = ray.u;
+    dg.v = ray.v;
+    dg.P  = ray.org+ray.tfar*ray.dir;
+    dg.Ng = Vec3fa(ray.Ng);
+    dg.Ns = Vec3fa(ray.Ng);
+    int materialID = postIntersect(ray,dg);
+    dg.Ng = face_forward(ray.dir,normalize(dg.Ng));
+    if (length(dg.Ns) < 1E-6f) dg.Ns = dg.Ng;
+    else dg.Ns = face_forward(ray.dir,normalize(dg.Ns));
+    const Vec3fa wo = neg(ray.dir);
+
+    /* calculate BRDF */
+    BRDF brdf; brdf.Kt = Vec3fa(0,0,0);
+    int numMaterials = g_ispc_scene->numMaterials;
+    ISPCMaterial** material_array = &g_ispc_scene->materials[0];
+    Medium medium = make_Medium_Vacuum();
+    Material__preprocess(material_array,materialID,numMaterials,brdf,wo,dg,medium);
+    if (min(min(brdf.Kt.x,brdf.Kt.y),brdf.Kt.z) >= 1.0f)
+      valid_i[rayID] = 0;
   }
-  else
-    valid_i[0] = 0;
 }
 
+/* the transparency of each shadow ray is passed through the context and indexed by the ray ID */
 void occlusionFilterOpaque(const RTCFilterFunctionNArguments* args)
 {
   IntersectContext* context = (IntersectContext*) args->context;
@@ -1420,12 +1510,15 @@ void occlusionFilterOpaque(const RTCFilterFunctionNArguments* args)
   if (!transparency) return;
   
   int* valid_i = args->valid;
-  
-  assert(args->N == 1);
-  bool valid = *((int*) valid_i);
-  if (!valid) return;
+  const unsigned int N = args->N;
+
+  for (unsigned int rayID=0; rayID<N; rayID++)
+  {
+    bool valid = valid_i[rayID];
+    if (!valid) continue;
    
-  *transparency = Vec3fa(0.0f);
+    transparency[RTCRayN_id(args->ray,N,rayID)] = Vec3fa(0.0f);
+  }
 }
 
 void occlusionFilterOBJ(const RTCFilterFunctionNArguments* args)
@@ -1435,49 +1528,43 @@ void occlusionFilterOBJ(const RTCFilterFunctionNArguments* args)
   if (!transparency) return;
   
   int* valid_i = args->valid;
-  struct RTCRayHitN* _ray = (struct RTCRayHitN*)args->ray;
-  struct RTCHitN* hit = args->hit;
   const unsigned int N = args->N;
   
-  assert(N == 1);
-  bool valid = *((int*) valid_i);
-  if (!valid) return;
+  for (unsigned int rayID=0; rayID<N; rayID++)
+  {
+    bool valid = valid_i[rayID];
+    if (!valid) continue;
   
-  const unsigned int rayID = 0;
-  Ray *ray = (Ray*)_ray;
+    Ray ray = getFilterRay(args,rayID);
 
-  /* compute differential geometry */
-  //const float tfar          = RTCHitN_t(hit,N,rayID);
-  const float tfar          = ray->tfar;
+    /* compute differential geometry */
+    DifferentialGeometry dg;
+    dg.instID = ray.instID;
+    dg.geomID = ray.geomID;
+    dg.primID = ray.primID;
+    dg.u = ray.u;
+    dg.v = ray.v;
+    dg.P  = ray.org+ray.tfar*ray.dir;
+    dg.Ng = Vec3fa(ray.Ng);
+    dg.Ns = Vec3fa(ray.Ng);
 
-  DifferentialGeometry dg;
-  dg.instID = RTCHitN_instID(hit,N,rayID,0);
-  dg.geomID = RTCHitN_geomID(hit,N,rayID);
-  dg.primID = RTCHitN_primID(hit,N,rayID);
-  dg.u = RTCHitN_u(hit,N,rayID);
-  dg.v = RTCHitN_v(hit,N,rayID);
-  Vec3fa Ng = Vec3fa(RTCHitN_Ng_x(hit,N,rayID),
-                        RTCHitN_Ng_y(hit,N,rayID),
-                        RTCHitN_Ng_z(hit,N,rayID));
-  dg.P  = ray->org+tfar*ray->dir;
-  dg.Ng = Ng;
-  dg.Ns = Ng;
-
-  int materialID = postIntersect(*ray,dg);
-  dg.Ng = face_forward(ray->dir,normalize(dg.Ng));
-  dg.Ns = face_forward(ray->dir,normalize(dg.Ns));
-  const Vec3fa wo = neg(ray->dir);
+    int materialID = postIntersect(ray,dg);
+    dg.Ng = face_forward(ray.dir,normalize(dg.Ng));
+    dg.Ns = face_forward(ray.dir,normalize(dg.Ns));
+    const Vec3fa wo = neg(ray.dir);
 
-  /* calculate BRDF */
-  BRDF brdf; brdf.Kt = Vec3fa(0,0,0);
-  int numMaterials = g_ispc_scene->numMaterials;
-  ISPCMaterial** material_array = &g_ispc_scene->materials[0];
-  Medium medium = make_Medium_Vacuum();
-  Material__preprocess(material_array,materialID,numMaterials,brdf,wo,dg,medium);
+    /* calculate BRDF */
+    BRDF brdf; brdf.Kt = Vec3fa(0,0,0);
+    int numMaterials = g_ispc_scene->numMaterials;
+    ISPCMaterial** material_array = &g_ispc_scene->materials[0];
+    Medium medium = make_Medium_Vacuum();
+    Material__preprocess(material_array,materialID,numMaterials,brdf,wo,dg,medium);
 
-  *transparency = *transparency * brdf.Kt;
-  if (max(max(transparency->x,transparency->y),transparency->z) > 0.0f)
-    valid_i[0] = 0;
+    Vec3fa& T = transparency[ray.id];
+    T = T * brdf.Kt;
+    if (max(max(T.x,T.y),T.z) > 0.0f)
+      valid_i[rayID] = 0;
+  }
 }
 
 /* occlusion filter function */
@@ -1491,32 +1578,81 @@ void occlusionFilterHair(const RTCFilterFunctionNArguments* args)
   struct RTCHitN* hit = args->hit;
   const unsigned int N = args->N;
   
-  assert(N == 1);
-  bool valid = *((int*) valid_i);
-  if (!valid) return;
-  
-  const unsigned int rayID = 0;
-  
-  unsigned int hit_geomID = RTCHitN_geomID(hit,N,rayID);
-  Vec3fa Kt = Vec3fa(0.0f);
-  unsigned int geomID = hit_geomID;
+  for (unsigned int rayID=0; rayID<N; rayID++)
   {
-    ISPCGeometry* geometry = g_ispc_scene->geometries[geomID];
-    if (geometry->type == CURVES)
+    bool valid = valid_i[rayID];
+    if (!valid) continue;
+  
+    unsigned int hit_geomID = RTCHitN_geomID(hit,N,rayID);
+    Vec3fa Kt = Vec3fa(0.0f);
+    unsigned int geomID = hit_geomID;
     {
-      int materialID = ((ISPCHairSet*)geometry)->geom.materialID;
-      ISPCMaterial* material = g_ispc_scene->materials[materialID];
-      switch (material->type) {
-      case MATERIAL_HAIR: Kt = Vec3fa(((ISPCHairMaterial*)material)->Kt); break;
-      default: break;
+      ISPCGeometry* geometry = g_ispc_scene->geometries[geomID];
+      if (geometry->type == CURVES)
+      {
+        int materialID = ((ISPCHairSet*)geometry)->geom.materialID;
+        ISPCMaterial* material = g_ispc_scene->materials[materialID];
+        switch (material->type) {
+        case MATERIAL_HAIR: Kt = Vec3fa(((ISPCHairMaterial*)material)->Kt); break;
+        default: break;
+        }
       }
     }
+
+    Vec3fa& T = transparency[RTCRayN_id(args->ray,N,rayID)];
+    T = Kt * T;
+    if (max(max(T.x,T.y),T.z) > 0.0f)
+      valid_i[rayID] = 0;
+  }
+}
+
+/* the light tree samples one of the lights that have a position, the other lights get sampled individually */
+LightTree* g_light_tree = nullptr;
+
+/* returns the number of light samples taken at each hit point */
+inline unsigned int getNumLightSamples()
+{
+  if (!g_light_tree) return g_ispc_scene->numLights;
+  return unsigned(g_light_tree->infiniteLights.size()) + (g_light_tree->empty() ? 0 : 1);
+}
+
+/* takes the i'th light sample of a hit point */
+inline Light_SampleRes sampleLight(unsigned int i, const DifferentialGeometry& dg, RandomSampler& sampler)
+{
+  if (!g_light_tree) {
+    const Light* l = g_ispc_scene->lights[i];
+    return l->sample(l,dg,RandomSampler_get2D(sampler));
   }
 
-  Kt = Kt * *transparency;
-  *transparency = Kt;
-  if (max(max(transparency->x,transparency->y),transparency->z) > 0.0f)
-    valid_i[0] = 0;
+  if (i < g_light_tree->infiniteLights.size()) {
+    const Light* l = g_ispc_scene->lights[g_light_tree->infiniteLights[i]];
+    return l->sample(l,dg,RandomSampler_get2D(sampler));
+  }
+
+  const Vec2f s = RandomSampler_get2D(sampler);
+  float pmf = 0.0f;
+  const int lightID = g_light_tree->sample(dg.P,RandomSampler_get1D(sampler),pmf);
+  if (lightID < 0) {
+    Light_SampleRes ls;
+    ls.weight = Vec3fa(0.0f); ls.dir = Vec3fa(0.0f,0.0f,1.0f); ls.dist = 0.0f; ls.pdf = 0.0f;
+    return ls;
+  }
+  const Light* l = g_ispc_scene->lights[lightID];
+  Light_SampleRes ls = l->sample(l,dg,s);
+  ls.weight = ls.weight*rcp(pmf);
+  ls.pdf *= pmf;
+  return ls;
+}
+
+/* adds the light arriving along rays that hit nothing, finite lights with an extent can be hit too, thus all lights get evaluated */
+inline void addEnvironmentLights(Vec3fa& L, const Vec3fa& Lw, const DifferentialGeometry& dg, const Vec3fa& dir)
+{
+  for (unsigned int i=0; i<g_ispc_scene->numLights; i++)
+  {
+    const Light* l = g_ispc_scene->lights[i];
+    Light_EvalRes le = l->eval(l,dg,dir);
+    L = L + Lw*le.value;
+  }
 }
 
 Vec3fa renderPixelFunction(float x, float y, RandomSampler& sampler, const ISPCCamera& camera, RayStats& stats)
@@ -1530,6 +1666,7 @@ Vec3fa renderPixelFunction(float x, float y, RandomSampler& sampler, const ISPCC
   /* initialize ray */
   Ray ray(Vec3fa(camera.xfm.p),
                      Vec3fa(normalize(x*camera.xfm.l.vx + y*camera.xfm.l.vy + camera.xfm.l.vz)),0.0f,inf,time);
+  RayDifferential rd = cameraRayDifferential(camera,x,y);
 
   DifferentialGeometry dg;
  
@@ -1554,13 +1691,7 @@ Vec3fa renderPixelFunction(float x, float y, RandomSampler& sampler, const ISPCC
       //L = L + Lw*Vec3fa(1.0f);
 
       /* iterate over all lights */
-      for (unsigned int i=0; i<g_ispc_scene->numLights; i++)
-      {
-        const Light* l = g_ispc_scene->lights[i];
-        Light_EvalRes le = l->eval(l,dg,ray.dir);
-        L = L + Lw*le.value;
-      }
-
+      addEnvironmentLights(L,Lw,dg,ray.dir);
       break;
     }
 
@@ -1575,7 +1706,7 @@ Vec3fa renderPixelFunction(float x, float y, RandomSampler& sampler, const ISPCC
     dg.P  = ray.org+ray.tfar*ray.dir;
     dg.Ng = ray.Ng;
     dg.Ns = Ns;
-    int materialID = postIntersect(ray,dg);
+    int materialID = postIntersect(ray,dg,&rd);
     dg.Ng = face_forward(ray.dir,normalize(dg.Ng));
     dg.Ns = face_forward(ray.dir,normalize(dg.Ns));
 
@@ -1597,13 +1728,14 @@ Vec3fa renderPixelFunction(float x, float y, RandomSampler& sampler, const ISPCC
 
     /* iterate over lights */
     context.context.flags = g_iflags_incoherent;
-    for (unsigned int i=0; i<g_ispc_scene->numLights; i++)
+    const unsigned int numLightSamples = getNumLightSamples();
+    for (unsigned int i=0; i<numLightSamples; i++)
     {
-      const Light* l = g_ispc_scene->lights[i];
-      Light_SampleRes ls = l->sample(l,dg,RandomSampler_get2D(sampler));
+      Light_SampleRes ls = sampleLight(i,dg,sampler);
       if (ls.pdf <= 0.0f) continue;
       Vec3fa transparency = Vec3fa(1.0f);
       Ray shadow(dg.P,ls.dir,dg.eps,ls.dist,time);
+      shadow.id = 0; // indexes the transparency in the filter functions
       context.userRayExt = &transparency;
       rtcOccluded1(g_scene,&context.context,RTCRay_(shadow));
       RayStats_addShadowRay(stats);
@@ -1619,6 +1751,7 @@ Vec3fa renderPixelFunction(float x, float y, RandomSampler& sampler, const ISPCC
     float sign = dot(wi1.v,dg.Ng) < 0.0f ? -1.0f : 1.0f;
     dg.P = dg.P + sign*dg.eps*dg.Ng;
     init_Ray(ray, dg.P,normalize(wi1.v),dg.eps,inf,time);
+    rd = secondaryRayDifferential(dg);
   }
   return L;
 }
@@ -1689,6 +1822,509 @@ void renderTileTask (int taskIndex, int threadIndex, int* pixels,
 }
 
 
+/***************************************************************************************/
+/*                             Adaptive Sampling                                       */
+/***************************************************************************************/
+
+/* The adaptive mode estimates the error of each tile from the variance
+ * of the samples accumulated over the progressive frames. Tiles get
+ * more samples per frame the noisier they are, and tiles whose error
+ * dropped below g_adaptive are not sampled any further. Noisy tiles
+ * are scheduled first, thus their longer render time overlaps with the
+ * cheap tiles. */
+
+#define ADAPTIVE_MIN_SAMPLES 16 // samples per pixel before the error estimate of a tile is trusted
+#define ADAPTIVE_MAX_SCALE   4  // noisy tiles get up to this many times g_spp samples per frame
+#define ADAPTIVE_BLACK_LEVEL 0.05f // error of darker pixels is measured relative to this level
+
+std::vector<float> g_accu2;              //!< per pixel sum of the squared luminance of all samples
+std::vector<float> g_tile_error;         //!< estimated relative error of each tile
+std::vector<unsigned int> g_tile_samples; //!< samples per pixel accumulated in each tile
+std::vector<unsigned int> g_tile_order;  //!< tiles in the order they get rendered
+bool g_adaptive_converged = false;
+
+inline float luminance(const Vec3fa& c) {
+  return (c.x+c.y+c.z)*(1.0f/3.0f);
+}
+
+/* renders spp additional samples for each pixel of the tile, or only
+ * updates the framebuffer for spp == 0 */
+void renderTileAdaptive(int taskIndex,
+                        int threadIndex,
+                        int* pixels,
+                        const unsigned int width,
+                        const unsigned int height,
+                        const ISPCCamera& camera,
+                        const int numTilesX,
+                        const unsigned int spp)
+{
+  const unsigned int tileY = taskIndex / numTilesX;
+  const unsigned int tileX = taskIndex - tileY * numTilesX;
+  const unsigned int x0 = tileX * TILE_SIZE_X;
+  const unsigned int x1 = min(x0+TILE_SIZE_X,width);
+  const unsigned int y0 = tileY * TILE_SIZE_Y;
+  const unsigned int y1 = min(y0+TILE_SIZE_Y,height);
+  const unsigned int sample0 = g_tile_samples[taskIndex];
+  RandomSampler sampler;
+  float error = 0.0f;
+
+  for (unsigned int y=y0; y<y1; y++) for (unsigned int x=x0; x<x1; x++)
+  {
+    /* calculate pixel color, the random sequence continues where the previous frame stopped */
+    Vec3fa L = Vec3fa(0.0f);
+    float L2 = 0.0f;
+    for (unsigned int i=0; i<spp; i++)
+    {
+      RandomSampler_init(sampler, (int)x, (int)y, sample0+i);
+      float fx = x + RandomSampler_get1D(sampler);
+      float fy = y + RandomSampler_get1D(sampler);
+      const Vec3fa c = renderPixelFunction(fx,fy,sampler,camera,g_stats[threadIndex]);
+      L = L + c;
+      L2 += sqr(luminance(c));
+    }
+
+    /* write color to framebuffer */
+    Vec3fa accu_color = g_accu[y*width+x] + Vec3fa(L.x,L.y,L.z,(float)spp); g_accu[y*width+x] = accu_color;
+    const float accu2 = g_accu2[y*width+x] += L2;
+    float f = rcp(max(0.001f,accu_color.w));
+    unsigned int r = (unsigned int) (255.01f * clamp(accu_color.x*f,0.0f,1.0f));
+    unsigned int g = (unsigned int) (255.01f * clamp(accu_color.y*f,0.0f,1.0f));
+    unsigned int b = (unsigned int) (255.01f * clamp(accu_color.z*f,0.0f,1.0f));
+    pixels[y*width+x] = (b << 16) + (g << 8) + r;
+
+    /* standard error of the mean luminance of the pixel */
+    const float n = accu_color.w;
+    const float mean = luminance(accu_color)*f;
+    const float var = max(0.0f,accu2*f-sqr(mean))*n/max(1.0f,n-1.0f);
+    error += sqrt(var*f)/max(mean,ADAPTIVE_BLACK_LEVEL);
+  }
+
+  if (spp == 0) return;
+  g_tile_samples[taskIndex] = sample0+spp;
+  g_tile_error[taskIndex] = error/float((x1-x0)*(y1-y0));
+}
+
+/* returns the number of samples per pixel to render in the tile in this frame */
+inline unsigned int adaptiveSamples(unsigned int tile)
+{
+  if (g_tile_samples[tile] < ADAPTIVE_MIN_SAMPLES) return g_spp;
+  const float scale = g_tile_error[tile]/g_adaptive;
+  if (scale < 1.0f) return 0;
+  return g_spp*(unsigned int)min(scale,(float)ADAPTIVE_MAX_SCALE);
+}
+
+void renderFrameAdaptive (int* pixels,
+                          const unsigned int width,
+                          const unsigned int height,
+                          const ISPCCamera& camera)
+{
+  const int numTilesX = (width +TILE_SIZE_X-1)/TILE_SIZE_X;
+  const int numTilesY = (height+TILE_SIZE_Y-1)/TILE_SIZE_Y;
+  const size_t numTiles = size_t(numTilesX*numTilesY);
+
+  /* the accumulation buffer got cleared */
+  if (g_accu_count == 0 || g_tile_error.size() != numTiles || g_accu2.size() != size_t(width)*height)
+  {
+    g_accu2.assign(size_t(width)*height,0.0f);
+    g_tile_error.assign(numTiles,float(inf));
+    g_tile_samples.assign(numTiles,0);
+    g_tile_order.resize(numTiles);
+    g_adaptive_converged = false;
+  }
+
+  /* render the noisiest tiles first, converged tiles only update the framebuffer */
+  for (size_t i=0; i<numTiles; i++) g_tile_order[i] = (unsigned int) i;
+  std::sort(g_tile_order.begin(),g_tile_order.end(),[] (unsigned int a, unsigned int b) {
+      return g_tile_error[a] > g_tile_error[b];
+    });
+
+  bool converged = true;
+  for (size_t i=0; i<numTiles; i++) converged &= adaptiveSamples((unsigned int)i) == 0;
+  if (converged && !g_adaptive_converged)
+    std::cout << "adaptive sampling converged after " << g_accu_count << " frames" << std::endl;
+  g_adaptive_converged = converged;
+
+  parallel_for(size_t(0),numTiles,size_t(1),[&](const range<size_t>& range) {
+    const int threadIndex = (int)TaskScheduler::threadIndex();
+    for (size_t i=range.begin(); i<range.end(); i++) {
+      const unsigned int tile = g_tile_order[i];
+      renderTileAdaptive((int)tile,threadIndex,pixels,width,height,camera,numTilesX,adaptiveSamples(tile));
+    }
+  });
+}
+
+
+/***************************************************************************************/
+/*                             Wavefront Path Tracer                                   */
+/***************************************************************************************/
+
+/* The wavefront path tracer advances all paths of a batch of pixels
+ * bounce by bounce. Each bounce traces the rays of all active paths
+ * and their shadow rays as large ray streams, which exercises the
+ * stream traversal of the library. Paths are sorted by material
+ * before shading and terminated paths get compacted away. Each path
+ * consumes its random numbers in the same order as the depth first
+ * path tracer, thus both modes render the same image. */
+
+#define WAVEFRONT_MAX_PATHS   (64*1024) // maximal number of paths in flight
+#define WAVEFRONT_STREAM_SIZE 1024      // number of rays traced by a single stream call
+
+/* ray stream in SoA layout as expected by rtcIntersectNp and rtcOccludedNp */
+struct RayStreamSoA
+{
+  void resize(size_t N)
+  {
+    if (N <= org_x.size()) return;
+    org_x.resize(N); org_y.resize(N); org_z.resize(N); tnear.resize(N);
+    dir_x.resize(N); dir_y.resize(N); dir_z.resize(N); time.resize(N);
+    tfar.resize(N); mask.resize(N); id.resize(N); flags.resize(N);
+    Ng_x.resize(N); Ng_y.resize(N); Ng_z.resize(N); u.resize(N); v.resize(N);
+    primID.resize(N); geomID.resize(N); instID.resize(N);
+  }
+
+  __forceinline void set(size_t i, const Ray& ray)
+  {
+    org_x[i] = ray.org.x; org_y[i] = ray.org.y; org_z[i] = ray.org.z; tnear[i] = ray.tnear();
+    dir_x[i] = ray.dir.x; dir_y[i] = ray.dir.y; dir_z[i] = ray.dir.z; time[i] = ray.time();
+    tfar[i] = ray.tfar; mask[i] = ray.mask; id[i] = ray.id; flags[i] = ray.flags;
+    geomID[i] = ray.geomID; primID[i] = ray.primID; instID[i] = ray.instID;
+  }
+
+  __forceinline Ray get(size_t i) const
+  {
+    Ray ray(Vec3fa(org_x[i],org_y[i],org_z[i]),Vec3fa(dir_x[i],dir_y[i],dir_z[i]),tnear[i],tfar[i],time[i],mask[i],geomID[i],primID[i],instID[i]);
+    ray.id = id[i]; ray.flags = flags[i];
+    ray.Ng = Vec3f(Ng_x[i],Ng_y[i],Ng_z[i]); ray.u = u[i]; ray.v = v[i];
+    return ray;
+  }
+
+  /* returns the stream pointers starting at ray i */
+  RTCRayHitNp rayhit(size_t i)
+  {
+    RTCRayHitNp rh;
+    rh.ray.org_x = &org_x[i]; rh.ray.org_y = &org_y[i]; rh.ray.org_z = &org_z[i]; rh.ray.tnear = &tnear[i];
+    rh.ray.dir_x = &dir_x[i]; rh.ray.dir_y = &dir_y[i]; rh.ray.dir_z = &dir_z[i]; rh.ray.time = &time[i];
+    rh.ray.tfar = &tfar[i]; rh.ray.mask = &mask[i]; rh.ray.id = &id[i]; rh.ray.flags = &flags[i];
+    rh.hit.Ng_x = &Ng_x[i]; rh.hit.Ng_y = &Ng_y[i]; rh.hit.Ng_z = &Ng_z[i]; rh.hit.u = &u[i]; rh.hit.v = &v[i];
+    rh.hit.primID = &primID[i]; rh.hit.geomID = &geomID[i]; rh.hit.instID[0] = &instID[i];
+    return rh;
+  }
+
+  std::vector<float> org_x, org_y, org_z, tnear;
+  std::vector<float> dir_x, dir_y, dir_z, time;
+  std::vector<float> tfar;
+  std::vector<unsigned int> mask, id, flags;
+  std::vector<float> Ng_x, Ng_y, Ng_z, u, v;
+  std::vector<unsigned int> primID, geomID, instID;
+};
+
+/* state of the paths in flight, each attribute is stored in its own array */
+struct WavefrontState
+{
+  /* per path state */
+  avector<Vec3fa> L;                  //!< radiance accumulated along the path
+  avector<Vec3fa> Lw;                 //!< throughput of the path
+  std::vector<Medium> medium;         //!< medium the path travels through
+  std::vector<RandomSampler> sampler; //!< random number sequence of the path
+  std::vector<float> time;            //!< time of the path for motion blur
+  avector<RayDifferential> rd;        //!< differentials of the current ray of the path
+
+  /* rays of the current bounce, and compacted rays for the next bounce */
+  RayStreamSoA rays, nextRays;
+  std::vector<unsigned int> path, nextPath; //!< path of each ray
+  std::vector<unsigned int> alive;          //!< 1 if the path continues after this bounce
+  std::vector<uint64_t> order, orderTmp;    //!< rays sorted by material
+
+  /* shadow rays of the current bounce, one per light sample of each ray */
+  RayStreamSoA shadows;
+  avector<Vec3fa> shadowWeight;   //!< path throughput times light sample weight
+  avector<Vec3fa> shadowEval;     //!< BRDF evaluated for the light sample
+  avector<Vec3fa> transparency;   //!< transparency along the shadow ray, updated by the filter functions
+};
+
+WavefrontState* g_wavefront_state = nullptr;
+
+/* returns the material of a hit without computing its differential geometry */
+inline unsigned int hitMaterialID(unsigned int instID, unsigned int geomID)
+{
+  ISPCGeometry* geometry = nullptr;
+  if (g_instancing_mode != ISPC_INSTANCING_NONE)
+    geometry = ((ISPCInstancePtr) g_ispc_scene->geometries[instID])->child;
+  else
+    geometry = g_ispc_scene->geometries[geomID];
+  if (geometry->type == GROUP)
+    geometry = ((ISPCGroup*) geometry)->geometries[geomID];
+  return geometry->materialID;
+}
+
+/* traces the first numRays rays of the stream in parallel, each task traces a large stream */
+template<typename Trace>
+void traceStreams(size_t numRays, const Trace& trace)
+{
+  parallel_for(size_t(0),(numRays+WAVEFRONT_STREAM_SIZE-1)/WAVEFRONT_STREAM_SIZE,[&](const range<size_t>& r) {
+    const int threadIndex = (int)TaskScheduler::threadIndex();
+    for (size_t i=r.begin(); i<r.end(); i++)
+    {
+      const size_t begin = i*WAVEFRONT_STREAM_SIZE;
+      const size_t end = min(begin+WAVEFRONT_STREAM_SIZE,numRays);
+      trace(begin,end,g_stats[threadIndex]);
+    }
+  });
+}
+
+/* shades the ray in the given slot of the stream and samples the lights,
+ * returns true if the path continues */
+inline bool shadeWavefront(WavefrontState& state, size_t slot, int bounce)
+{
+  const unsigned int p = state.path[slot];
+  const unsigned int numLights = getNumLightSamples();
+  RandomSampler& sampler = state.sampler[p];
+  Medium& medium = state.medium[p];
+  Vec3fa& L = state.L[p];
+  Vec3fa& Lw = state.Lw[p];
+  const float time = state.time[p];
+
+  for (unsigned int i=0; i<numLights; i++) {
+    state.shadows.tfar[slot*numLights+i] = neg_inf;
+    state.transparency[slot*numLights+i] = Vec3fa(0.0f);
+  }
+
+  Ray ray = state.rays.get(slot);
+  const Vec3fa wo = neg(ray.dir);
+  DifferentialGeometry dg;
+
+  /* invoke environment lights if nothing hit */
+  if (ray.geomID == RTC_INVALID_GEOMETRY_ID)
+  {
+    /* iterate over all lights */
+    addEnvironmentLights(L,Lw,dg,ray.dir);
+    return false;
+  }
+
+  Vec3fa Ns = normalize(ray.Ng);
+
+  /* compute differential geometry */
+  dg.instID = ray.instID;
+  dg.geomID = ray.geomID;
+  dg.primID = ray.primID;
+  dg.u = ray.u;
+  dg.v = ray.v;
+  dg.P  = ray.org+ray.tfar*ray.dir;
+  dg.Ng = ray.Ng;
+  dg.Ns = Ns;
+  int materialID = postIntersect(ray,dg,&state.rd[p]);
+  dg.Ng = face_forward(ray.dir,normalize(dg.Ng));
+  dg.Ns = face_forward(ray.dir,normalize(dg.Ns));
+
+  /*! Compute  simple volumetric effect. */
+  Vec3fa c = Vec3fa(1.0f);
+  const Vec3fa transmission = medium.transmission;
+  if (ne(transmission,Vec3fa(1.0f)))
+    c = c * pow(transmission,ray.tfar);
+
+  /* calculate BRDF */
+  BRDF brdf;
+  int numMaterials = g_ispc_scene->numMaterials;
+  ISPCMaterial** material_array = &g_ispc_scene->materials[0];
+  Material__preprocess(material_array,materialID,numMaterials,brdf,wo,dg,medium);
+
+  /* sample BRDF at hit point */
+  Sample3f wi1;
+  c = c * Material__sample(material_array,materialID,numMaterials,brdf,Lw, wo, dg, wi1, medium, RandomSampler_get2D(sampler));
+
+  /* generate one shadow ray per light, they get traced after shading */
+  for (unsigned int i=0; i<numLights; i++)
+  {
+    Light_SampleRes ls = sampleLight(i,dg,sampler);
+    if (ls.pdf <= 0.0f) continue;
+    const size_t s = slot*numLights+i;
+    Ray shadow(dg.P,ls.dir,dg.eps,ls.dist,time);
+    shadow.id = (unsigned int)(s % WAVEFRONT_STREAM_SIZE); // indexes the transparency of the stream in the filter functions
+    shadow.flags = 0;
+    state.shadows.set(s,shadow);
+    state.shadowWeight[s] = Lw*ls.weight;
+    state.shadowEval[s] = Material__eval(material_array,materialID,numMaterials,brdf,wo,dg,ls.dir);
+    state.transparency[s] = Vec3fa(1.0f);
+  }
+
+  if (wi1.pdf <= 1E-4f /* 0.0f */) return false;
+  Lw = Lw*c/wi1.pdf;
+
+  /* setup secondary ray */
+  float sign = dot(wi1.v,dg.Ng) < 0.0f ? -1.0f : 1.0f;
+  dg.P = dg.P + sign*dg.eps*dg.Ng;
+  init_Ray(ray, dg.P,normalize(wi1.v),dg.eps,inf,time);
+  ray.id = 0; ray.flags = 0;
+  state.rays.set(slot,ray);
+  state.rd[p] = secondaryRayDifferential(dg);
+
+  /* terminate if contribution too low */
+  return bounce+1 < MAX_PATH_LENGTH && max(Lw.x,max(Lw.y,Lw.z)) >= 0.01f;
+}
+
+/* renders the pixels [pixel0,pixel1) of the frame with the wavefront path tracer */
+void renderPixelsWavefront(WavefrontState& state, int* pixels,
+                           const unsigned int width,
+                           const unsigned int height,
+                           const ISPCCamera& camera,
+                           const unsigned int pixel0,
+                           const unsigned int pixel1)
+{
+  const unsigned int spp = g_spp;
+  const unsigned int numLights = getNumLightSamples();
+  const size_t numPaths = size_t(pixel1-pixel0)*spp;
+
+  /* generate primary rays */
+  parallel_for(size_t(0),numPaths,size_t(4096),[&](const range<size_t>& r) {
+    for (size_t p=r.begin(); p<r.end(); p++)
+    {
+      const unsigned int pixel = pixel0 + unsigned(p/spp);
+      const unsigned int x = pixel % width, y = pixel / width;
+      RandomSampler& sampler = state.sampler[p];
+      RandomSampler_init(sampler, (int)x, (int)y, g_accu_count*g_spp+int(p%spp));
+      const float fx = (float)x + RandomSampler_get1D(sampler);
+      const float fy = (float)y + RandomSampler_get1D(sampler);
+      state.time[p] = RandomSampler_get1D(sampler);
+      state.L[p] = Vec3fa(0.0f);
+      state.Lw[p] = Vec3fa(1.0f);
+      state.medium[p] = make_Medium_Vacuum();
+
+      Ray ray(Vec3fa(camera.xfm.p),Vec3fa(normalize(fx*camera.xfm.l.vx + fy*camera.xfm.l.vy + camera.xfm.l.vz)),0.0f,inf,state.time[p]);
+      ray.id = 0; ray.flags = 0;
+      state.rays.set(p,ray);
+      state.rd[p] = cameraRayDifferential(camera,fx,fy);
+      state.path[p] = (unsigned int) p;
+    }
+  });
+
+  size_t numRays = numPaths;
+  for (int bounce=0; bounce<MAX_PATH_LENGTH && numRays; bounce++)
+  {
+    /* trace all rays of this bounce */
+    traceStreams(numRays,[&] (size_t begin, size_t end, RayStats& stats) {
+      IntersectContext context;
+      InitIntersectionContext(&context);
+      context.context.flags = (bounce == 0) ? g_iflags_coherent : g_iflags_incoherent;
+      RTCRayHitNp rayhit = state.rays.rayhit(begin);
+      rtcIntersectNp(g_scene,&context.context,&rayhit,unsigned(end-begin));
+      for (size_t i=begin; i<end; i++)
+        RayStats_addRay(stats);
+    });
+
+    /* sort rays by material, rays that missed go to the end */
+    parallel_for(size_t(0),numRays,size_t(4096),[&](const range<size_t>& r) {
+      for (size_t i=r.begin(); i<r.end(); i++) {
+        const uint64_t materialID = state.rays.geomID[i] == RTC_INVALID_GEOMETRY_ID ? 0xFFFFFFFF : hitMaterialID(state.rays.instID[i],state.rays.geomID[i]);
+        state.order[i] = (materialID << 32) | i;
+      }
+    });
+    radix_sort_u64(state.order.data(),state.orderTmp.data(),numRays);
+
+    /* shade all rays in material order */
+    parallel_for(size_t(0),numRays,size_t(64),[&](const range<size_t>& r) {
+      for (size_t i=r.begin(); i<r.end(); i++) {
+        const size_t slot = state.order[i] & 0xFFFFFFFF;
+        state.alive[slot] = shadeWavefront(state,slot,bounce);
+      }
+    });
+
+    /* trace all shadow rays, the filter functions find the transparency of each ray through its ID */
+    traceStreams(numRays*numLights,[&] (size_t begin, size_t end, RayStats& stats) {
+      IntersectContext context;
+      InitIntersectionContext(&context);
+      context.context.flags = g_iflags_incoherent;
+      context.userRayExt = &state.transparency[begin];
+      for (size_t i=begin; i<end; i++)
+        if (state.shadows.tfar[i] >= 0.0f)
+          RayStats_addShadowRay(stats);
+      RTCRayNp ray = state.shadows.rayhit(begin).ray;
+      rtcOccludedNp(g_scene,&context.context,&ray,unsigned(end-begin));
+    });
+
+    /* add light of all unoccluded shadow rays */
+    parallel_for(size_t(0),numRays,size_t(1024),[&](const range<size_t>& r) {
+      for (size_t slot=r.begin(); slot<r.end(); slot++)
+      {
+        Vec3fa& L = state.L[state.path[slot]];
+        for (size_t s=slot*numLights; s<(slot+1)*numLights; s++) {
+          const Vec3fa& transparency = state.transparency[s];
+          if (max(max(transparency.x,transparency.y),transparency.z) > 0.0f)
+            L = L + state.shadowWeight[s]*transparency*state.shadowEval[s];
+        }
+      }
+    });
+
+    /* compact rays of paths that continue */
+    ParallelPrefixSumState<size_t> pstate;
+    size_t numAlive = 0;
+    for (size_t pass=0; pass<2; pass++)
+    {
+      numAlive = parallel_prefix_sum(pstate,size_t(0),numRays,size_t(1024),size_t(0),[&](const range<size_t>& r, const size_t base) -> size_t
+      {
+        size_t n = 0;
+        for (size_t i=r.begin(); i<r.end(); i++)
+        {
+          if (!state.alive[i]) continue;
+          if (pass == 1) {
+            state.nextRays.set(base+n,state.rays.get(i));
+            state.nextPath[base+n] = state.path[i];
+          }
+          n++;
+        }
+        return n;
+      }, std::plus<size_t>());
+    }
+    numRays = numAlive;
+    std::swap(state.rays,state.nextRays);
+    std::swap(state.path,state.nextPath);
+  }
+
+  /* average the samples of each pixel and accumulate them in the framebuffer */
+  parallel_for(size_t(pixel0),size_t(pixel1),size_t(4096),[&](const range<size_t>& r) {
+    for (size_t pixel=r.begin(); pixel<r.end(); pixel++)
+    {
+      Vec3fa color = Vec3fa(0.0f);
+      for (size_t i=0; i<spp; i++)
+        color = color + state.L[(pixel-pixel0)*spp+i];
+      color = color/(float)g_spp;
+
+      Vec3fa accu_color = g_accu[pixel] + Vec3fa(color.x,color.y,color.z,1.0f); g_accu[pixel] = accu_color;
+      float f = rcp(max(0.001f,accu_color.w));
+      unsigned int r = (unsigned int) (255.01f * clamp(accu_color.x*f,0.0f,1.0f));
+      unsigned int g = (unsigned int) (255.01f * clamp(accu_color.y*f,0.0f,1.0f));
+      unsigned int b = (unsigned int) (255.01f * clamp(accu_color.z*f,0.0f,1.0f));
+      pixels[pixel] = (b << 16) + (g << 8) + r;
+    }
+  });
+}
+
+/* renders the frame in batches of pixels with the wavefront path tracer */
+void renderFrameWavefront(int* pixels,
+                          const unsigned int width,
+                          const unsigned int height,
+                          const ISPCCamera& camera)
+{
+  if (!g_wavefront_state) g_wavefront_state = new WavefrontState;
+  WavefrontState& state = *g_wavefront_state;
+
+  const unsigned int spp = max(1,g_spp);
+  const unsigned int numLights = getNumLightSamples();
+  const unsigned int pixelsPerBatch = max(1u,WAVEFRONT_MAX_PATHS/spp);
+  const size_t maxPaths = size_t(min(pixelsPerBatch,width*height))*spp;
+
+  state.L.resize(maxPaths); state.Lw.resize(maxPaths);
+  state.medium.resize(maxPaths); state.sampler.resize(maxPaths); state.time.resize(maxPaths); state.rd.resize(maxPaths);
+  state.rays.resize(maxPaths); state.nextRays.resize(maxPaths);
+  state.path.resize(maxPaths); state.nextPath.resize(maxPaths); state.alive.resize(maxPaths);
+  state.order.resize(maxPaths); state.orderTmp.resize(maxPaths);
+  state.shadows.resize(maxPaths*numLights);
+  state.shadowWeight.resize(maxPaths*numLights); state.shadowEval.resize(maxPaths*numLights);
+  state.transparency.resize(maxPaths*numLights);
+
+  for (unsigned int pixel0=0; pixel0<width*height; pixel0+=pixelsPerBatch)
+    renderPixelsWavefront(state,pixels,width,height,camera,pixel0,min(pixel0+pixelsPerBatch,width*height));
+}
+
 /***************************************************************************************/
 
 inline float updateEdgeLevel( ISPCSubdivMesh* mesh, const Vec3fa& cam_pos, const unsigned int e0, const unsigned int e1)
@@ -1777,6 +2413,7 @@ extern "C" void device_render (int* pixels,
     g_scene = convertScene(g_ispc_scene);
     if (g_subdiv_mode) updateEdgeLevels(g_ispc_scene,camera.xfm.p);
     rtcCommitScene (g_scene);
+    if (g_lighttree) g_light_tree = new LightTree(g_ispc_scene->lights,g_ispc_scene->numLights);
   }
 
   /* create accumulator */
@@ -1811,6 +2448,16 @@ extern "C" void device_render (int* pixels,
     g_accu_count++;
 
   /* render image */
+  if (g_wavefront) {
+    renderFrameWavefront(pixels,width,height,camera);
+    return;
+  }
+
+  if (g_adaptive > 0.0f) {
+    renderFrameAdaptive(pixels,width,height,camera);
+    return;
+  }
+
   const int numTilesX = (width +TILE_SIZE_X-1)/TILE_SIZE_X;
   const int numTilesY = (height+TILE_SIZE_Y-1)/TILE_SIZE_Y;
   parallel_for(size_t(0),size_t(numTilesX*numTilesY),[&](const range<size_t>& range) {
@@ -1826,6 +2473,8 @@ extern "C" void device_cleanup ()
 {
   rtcReleaseScene (g_scene); g_scene = nullptr;
   alignedFree(g_accu); g_accu = nullptr;
+  delete g_wavefront_state; g_wavefront_state = nullptr;
+  delete g_light_tree; g_light_tree = nullptr;
   g_accu_width = 0;
   g_accu_height = 0;
   g_accu_count = 0;
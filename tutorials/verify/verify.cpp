@@ -445,9 +445,9 @@ namespace embree
     return bestAvg;
   }
 
-  void VerifyApplication::Benchmark::updateDatabase(VerifyApplication* state, Statistics stat, double bestAvg)
+  /* load git hash from file */
+  static std::string readHash()
   {
-    /* load git hash from file */
     std::fstream hashFile;
     std::string hash = "unknown";
     hashFile.open(FileName::executableFolder()+FileName("hash"), std::fstream::in);
@@ -455,6 +455,12 @@ namespace embree
       hashFile >> hash;
       hashFile.close();
     }
+    return hash;
+  }
+
+  void VerifyApplication::Benchmark::updateDatabase(VerifyApplication* state, Statistics stat, double bestAvg)
+  {
+    std::string hash = readHash();
 
     /* update database */
     std::fstream db;
@@ -1140,6 +1146,355 @@ namespace embree
     }
   };
 
+  struct InvalidBVHLayoutTest : public VerifyApplication::Test
+  {
+    InvalidBVHLayoutTest (std::string name, int isa)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS) {}
+    
+    VerifyApplication::TestReturnValue run (VerifyApplication* state, bool silent)
+    {
+      /* an unknown layout already fails at device creation, not only at the first commit */
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa)+",bvh_layout=unknown";
+      RTCDevice device = rtcNewDevice(cfg.c_str());
+      if (device) {
+        rtcReleaseDevice(device);
+        return VerifyApplication::FAILED;
+      }
+      return rtcGetDeviceError(nullptr) == RTC_ERROR_INVALID_ARGUMENT ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+  };
+
+  struct CompactSceneTest : public VerifyApplication::Test
+  {
+    SceneFlags sflags;
+    RTCBuildQuality quality; 
+    std::string layout;
+
+    CompactSceneTest (std::string name, int isa, SceneFlags sflags, RTCBuildQuality quality, std::string layout)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), sflags(sflags), quality(quality), layout(layout) {}
+    
+    VerifyApplication::TestReturnValue run (VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa)+",bvh_layout="+layout;
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      VerifyScene scene(device,sflags);
+
+      const Vec3fa center = zero;
+      const float radius = 1.0f;
+      const Vec3fa dx(1,0,0);
+      const Vec3fa dy(0,1,0);
+      scene.addGeometry(quality,SceneGraph::createTriangleSphere(center,radius,50));
+      scene.addGeometry(quality,SceneGraph::createQuadSphere(center,radius,50)->set_motion_vector(random_motion_vector(1.0f)));
+      scene.addGeometry(quality,SceneGraph::createGridSphere(center,radius,50));
+      scene.addGeometry(quality,SceneGraph::createSubdivSphere(center,radius,8,20));
+      scene.addGeometry(quality,SceneGraph::createHairyPlane(RandomSampler_getInt(sampler),center,dx,dy,0.1f,0.01f,100,SceneGraph::FLAT_CURVE));
+
+      /* compacting an uncommitted scene fails */
+      rtcCompactScene(scene);
+      AssertError(device,RTC_ERROR_INVALID_OPERATION);
+      
+      rtcCommitScene (scene);
+      AssertNoError(device);
+
+      const size_t numRays = 1000;
+      std::vector<Vec3fa> orgs(numRays), dirs(numRays);
+      std::vector<RTCRayHit> hits(numRays);
+      for (size_t i=0; i<numRays; i++) {
+        orgs[i] = 4.0f*random_Vec3fa()-Vec3fa(2.0f);
+        dirs[i] = 2.0f*random_Vec3fa()-Vec3fa(1.0f);
+      }
+
+      RTCIntersectContext context;
+      rtcInitIntersectContext(&context);
+      for (size_t i=0; i<numRays; i++) {
+        hits[i] = makeRay(orgs[i],dirs[i]);
+        rtcIntersect1(scene,&context,&hits[i]);
+      }
+
+      /* compaction must not change any hit */
+      rtcCompactScene(scene);
+      AssertNoError(device);
+
+      bool passed = true;
+      for (size_t i=0; i<numRays; i++) {
+        RTCRayHit ray = makeRay(orgs[i],dirs[i]);
+        rtcIntersect1(scene,&context,&ray);
+        passed &= ray.hit.geomID == hits[i].hit.geomID;
+        passed &= ray.hit.primID == hits[i].hit.primID;
+        passed &= ray.ray.tfar == hits[i].ray.tfar;
+      }
+
+      /* the next commit rebuilds the scene */
+      rtcCommitScene (scene);
+      AssertNoError(device);
+      
+      return passed ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+  };
+
+  struct CompactMeshTest : public VerifyApplication::Test
+  {
+    RTCGeometryType gtype;
+    RTCFormat vformat;
+    RTCFormat iformat;
+    RTCSceneFlags sflags;
+
+    CompactMeshTest (std::string name, int isa, RTCGeometryType gtype, RTCFormat vformat, RTCFormat iformat, RTCSceneFlags sflags = RTC_SCENE_FLAG_NONE)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), gtype(gtype), vformat(vformat), iformat(iformat), sflags(sflags) {}
+
+    /* converts floats that are exactly representable as half floats */
+    static unsigned short toHalf(float f)
+    {
+      if (f == 0.0f) return 0;
+      unsigned int i; memcpy(&i,&f,sizeof(i));
+      return (unsigned short)(((i >> 16) & 0x8000) | ((((i >> 23) & 0xFF) - 112) << 10) | ((i >> 13) & 0x3FF));
+    }
+
+    RTCScene createScene(RTCDevice device, RTCSceneFlags flags, RTCFormat format, const void* vertices, size_t stride,
+                         RTCFormat indexFormat, const void* indices, size_t indexSize, size_t numPrims, size_t numVertices)
+    {
+      const bool quads = gtype == RTC_GEOMETRY_TYPE_QUAD;
+      RTCScene scene = rtcNewScene(device);
+      rtcSetSceneFlags(scene,flags);
+      RTCGeometry geom = rtcNewGeometry(device,gtype);
+      if (format == RTC_FORMAT_USHORT3) {
+        const float scale[3] = { 65535.0f/16.0f, 65535.0f/16.0f, 65535.0f/16.0f };
+        const float offset[3] = { 0.0f, 0.0f, 0.0f };
+        rtcSetGeometryVertexQuantization(geom,scale,offset);
+      }
+      if (format == RTC_FORMAT_FLOAT3) {
+        Vec3f* v = (Vec3f*) rtcSetNewGeometryBuffer(geom,RTC_BUFFER_TYPE_VERTEX,0,format,sizeof(Vec3f),numVertices);
+        memcpy(v,vertices,numVertices*sizeof(Vec3f));
+      } else {
+        rtcSetSharedGeometryBuffer(geom,RTC_BUFFER_TYPE_VERTEX,0,format,vertices,0,stride,numVertices);
+      }
+      rtcSetSharedGeometryBuffer(geom,RTC_BUFFER_TYPE_INDEX,0,indexFormat,indices,0,(quads ? 4 : 3)*indexSize,numPrims);
+      rtcCommitGeometry(geom);
+      rtcAttachGeometry(scene,geom);
+      rtcReleaseGeometry(geom);
+      rtcCommitScene(scene);
+      return scene;
+    }
+
+    VerifyApplication::TestReturnValue run (VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      /* height field whose vertex coordinates are multiples of 1/16, with few enough vertices for 8 bit indices */
+      const unsigned N = 8;
+      const size_t numVertices = (N+1)*(N+1);
+      std::vector<Vec3f> positions(numVertices);
+      std::vector<unsigned short> compact(3*numVertices); // tightly packed, thus only 2 bytes aligned and not padded
+      for (unsigned y=0; y<=N; y++) {
+        for (unsigned x=0; x<=N; x++) {
+          const unsigned i = y*(N+1)+x, k[3] = { x, y, (x*y)%5 };
+          for (size_t j=0; j<3; j++) {
+            positions[i][j] = float(k[j])/16.0f;
+            compact[3*i+j] = vformat == RTC_FORMAT_HALF3 ? toHalf(positions[i][j]) : (unsigned short) k[j];
+          }
+        }
+      }
+
+      const bool quads = gtype == RTC_GEOMETRY_TYPE_QUAD;
+      std::vector<unsigned> indices;
+      for (unsigned y=0; y<N; y++) {
+        for (unsigned x=0; x<N; x++) {
+          const unsigned v0 = y*(N+1)+x, v1 = v0+1, v2 = v0+N+2, v3 = v0+N+1;
+          if (quads) { indices.push_back(v0); indices.push_back(v1); indices.push_back(v2); indices.push_back(v3); }
+          else { indices.push_back(v0); indices.push_back(v1); indices.push_back(v2); indices.push_back(v0); indices.push_back(v2); indices.push_back(v3); }
+        }
+      }
+      const size_t numPrims = indices.size()/(quads ? 4 : 3);
+
+      /* tightly packed 8 and 16 bit indices */
+      std::vector<unsigned short> indices16(indices.begin(),indices.end());
+      std::vector<unsigned char> indices8(indices.begin(),indices.end());
+      const void* indexData = indices.data(); size_t indexSize = sizeof(unsigned);
+      if (iformat == RTC_FORMAT_USHORT3 || iformat == RTC_FORMAT_USHORT4) { indexData = indices16.data(); indexSize = sizeof(unsigned short); }
+      if (iformat == RTC_FORMAT_UCHAR3  || iformat == RTC_FORMAT_UCHAR4 ) { indexData = indices8.data();  indexSize = sizeof(unsigned char); }
+
+      const RTCFormat uintFormat = quads ? RTC_FORMAT_UINT4 : RTC_FORMAT_UINT3;
+      RTCSceneRef scene0 = createScene(device,RTC_SCENE_FLAG_NONE,RTC_FORMAT_FLOAT3,positions.data(),sizeof(Vec3f),uintFormat,indices.data(),sizeof(unsigned),numPrims,numVertices);
+      RTCSceneRef scene1 = vformat == RTC_FORMAT_FLOAT3
+        ? createScene(device,sflags,vformat,positions.data(),sizeof(Vec3f),iformat,indexData,indexSize,numPrims,numVertices)
+        : createScene(device,sflags,vformat,compact.data(),3*sizeof(unsigned short),iformat,indexData,indexSize,numPrims,numVertices);
+      AssertNoError(device);
+
+      /* rays shot down through the center of each primitive hit the same primitive at the same distance */
+      bool passed = true;
+      RTCIntersectContext context;
+      rtcInitIntersectContext(&context);
+      for (size_t i=0; i<numPrims; i++)
+      {
+        Vec3fa center = zero;
+        const size_t n = quads ? 4 : 3;
+        for (size_t j=0; j<n; j++) center += Vec3fa(positions[indices[n*i+j]]);
+        center = center/float(n);
+        RTCRayHit ray0 = makeRay(Vec3fa(center.x,center.y,2.0f),Vec3fa(0,0,-1));
+        RTCRayHit ray1 = ray0;
+        rtcIntersect1(scene0,&context,&ray0);
+        rtcIntersect1(scene1,&context,&ray1);
+        passed &= ray0.hit.primID == i;
+        passed &= ray1.hit.primID == i && ray1.hit.geomID == 0;
+        passed &= abs(ray1.ray.tfar-ray0.ray.tfar) < 1E-4f;
+      }
+      AssertNoError(device);
+      return passed ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+  };
+
+  struct MemoryBudgetTest : public VerifyApplication::Test
+  {
+    RTCBuildQuality quality;
+
+    MemoryBudgetTest (std::string name, int isa, RTCBuildQuality quality)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), quality(quality) {}
+
+    static bool monitorMemory(void* userPtr, const ssize_t bytes, const bool /*post*/)
+    {
+      *(std::atomic<ssize_t>*)userPtr += bytes;
+      return true;
+    }
+
+    /* commits the scene with the specified budget and returns the selected fallback */
+    RTCSceneMemoryFallback commit(VerifyScene& scene, size_t budget)
+    {
+      rtcSetSceneMemoryBudget(scene,budget);
+      rtcCommitScene(scene);
+      return rtcGetSceneMemoryFallback(scene);
+    }
+
+    VerifyApplication::TestReturnValue run (VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa);
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      std::atomic<ssize_t> bytesUsed(0);
+      rtcSetDeviceMemoryMonitorFunction(device,monitorMemory,&bytesUsed);
+
+      const size_t numRays = 1000;
+      std::vector<RTCRayHit> rays(numRays);
+      for (size_t i=0; i<numRays; i++)
+        rays[i] = makeRay(4.0f*random_Vec3fa()-Vec3fa(2.0f),2.0f*random_Vec3fa()-Vec3fa(1.0f));
+
+      /* builds the scene with the specified budget, and returns the selected fallback and the memory kept by the scene */
+      auto build = [&] (size_t budget, std::vector<RTCRayHit>& hits) -> std::pair<RTCSceneMemoryFallback,ssize_t>
+      {
+        const ssize_t bytes0 = bytesUsed;
+        VerifyScene scene(device,SceneFlags(RTC_SCENE_FLAG_NONE,quality));
+        scene.addGeometry(quality,SceneGraph::createTriangleSphere(Vec3fa(-1.0f,0.0f,0.0f),1.0f,50));
+        scene.addGeometry(quality,SceneGraph::createQuadSphere(Vec3fa(+1.0f,0.0f,0.0f),0.9f,50));
+        const RTCSceneMemoryFallback fallback = commit(scene,budget);
+        const ssize_t bytes1 = bytesUsed;
+
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        hits = rays;
+        for (size_t i=0; i<numRays; i++)
+          rtcIntersect1(scene,&context,&hits[i]);
+        return std::make_pair(fallback,bytes1-bytes0);
+      };
+
+      std::vector<RTCRayHit> hits0, hits1, hits2;
+      std::pair<RTCSceneMemoryFallback,ssize_t> build0 = build(0,hits0);       // no budget
+      std::pair<RTCSceneMemoryFallback,ssize_t> build1 = build(size_t(1) << 40,hits1); // large budget
+      std::pair<RTCSceneMemoryFallback,ssize_t> build2 = build(1,hits2);       // nothing fits
+      AssertNoError(device);
+
+      /* a commit over budget degrades to the compact fallback, which keeps less memory but finds the same hits */
+      bool passed = true;
+      passed &= build0.first == RTC_SCENE_MEMORY_FALLBACK_NONE;
+      passed &= build1.first == RTC_SCENE_MEMORY_FALLBACK_NONE;
+      passed &= build2.first == RTC_SCENE_MEMORY_FALLBACK_COMPACT;
+      passed &= build2.second < build0.second;
+      for (size_t i=0; i<numRays; i++) {
+        passed &= hits2[i].hit.geomID == hits0[i].hit.geomID;
+        passed &= hits2[i].ray.tfar == hits0[i].ray.tfar || abs(hits2[i].ray.tfar-hits0[i].ray.tfar) <= 1E-5f*hits0[i].ray.tfar;
+      }
+
+      /* the smallest budget that avoids all fallbacks only disables spatial splits when it is reduced by one byte */
+      VerifyScene scene(device,SceneFlags(RTC_SCENE_FLAG_NONE,quality));
+      scene.addGeometry(quality,SceneGraph::createTriangleSphere(Vec3fa(-1.0f,0.0f,0.0f),1.0f,50));
+      scene.addGeometry(quality,SceneGraph::createQuadSphere(Vec3fa(+1.0f,0.0f,0.0f),0.9f,50));
+      size_t lower = 1, upper = size_t(1) << 40;
+      while (upper-lower > 1) {
+        const size_t budget = (lower+upper)/2;
+        if (commit(scene,budget) == RTC_SCENE_MEMORY_FALLBACK_NONE) upper = budget;
+        else lower = budget;
+      }
+      passed &= commit(scene,upper) == RTC_SCENE_MEMORY_FALLBACK_NONE;
+      if (quality == RTC_BUILD_QUALITY_HIGH)
+        passed &= commit(scene,lower) == RTC_SCENE_MEMORY_FALLBACK_NO_SPATIAL_SPLITS;
+      else
+        passed &= commit(scene,lower) == RTC_SCENE_MEMORY_FALLBACK_COMPACT;
+
+      /* without a budget of the scene the budget of the device gets used */
+      std::string cfg2 = cfg + ",scene_memory_budget=0.000001";
+      RTCDeviceRef device2 = rtcNewDevice(cfg2.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device2));
+      VerifyScene scene2(device2,SceneFlags(RTC_SCENE_FLAG_NONE,quality));
+      scene2.addGeometry(quality,SceneGraph::createTriangleSphere(zero,1.0f,50));
+      rtcCommitScene(scene2);
+      passed &= rtcGetSceneMemoryFallback(scene2) == RTC_SCENE_MEMORY_FALLBACK_COMPACT;
+      AssertNoError(device);
+      AssertNoError(device2);
+
+      return passed ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+  };
+
+  struct PagePolicyTest : public VerifyApplication::Test
+  {
+    std::string policy;
+
+    PagePolicyTest (std::string name, int isa, std::string policy)
+      : VerifyApplication::Test(name,isa,VerifyApplication::TEST_SHOULD_PASS), policy(policy) {}
+
+    VerifyApplication::TestReturnValue run (VerifyApplication* state, bool silent)
+    {
+      std::string cfg = state->rtcore + ",isa="+stringOfISA(isa)+","+policy;
+      RTCDeviceRef device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+
+      /* the page statistics are shared by all devices, thus this test must not run in parallel to others */
+      const ssize_t bytes0 = rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_OS_ALLOCATED_BYTES);
+      bool passed = true;
+      {
+        VerifyScene scene(device,SceneFlags(RTC_SCENE_FLAG_NONE,RTC_BUILD_QUALITY_MEDIUM));
+        scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createTriangleSphere(zero,1.0f,200));
+        scene.addGeometry(RTC_BUILD_QUALITY_MEDIUM,SceneGraph::createQuadSphere(zero,0.5f,200));
+        rtcCommitScene(scene);
+        AssertNoError(device);
+
+        /* the BVH blocks are counted no matter whether they got allocated through os_malloc or alignedMalloc */
+        const ssize_t bytes1 = rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_OS_ALLOCATED_BYTES);
+        const ssize_t hugetlb = rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_HUGETLB_BYTES);
+        passed &= bytes1 > bytes0;
+        passed &= hugetlb <= bytes1;
+
+        /* prefaulted and interleaved pages work as usual */
+        RTCIntersectContext context;
+        rtcInitIntersectContext(&context);
+        for (size_t i=0; i<100; i++) {
+          const Vec3fa org = 4.0f*normalize(2.0f*random_Vec3fa()-Vec3fa(1.0f));
+          RTCRayHit ray = makeRay(org,-org);
+          rtcIntersect1(scene,&context,&ray);
+          passed &= ray.hit.geomID == 0 && abs(ray.ray.tfar-0.75f) < 0.01f;
+        }
+      }
+
+      /* releasing the scene returns all its pages */
+      const ssize_t bytes2 = rtcGetDeviceProperty(device,RTC_DEVICE_PROPERTY_OS_ALLOCATED_BYTES);
+      passed &= bytes2 == bytes0;
+      AssertNoError(device);
+
+      return passed ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+  };
+
   struct OverlappingGeometryTest : public VerifyApplication::Test
   {
     SceneFlags sflags;
@@ -4142,6 +4497,358 @@ namespace embree
   /////////////////////////////////////////////////////////////////////////////////
   /////////////////////////////////////////////////////////////////////////////////
 
+  /* measures build time, memory consumption, and ray throughput for
+   * all ray APIs of a procedurally generated scene, the measurements
+   * get compared against the baseline and written to the JSON file */
+  struct BenchmarkSuiteTest : public VerifyApplication::Test
+  {
+    GeometryType gtype;
+    SceneFlags sflags;
+    RTCBuildQuality quality;
+    size_t numPrimitives;
+    RTCDeviceRef device;
+    Ref<VerifyScene> scene;
+    std::atomic<ssize_t> bytesUsed;
+    static const size_t numBuilds = 4;
+    static const size_t numFrames = 4;
+    static const size_t width = 256;
+    static const size_t height = 256;
+    static const size_t tileSize = 16;
+    static const size_t numTilesX = width/tileSize;
+    static const size_t numTilesY = height/tileSize;
+
+    BenchmarkSuiteTest (std::string name, int isa, GeometryType gtype, SceneFlags sflags, RTCBuildQuality quality, size_t numPrimitives)
+      : VerifyApplication::Test(name,isa,VerifyApplication::BENCHMARK,false), gtype(gtype), sflags(sflags), quality(quality), numPrimitives(numPrimitives), bytesUsed(0) {}
+
+    /* all scenes fit into the [-1,1]^3 box and have about numPrimitives primitives */
+    Ref<SceneGraph::Node> createGeometry()
+    {
+      const float N = float(numPrimitives);
+      Ref<SceneGraph::Node> node;
+      switch (gtype) {
+      case TRIANGLE_MESH:    
+      case TRIANGLE_MESH_MB: node = SceneGraph::createTriangleSphere(zero,one,size_t(sqrtf(N/4.0f))); break;
+      case QUAD_MESH:        
+      case QUAD_MESH_MB:     node = SceneGraph::createQuadSphere(zero,one,size_t(sqrtf(N/2.0f))); break;
+      case GRID_MESH:        
+      case GRID_MESH_MB:     node = SceneGraph::createGridSphere(zero,one,size_t(sqrtf(N/6.0f))); break;
+      case SUBDIV_MESH:      
+      case SUBDIV_MESH_MB:   node = SceneGraph::createSubdivSphere(zero,one,8,sqrtf(N/128.0f)); break;
+      case HAIR_GEOMETRY:    
+      case HAIR_GEOMETRY_MB: node = SceneGraph::createHairyPlane(0,Vec3fa(-1,-1,0),Vec3fa(2,0,0),Vec3fa(0,2,0),0.1f,0.002f,numPrimitives,SceneGraph::FLAT_CURVE); break;
+      case CURVE_GEOMETRY:   
+      case CURVE_GEOMETRY_MB: node = SceneGraph::createHairyPlane(0,Vec3fa(-1,-1,0),Vec3fa(2,0,0),Vec3fa(0,2,0),0.1f,0.002f,numPrimitives,SceneGraph::ROUND_CURVE); break;
+      case LINE_GEOMETRY:    
+      case LINE_GEOMETRY_MB: node = SceneGraph::convert_bezier_to_lines(SceneGraph::createHairyPlane(0,Vec3fa(-1,-1,0),Vec3fa(2,0,0),Vec3fa(0,2,0),0.1f,0.002f,numPrimitives/3,SceneGraph::FLAT_CURVE)); break;
+      }
+
+      switch (gtype) {
+      case TRIANGLE_MESH_MB: 
+      case QUAD_MESH_MB:     
+      case GRID_MESH_MB:     
+      case SUBDIV_MESH_MB:   
+      case HAIR_GEOMETRY_MB: 
+      case CURVE_GEOMETRY_MB:
+      case LINE_GEOMETRY_MB: node = node->set_motion_vector(random_motion_vector2(0.01f)); break;
+      default: break;
+      }
+      return node;
+    }
+
+    static bool memoryMonitor(void* userPtr, const ssize_t bytes, const bool /*post*/)
+    {
+      ((BenchmarkSuiteTest*)userPtr)->bytesUsed += bytes;
+      return true;
+    }
+
+    /* coherent rays start at a camera in front of the scene, incoherent rays connect random points around the scene */
+    __forceinline RTCRayHit makeSuiteRay(bool coherent, size_t x, size_t y, RandomSampler& sampler)
+    {
+      if (coherent) {
+        const Vec3fa p(2.0f*float(x)/float(width)-1.0f,2.0f*float(y)/float(height)-1.0f,0.0f);
+        return fastMakeRay(Vec3fa(0,0,-3),p-Vec3fa(0,0,-3));
+      } else {
+        const Vec3fa org = 3.0f*normalize(RandomSampler_get3D(sampler)-Vec3fa(0.5f));
+        const Vec3fa p = 2.0f*RandomSampler_get3D(sampler)-Vec3fa(1.0f);
+        return fastMakeRay(org,p-org);
+      }
+    }
+
+    void render_tile(size_t tile, bool coherent, IntersectMode imode)
+    {
+      const size_t x0 = (tile % numTilesX)*tileSize;
+      const size_t y0 = (tile / numTilesX)*tileSize;
+
+      RandomSampler sampler;
+      RandomSampler_init(sampler,(int)tile);
+
+      RTCIntersectContext context;
+      rtcInitIntersectContext(&context);
+      context.flags = coherent ? RTC_INTERSECT_CONTEXT_FLAG_COHERENT : RTC_INTERSECT_CONTEXT_FLAG_INCOHERENT;
+
+      RTCRayHit rays[tileSize*tileSize];
+      for (size_t y=0; y<tileSize; y++)
+        for (size_t x=0; x<tileSize; x++)
+          rays[y*tileSize+x] = makeSuiteRay(coherent,x0+x,y0+y,sampler);
+
+      const size_t N = tileSize*tileSize;
+      switch (imode) 
+      {
+      case MODE_INTERSECT1: 
+        for (size_t i=0; i<N; i++)
+          rtcIntersect1(*scene,&context,&rays[i]);
+        break;
+
+      case MODE_INTERSECT4: 
+        for (size_t i=0; i<N; i+=4) {
+          RTCRayHit4 ray4;
+          for (size_t k=0; k<4; k++) setRay(ray4,k,rays[i+k]);
+          __aligned(16) int valid4[4] = { -1,-1,-1,-1 };
+          rtcIntersect4(valid4,*scene,&context,&ray4);
+        }
+        break;
+
+      case MODE_INTERSECT8: 
+        for (size_t i=0; i<N; i+=8) {
+          RTCRayHit8 ray8;
+          for (size_t k=0; k<8; k++) setRay(ray8,k,rays[i+k]);
+          __aligned(32) int valid8[8] = { -1,-1,-1,-1,-1,-1,-1,-1 };
+          rtcIntersect8(valid8,*scene,&context,&ray8);
+        }
+        break;
+
+      case MODE_INTERSECT16: 
+        for (size_t i=0; i<N; i+=16) {
+          RTCRayHit16 ray16;
+          for (size_t k=0; k<16; k++) setRay(ray16,k,rays[i+k]);
+          __aligned(64) int valid16[16] = { -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1 };
+          rtcIntersect16(valid16,*scene,&context,&ray16);
+        }
+        break;
+
+      case MODE_INTERSECT1M: 
+        rtcIntersect1M(*scene,&context,rays,(unsigned int)N,sizeof(RTCRayHit));
+        break;
+
+      default: break;
+      }
+    }
+
+    Statistics benchmark_build(Ref<SceneGraph::Node> geometry, Statistics& memory)
+    {
+      Statistics stat;
+      for (size_t i=0; i<=numBuilds; i++)
+      {
+        scene = new VerifyScene(device,sflags);
+        scene->addGeometry(quality,geometry);
+        AssertNoError(device);
+
+        bytesUsed = 0;
+        double t0 = getSeconds();
+        rtcCommitScene (*scene);
+        double t1 = getSeconds();
+        AssertNoError(device);
+
+        /* first build is for warmup only */
+        if (i == 0) continue;
+        stat.add(1000.0f*float(t1-t0));
+        memory.add(1E-6f*float(bytesUsed));
+      }
+      return stat;
+    }
+
+    Statistics benchmark_rays(bool coherent, IntersectMode imode)
+    {
+      Statistics stat;
+      for (size_t i=0; i<=numFrames; i++)
+      {
+        double t0 = getSeconds();
+        parallel_for(numTilesX*numTilesY, [&](size_t tile) {
+            render_tile(tile,coherent,imode);
+          });
+        double t1 = getSeconds();
+
+        /* first frame is for warmup only */
+        if (i == 0) continue;
+        stat.add(1E-6f*float(width*height)/float(t1-t0));
+      }
+      return stat;
+    }
+
+    VerifyApplication::TestReturnValue execute(VerifyApplication* state, bool silent) try
+    {
+      if (!isEnabled())
+        return VerifyApplication::SKIPPED;
+
+      std::string cfg = state->rtcore + ",start_threads=1,set_affinity=1,isa="+stringOfISA(isa);
+      device = rtcNewDevice(cfg.c_str());
+      errorHandler(nullptr,rtcGetDeviceError(device));
+      rtcSetDeviceErrorFunction(device,errorHandler,nullptr);
+      rtcSetDeviceMemoryMonitorFunction(device,memoryMonitor,this);
+
+      Ref<SceneGraph::Node> geometry = createGeometry();
+      VerifyApplication::SuiteResult result(name,geometry->numPrimitives());
+
+      Statistics memory;
+      Statistics build = benchmark_build(geometry,memory);
+      result.metrics.push_back(VerifyApplication::SuiteMetric("build_time","ms",false,build));
+      result.metrics.push_back(VerifyApplication::SuiteMetric("memory","MB",false,memory));
+
+      IntersectMode imodes[] = { MODE_INTERSECT1, MODE_INTERSECT4, MODE_INTERSECT8, MODE_INTERSECT16, MODE_INTERSECT1M };
+      for (auto coherent : { true, false }) {
+        for (auto imode : imodes) {
+          if (!supportsIntersectMode(device,imode)) continue;
+          std::string metric = std::string("rays.") + (coherent ? "coherent." : "incoherent.") + to_string(imode);
+          result.metrics.push_back(VerifyApplication::SuiteMetric(metric,"Mrps",true,benchmark_rays(coherent,imode)));
+        }
+      }
+      AssertNoError(device);
+      scene = nullptr;
+      device = nullptr;
+
+      /* compare each metric against the baseline */
+      bool passed = true;
+      for (auto& metric : result.metrics)
+      {
+        const double avg = metric.stat.getAvg();
+        std::cout << std::setw(TEXT_ALIGN) << name + "." + metric.name << ": ";
+        std::cout << std::setw(8) << std::setprecision(3) << std::fixed << avg << " " << metric.unit << " (+/-" << 100.0f*metric.stat.getAvgSigma()/avg << "%)";
+
+        auto base = state->suite_baseline.find("benchmarks/" + name + "/" + metric.name + "/avg");
+        if (base == state->suite_baseline.end()) {
+          std::cout << state->yellow(" [NO BASELINE]") << std::endl << std::flush;
+          continue;
+        }
+
+        const double rel = (avg-base->second)/base->second;
+        const double tolerance = state->getSuiteThreshold(metric.name);
+        const bool ok = metric.higher_is_better ? !(rel < -tolerance) : !(rel > +tolerance); // !(a < b) on purpose for nan case
+        if (ok) std::cout << state->green(" [PASSED]") << " (" << 100.0f*rel << "%)" << std::endl << std::flush;
+        else    std::cout << state->red  (" [FAILED]") << " (" << 100.0f*rel << "%, tolerance " << 100.0f*tolerance << "%)" << std::endl << std::flush;
+        passed &= ok;
+      }
+
+      {
+        Lock<MutexSys> lock(state->mutex);
+        state->suite_results.push_back(result);
+      }
+
+      state->numPassedTests += passed;
+      state->numFailedTests += !passed;
+      return passed ? VerifyApplication::PASSED : VerifyApplication::FAILED;
+    }
+    catch (const std::exception& e)
+    {
+      scene = nullptr;
+      device = nullptr;
+      std::cout << std::setw(TEXT_ALIGN) << name << ": " << std::flush;
+      std::cout << state->red(" [FAILED] ") << "(" << e.what() << ")" << std::endl << std::flush;
+      state->numFailedTests++;
+      return VerifyApplication::FAILED;
+    }
+  };
+
+  /* reads all numbers of a JSON file, each number is stored with
+   * the member names along its path separated by '/' as key */
+  struct JSONNumberReader
+  {
+    JSONNumberReader (const FileName& fileName)
+      : fileName(fileName), pos(0)
+    {
+      std::ifstream file(fileName.str());
+      if (!file.is_open()) THROW_RUNTIME_ERROR("cannot open file " + fileName.str());
+      std::stringstream buffer; buffer << file.rdbuf();
+      str = buffer.str();
+    }
+
+    std::map<std::string,double> parse()
+    {
+      std::map<std::string,double> numbers;
+      parseValue("",numbers);
+      return numbers;
+    }
+
+  private:
+
+    char peek()
+    {
+      while (pos < str.size() && isspace(str[pos])) pos++;
+      if (pos >= str.size()) THROW_RUNTIME_ERROR(fileName.str() + ": unexpected end of file");
+      return str[pos];
+    }
+
+    bool consume(char c)
+    {
+      if (peek() != c) return false;
+      pos++;
+      return true;
+    }
+
+    void expect(char c)
+    {
+      if (!consume(c)) THROW_RUNTIME_ERROR(fileName.str() + ": expected '" + std::string(1,c) + "' at offset " + std::to_string((long long)pos));
+    }
+
+    std::string parseString()
+    {
+      expect('"');
+      std::string s;
+      while (pos < str.size() && str[pos] != '"') {
+        if (str[pos] == '\\') pos++;
+        if (pos < str.size()) s += str[pos++];
+      }
+      expect('"');
+      return s;
+    }
+
+    void parseValue(const std::string& path, std::map<std::string,double>& numbers)
+    {
+      const char c = peek();
+      if (consume('{'))
+      {
+        if (consume('}')) return;
+        do {
+          const std::string key = parseString();
+          expect(':');
+          parseValue(path == "" ? key : path + "/" + key, numbers);
+        } while (consume(','));
+        expect('}');
+      }
+      else if (consume('['))
+      {
+        if (consume(']')) return;
+        size_t i = 0;
+        do parseValue(path + "/" + std::to_string((long long)i++), numbers);
+        while (consume(','));
+        expect(']');
+      }
+      else if (c == '"')
+        parseString();
+      else if (isalpha(c)) { // true, false, null
+        while (pos < str.size() && isalpha(str[pos])) pos++;
+      }
+      else
+      {
+        const char* begin = str.c_str()+pos;
+        char* end = nullptr;
+        const double value = strtod(begin,&end);
+        if (end == begin) THROW_RUNTIME_ERROR(fileName.str() + ": invalid number at offset " + std::to_string((long long)pos));
+        pos += end-begin;
+        numbers[path] = value;
+      }
+    }
+
+  private:
+    FileName fileName;
+    std::string str;
+    size_t pos;
+  };
+
+  /////////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////////
+  /////////////////////////////////////////////////////////////////////////////////
+
   VerifyApplication::VerifyApplication ()
     : Application(Application::FEATURE_RTCORE), 
       intensity(1.0f), 
@@ -4153,6 +4860,11 @@ namespace embree
       usecolors(true)
   {
     rtcore = ""; // do not start threads nor set affinty for normal tests 
+
+    /* default tolerances of the benchmark suite, build times are most noisy */
+    suite_thresholds["build_time"] = 0.10f;
+    suite_thresholds["memory"] = 0.02f;
+    suite_thresholds["rays"] = 0.05f;
     device = rtcNewDevice(rtcore.c_str());
 
 #if defined(__WIN32__)
@@ -4292,6 +5004,43 @@ namespace embree
       for (auto sflags : sceneFlags) 
         groups.top()->add(new BuildTest(to_string(sflags),isa,sflags,RTC_BUILD_QUALITY_MEDIUM));
       groups.pop();
+
+      push(new TestGroup("compact_scene",true,true));
+      for (auto sflags : sceneFlags) {
+        groups.top()->add(new CompactSceneTest(to_string(sflags),isa,sflags,RTC_BUILD_QUALITY_MEDIUM,"default"));
+        groups.top()->add(new CompactSceneTest(to_string(sflags)+"_treelets",isa,sflags,RTC_BUILD_QUALITY_MEDIUM,"treelets"));
+      }
+      groups.top()->add(new InvalidBVHLayoutTest("invalid_layout",isa));
+      groups.pop();
+
+      push(new TestGroup("compact_vertices",true,true));
+      groups.top()->add(new CompactMeshTest("triangles_half3",isa,RTC_GEOMETRY_TYPE_TRIANGLE,RTC_FORMAT_HALF3,RTC_FORMAT_UINT3));
+      groups.top()->add(new CompactMeshTest("triangles_ushort3",isa,RTC_GEOMETRY_TYPE_TRIANGLE,RTC_FORMAT_USHORT3,RTC_FORMAT_UINT3));
+      groups.top()->add(new CompactMeshTest("quads_half3",isa,RTC_GEOMETRY_TYPE_QUAD,RTC_FORMAT_HALF3,RTC_FORMAT_UINT4));
+      groups.top()->add(new CompactMeshTest("quads_ushort3",isa,RTC_GEOMETRY_TYPE_QUAD,RTC_FORMAT_USHORT3,RTC_FORMAT_UINT4));
+      groups.pop();
+
+      push(new TestGroup("memory_budget",true,true));
+      groups.top()->add(new MemoryBudgetTest("medium_quality",isa,RTC_BUILD_QUALITY_MEDIUM));
+      groups.top()->add(new MemoryBudgetTest("high_quality",isa,RTC_BUILD_QUALITY_HIGH));
+      groups.pop();
+
+      push(new TestGroup("page_policy",true,false));
+      groups.top()->add(new PagePolicyTest("default",isa,""));
+      groups.top()->add(new PagePolicyTest("no_hugepages",isa,"hugepages=0,transparent_hugepages=0"));
+      groups.top()->add(new PagePolicyTest("prefault_interleave",isa,"prefault_pages=1,interleave_pages=1"));
+      groups.top()->add(new PagePolicyTest("all",isa,"hugepages=1,transparent_hugepages=1,prefault_pages=1,interleave_pages=1"));
+      groups.pop();
+
+      push(new TestGroup("compact_indices",true,true));
+      for (auto sflags : { RTC_SCENE_FLAG_NONE, RTC_SCENE_FLAG_COMPACT }) {
+        const std::string leaves = sflags == RTC_SCENE_FLAG_COMPACT ? "_indexed_leaves" : "";
+        groups.top()->add(new CompactMeshTest("triangles_ushort3"+leaves,isa,RTC_GEOMETRY_TYPE_TRIANGLE,RTC_FORMAT_FLOAT3,RTC_FORMAT_USHORT3,sflags));
+        groups.top()->add(new CompactMeshTest("triangles_uchar3"+leaves,isa,RTC_GEOMETRY_TYPE_TRIANGLE,RTC_FORMAT_FLOAT3,RTC_FORMAT_UCHAR3,sflags));
+        groups.top()->add(new CompactMeshTest("quads_ushort4"+leaves,isa,RTC_GEOMETRY_TYPE_QUAD,RTC_FORMAT_FLOAT3,RTC_FORMAT_USHORT4,sflags));
+        groups.top()->add(new CompactMeshTest("quads_uchar4"+leaves,isa,RTC_GEOMETRY_TYPE_QUAD,RTC_FORMAT_FLOAT3,RTC_FORMAT_UCHAR4,sflags));
+      }
+      groups.pop();
       
       push(new TestGroup("overlapping_primitives",true,false));
       for (auto sflags : sceneFlags)
@@ -4675,6 +5424,35 @@ namespace embree
 
       groups.pop(); // embree_reported_memory
 
+      /**************************************************************************/
+      /*                          Benchmark Suite                               */
+      /**************************************************************************/
+
+      push(new TestGroup("benchmark_suite",false,false));
+
+      /* manifest of procedurally generated scenes */
+      GeometryType suite_gtypes[] = { 
+        TRIANGLE_MESH, 
+        TRIANGLE_MESH_MB, 
+        QUAD_MESH, 
+        GRID_MESH, 
+        SUBDIV_MESH, 
+        HAIR_GEOMETRY,
+        CURVE_GEOMETRY,
+        LINE_GEOMETRY
+      };
+
+      std::vector<std::pair<SceneFlags,RTCBuildQuality>> suite_sflags_quality;
+      suite_sflags_quality.push_back(std::make_pair(SceneFlags(RTC_SCENE_FLAG_DYNAMIC,RTC_BUILD_QUALITY_LOW),RTC_BUILD_QUALITY_LOW));
+      suite_sflags_quality.push_back(std::make_pair(SceneFlags(RTC_SCENE_FLAG_NONE,   RTC_BUILD_QUALITY_MEDIUM),RTC_BUILD_QUALITY_MEDIUM));
+      suite_sflags_quality.push_back(std::make_pair(SceneFlags(RTC_SCENE_FLAG_NONE,   RTC_BUILD_QUALITY_HIGH),RTC_BUILD_QUALITY_HIGH));
+
+      for (auto gtype : suite_gtypes)
+        for (auto sflags : suite_sflags_quality)
+          groups.top()->add(new BenchmarkSuiteTest(to_string(gtype)+"_100k."+to_string(sflags.first),isa,gtype,sflags.first,sflags.second,100000));
+
+      groups.pop(); // benchmark_suite
+
       groups.pop(); // isa
     }
 
@@ -4763,6 +5541,19 @@ namespace embree
       }, "--benchmark-tolerance: maximum relative slowdown to let a test pass");
     registerOptionAlias("benchmark-tolerance","tolerance");
 
+    registerOption("suite-json", [this] (Ref<ParseStream> cin, const FileName& path) {
+        suite_json = cin->getString();
+      }, "--suite-json <file>: writes the measurements of the benchmark suite to a JSON file");
+
+    registerOption("suite-baseline", [this] (Ref<ParseStream> cin, const FileName& path) {
+        suite_baseline = JSONNumberReader(cin->getString()).parse();
+      }, "--suite-baseline <file>: compares the benchmark suite against a JSON file written with --suite-json");
+
+    registerOption("suite-threshold", [this] (Ref<ParseStream> cin, const FileName& path) {
+        std::string metric = cin->getString();
+        suite_thresholds[metric] = cin->getFloat();
+      }, "--suite-threshold <metric> <float>: maximal relative regression of all benchmark suite metrics starting with the given name (build_time, memory, rays, rays.incoherent, ...)");
+
     registerOption("print-tests", [this] (Ref<ParseStream> cin, const FileName& path) {
         print_tests(tests,0);
         exit(1);
@@ -4909,6 +5700,51 @@ namespace embree
    return N;
   }
 
+  float VerifyApplication::getSuiteThreshold(const std::string& metric) const
+  {
+    /* the longest matching metric name prefix wins */
+    float threshold = benchmark_tolerance;
+    size_t length = 0;
+    for (auto& t : suite_thresholds) {
+      if (metric.compare(0,t.first.size(),t.first) != 0 || t.first.size() < length) continue;
+      threshold = t.second;
+      length = t.first.size();
+    }
+    return threshold;
+  }
+
+  void VerifyApplication::writeSuiteResults(const FileName& fileName)
+  {
+    std::fstream json;
+    json.open(fileName, std::fstream::out | std::fstream::trunc);
+    if (!json.is_open()) THROW_RUNTIME_ERROR("cannot open file " + fileName.str());
+    json << std::setprecision(9);
+    json << "{" << std::endl;
+    json << "  \"hash\": \"" << readHash() << "\"," << std::endl;
+    json << "  \"benchmarks\": {" << std::endl;
+    for (size_t i=0; i<suite_results.size(); i++)
+    {
+      const SuiteResult& result = suite_results[i];
+      json << "    \"" << result.name << "\": {" << std::endl;
+      json << "      \"primitives\": " << result.numPrimitives;
+      for (auto& metric : result.metrics)
+      {
+        const Statistics& stat = metric.stat;
+        json << "," << std::endl << "      \"" << metric.name << "\": { ";
+        json << "\"unit\": \"" << metric.unit << "\", ";
+        json << "\"avg\": " << stat.getAvg() << ", ";
+        json << "\"min\": " << stat.getMin() << ", ";
+        json << "\"max\": " << stat.getMax() << ", ";
+        json << "\"sigma\": " << stat.getSigma() << ", ";
+        json << "\"variance\": " << sqr(stat.getSigma()) << " }";
+      }
+      json << std::endl << "    }" << (i+1 < suite_results.size() ? "," : "") << std::endl;
+    }
+    json << "  }" << std::endl;
+    json << "}" << std::endl;
+    json.close();
+  }
+
   template<typename Closure>
   void VerifyApplication::plot(std::vector<Ref<Benchmark>> benchmarks, const FileName outFileName, std::string xlabel, size_t startN, size_t endN, float f, size_t dn, const Closure& test)
   {
@@ -4960,6 +5796,10 @@ namespace embree
     /* run all enabled tests */
     tests->execute(this,false);
 
+    /* write results of benchmark suite */
+    if (suite_json.str() != "")
+      writeSuiteResults(suite_json);
+
     /* print result */
     std::cout << std::endl;
     std::cout << std::setw(TEXT_ALIGN) << "Tests passed" << ": " << numPassedTests << std::endl; 
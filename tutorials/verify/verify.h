@@ -131,6 +131,31 @@ namespace embree
       std::vector<Ref<Test>> tests;
     };
 
+    /*! single measurement of a benchmark suite test */
+    struct SuiteMetric
+    {
+      SuiteMetric (const std::string& name, const std::string& unit, bool higher_is_better, const Statistics& stat)
+        : name(name), unit(unit), higher_is_better(higher_is_better), stat(stat) {}
+
+    public:
+      std::string name;
+      std::string unit;
+      bool higher_is_better;
+      Statistics stat;
+    };
+
+    /*! all measurements of a benchmark suite test, written to the JSON file */
+    struct SuiteResult
+    {
+      SuiteResult (const std::string& name, size_t numPrimitives)
+        : name(name), numPrimitives(numPrimitives) {}
+
+    public:
+      std::string name;
+      size_t numPrimitives;
+      std::vector<SuiteMetric> metrics;
+    };
+
     struct IntersectTest : public Test
     {
       IntersectTest (std::string name, int isa, IntersectMode imode, IntersectVariant ivariant, TestType ty = TEST_SHOULD_PASS)
@@ -155,6 +180,8 @@ namespace embree
      template<typename Closure>
        void plot(std::vector<Ref<Benchmark>> benchmarks, const FileName outFileName, std::string xlabel, size_t startN, size_t endN, float f, size_t dn, const Closure& test);
     FileName parse_benchmark_list(Ref<ParseStream> cin, std::vector<Ref<Benchmark>>& benchmarks);
+    float getSuiteThreshold(const std::string& metric) const;
+    void writeSuiteResults(const FileName& fileName);
     int main(int argc, char** argv);
     
   public:
@@ -184,6 +211,13 @@ namespace embree
     bool update_database;
     float benchmark_tolerance;
 
+    /* benchmark suite */
+  public:
+    FileName suite_json;                          //!< file the results of the benchmark suite get written to
+    std::map<std::string,double> suite_baseline;  //!< numbers of the baseline JSON file, keyed by their path
+    std::map<std::string,float> suite_thresholds; //!< maximal relative regression per metric name prefix
+    std::vector<SuiteResult> suite_results;
+
     /* sets terminal colors */
   public:
     std::string green(std::string str) {